@@ -15,4 +15,19 @@ function(arquebus_setup_dependencies)
     cpmaddpackage("gh:catchorg/Catch2@3.9.1")
   endif()
 
+  if(NOT TARGET benchmark::benchmark)
+    cpmaddpackage(
+      NAME
+      benchmark
+      GITHUB_REPOSITORY
+      google/benchmark
+      VERSION
+      1.9.4
+      OPTIONS
+      "BENCHMARK_ENABLE_TESTING OFF"
+      "BENCHMARK_ENABLE_INSTALL OFF"
+      "BENCHMARK_ENABLE_GTEST_TESTS OFF"
+      "BENCHMARK_INSTALL_DOCS OFF")
+  endif()
+
 endfunction()
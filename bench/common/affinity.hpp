@@ -0,0 +1,18 @@
+#pragma once
+
+#include <sched.h>
+
+namespace arquebus::bench {
+
+  /// Pin the calling thread (or process, when called before any threads are started) to a single CPU.
+  ///
+  /// @return false if the CPU does not exist or we are not allowed to run on it
+  inline auto pin_to_cpu(unsigned cpu) noexcept -> bool
+  {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return ::sched_setaffinity(0, sizeof(set), &set) == 0;
+  }
+
+}  // namespace arquebus::bench
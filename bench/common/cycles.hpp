@@ -0,0 +1,17 @@
+#pragma once
+
+#include "arquebus/impl/cycle_counter.hpp"
+
+#include <cstdint>
+
+namespace arquebus::bench {
+
+  /// Read the CPU's free running cycle counter.
+  ///
+  /// On x86 this is the TSC, which counts reference cycles at a constant rate rather than core clock cycles,
+  /// so it will under report when the core is boosting. On AArch64 it is the virtual counter, which runs at a
+  /// much lower fixed frequency. Elsewhere it falls back to nanoseconds. It is only intended to be used for
+  /// comparing runs on the same machine.
+  inline auto read_cycle_counter() noexcept -> std::uint64_t { return impl::read_cycle_counter(); }
+
+}  // namespace arquebus::bench
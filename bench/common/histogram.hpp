@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace arquebus::bench {
+
+  /// A fixed precision latency histogram in the style of HdrHistogram.
+  ///
+  /// Values below 2^SubBucketBits are recorded exactly. Above that, every power of two range is split into
+  /// 2^(SubBucketBits - 1) linear buckets, so a recorded value is never more than 1 / 2^(SubBucketBits - 1)
+  /// away from the true value. Recording is a couple of shifts and an increment, so it is cheap enough to
+  /// use inside the measured loop.
+  ///
+  /// @tparam SubBucketBits The precision of the histogram, 7 bits gives better than 2% precision
+  template<unsigned SubBucketBits = 7>
+  class histogram
+  {
+  public:
+    static_assert(SubBucketBits >= 2 and SubBucketBits < 32, "Unsupported precision");
+
+    static constexpr std::uint64_t SubBucketCount = std::uint64_t{ 1 } << SubBucketBits;
+    static constexpr std::uint64_t HalfSubBucketCount = SubBucketCount / 2;
+    static constexpr std::size_t BucketCount =
+      ((std::numeric_limits<std::uint64_t>::digits - SubBucketBits + 1) * HalfSubBucketCount) + HalfSubBucketCount;
+
+    histogram()
+      : m_counts(BucketCount, 0)
+    {}
+
+    void record(std::uint64_t value) noexcept
+    {
+      ++m_counts[index_of(value)];
+      ++m_total;
+      m_min = std::min(m_min, value);
+      m_max = std::max(m_max, value);
+      m_sum += value;
+    }
+
+    void reset() noexcept
+    {
+      std::ranges::fill(m_counts, 0);
+      m_total = 0;
+      m_min = std::numeric_limits<std::uint64_t>::max();
+      m_max = 0;
+      m_sum = 0;
+    }
+
+    [[nodiscard]] auto count() const noexcept -> std::uint64_t { return m_total; }
+    [[nodiscard]] auto min() const noexcept -> std::uint64_t { return m_total == 0 ? 0 : m_min; }
+    [[nodiscard]] auto max() const noexcept -> std::uint64_t { return m_max; }
+
+    [[nodiscard]] auto mean() const noexcept -> double
+    {
+      return m_total == 0 ? 0.0 : static_cast<double>(m_sum) / static_cast<double>(m_total);
+    }
+
+    /// The value that the given percentage of recorded values are less than or equal to.
+    ///
+    /// Like HdrHistogram, this reports the highest value that is equivalent to the bucket the percentile
+    /// lands in, clamped to the largest value recorded.
+    ///
+    /// @param percentile The percentile to report, 0.0 to 100.0
+    [[nodiscard]] auto value_at_percentile(double percentile) const noexcept -> std::uint64_t
+    {
+      if (m_total == 0) {
+        return 0;
+      }
+
+      auto const clamped = std::clamp(percentile, 0.0, 100.0);
+      // NOLINTNEXTLINE(*-magic-numbers)
+      auto target = static_cast<std::uint64_t>((clamped / 100.0) * static_cast<double>(m_total) + 0.5);
+      target = std::clamp<std::uint64_t>(target, 1, m_total);
+
+      std::uint64_t seen = 0;
+      for (std::size_t i = 0; i < m_counts.size(); ++i) {
+        seen += m_counts[i];
+        if (seen >= target) {
+          return std::min(highest_equivalent(i), m_max);
+        }
+      }
+      return m_max;
+    }
+
+  private:
+    std::vector<std::uint64_t> m_counts;
+    std::uint64_t m_total{ 0 };
+    std::uint64_t m_min{ std::numeric_limits<std::uint64_t>::max() };
+    std::uint64_t m_max{ 0 };
+    std::uint64_t m_sum{ 0 };
+
+    [[nodiscard]] static constexpr auto index_of(std::uint64_t value) noexcept -> std::size_t
+    {
+      if (value < SubBucketCount) {
+        return value;
+      }
+
+      // the top SubBucketBits of the value select the linear bucket within its power of two range
+      auto const shift = static_cast<unsigned>(std::bit_width(value)) - SubBucketBits;
+      return (shift * HalfSubBucketCount) + (value >> shift);
+    }
+
+    [[nodiscard]] static constexpr auto highest_equivalent(std::size_t index) noexcept -> std::uint64_t
+    {
+      if (index < SubBucketCount) {
+        return index;
+      }
+
+      auto const shift = (index / HalfSubBucketCount) - 1;
+      auto const subBucket = index - (shift * HalfSubBucketCount);
+      return ((std::uint64_t{ subBucket } + 1) << shift) - 1;
+    }
+  };
+
+}  // namespace arquebus::bench
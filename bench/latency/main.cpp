@@ -0,0 +1,237 @@
+#include "common/affinity.hpp"
+#include "common/histogram.hpp"
+
+#include <arquebus/spsc/var_msg/consumer.hpp>
+#include <arquebus/spsc/var_msg/host.hpp>
+#include <arquebus/spsc/var_msg/producer.hpp>
+#include <arquebus/version.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fmt/core.h>
+#include <span>
+#include <string_view>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Measures the latency of a message passing between two processes.
+//
+// The parent process sends a ping over one SPSC queue, the child process echoes it back over a second
+// queue, adding the time it received the ping. Only one message is in flight at a time. Each process is
+// pinned to its own CPU, so the numbers reflect the cost of the queue and the cache line transfers between
+// the cores rather than the scheduler.
+//
+// Both timestamps come from std::chrono::steady_clock, which is CLOCK_MONOTONIC on Linux and is shared
+// by every process on the machine, so the one-way latency can be taken across the process boundary.
+
+namespace {
+
+  constexpr auto QueueSizeBits = 16u;
+  constexpr auto BatchReserve = 1024u;
+  constexpr auto DefaultMessages = 1'000'000u;
+  constexpr auto DefaultMessageSize = 32u;
+  constexpr auto DefaultPingCpu = 0u;
+  constexpr auto DefaultPongCpu = 1u;
+  constexpr auto MaxWarmupMessages = 10'000u;
+  constexpr auto Percentiles = std::array{ 50.0, 99.0, 99.9, 99.99 };
+
+  constexpr std::string_view PingQueueName{ "latency_ping" };
+  constexpr std::string_view PongQueueName{ "latency_pong" };
+
+  using Clock = std::chrono::steady_clock;
+  using HostType = arquebus::spsc::var_msg::host<QueueSizeBits>;
+  using ProducerType = arquebus::spsc::var_msg::producer<QueueSizeBits, BatchReserve>;
+  using ConsumerType = arquebus::spsc::var_msg::consumer<QueueSizeBits>;
+  using Histogram = arquebus::bench::histogram<>;
+
+  // the start of every message, the rest of the message is padding to the requested size
+  struct timestamps
+  {
+    std::int64_t sent;
+    std::int64_t received;
+  };
+
+  auto now() noexcept -> std::int64_t
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+  }
+
+  void send(ProducerType &producer, timestamps const &stamps, unsigned messageSize)
+  {
+    auto buffer = producer.allocate_write(messageSize);
+    std::memcpy(buffer.data(), &stamps, sizeof(stamps));
+    producer.flush();
+  }
+
+  auto receive(ConsumerType &consumer) -> timestamps
+  {
+    auto message = consumer.read();
+    while (not message.has_value()) {
+      message = consumer.read();
+    }
+
+    timestamps stamps{};
+    std::memcpy(&stamps, message->data(), sizeof(stamps));
+    return stamps;
+  }
+
+  // the child process, echo every ping back with the time we received it
+  auto run_pong(unsigned cpu, unsigned messages, unsigned messageSize) -> int
+  {
+    try {
+      if (not arquebus::bench::pin_to_cpu(cpu)) {
+        fmt::println("warning: unable to pin pong process to cpu {}", cpu);
+      }
+
+      ConsumerType ping{ PingQueueName };
+      ProducerType pong{ PongQueueName };
+      ping.attach();
+      pong.attach();
+
+      for (unsigned i = 0; i < messages; ++i) {
+        auto stamps = receive(ping);
+        stamps.received = now();
+        send(pong, stamps, messageSize);
+      }
+      return 0;
+    } catch (std::exception const &e) {
+      fmt::println("pong error: {}", e.what());
+      return 1;
+    }
+  }
+
+  struct run_result
+  {
+    Histogram oneWay;
+    Histogram roundTrip;
+  };
+
+  // messages sent before recording starts, to fault in the queues and warm the caches and branch predictors
+  auto warmup_messages(unsigned messages) noexcept -> unsigned { return std::min(MaxWarmupMessages, messages / 10); }
+
+  void run_ping(unsigned cpu, unsigned messages, unsigned messageSize, run_result &result)
+  {
+    if (not arquebus::bench::pin_to_cpu(cpu)) {
+      fmt::println("warning: unable to pin ping process to cpu {}", cpu);
+    }
+
+    ProducerType ping{ PingQueueName };
+    ConsumerType pong{ PongQueueName };
+    ping.attach();
+    pong.attach();
+
+    auto const warmup = warmup_messages(messages);
+    for (unsigned i = 0; i < warmup + messages; ++i) {
+      auto const sent = now();
+      send(ping, { .sent = sent, .received = 0 }, messageSize);
+      auto const stamps = receive(pong);
+      auto const returned = now();
+
+      if (i >= warmup) {
+        result.oneWay.record(static_cast<std::uint64_t>(stamps.received - stamps.sent));
+        result.roundTrip.record(static_cast<std::uint64_t>(returned - stamps.sent));
+      }
+    }
+  }
+
+  void print_row(std::string_view label, Histogram const &histogram)
+  {
+    fmt::print("{:>12} {:>10} {:>10.1f}", label, histogram.min(), histogram.mean());
+    for (auto percentile : Percentiles) {
+      fmt::print(" {:>10}", histogram.value_at_percentile(percentile));
+    }
+    fmt::println(" {:>10}", histogram.max());
+  }
+
+  auto parse_arg(char const *arg, unsigned defaultValue) -> unsigned
+  {
+    std::string_view const text{ arg };
+    unsigned value{ defaultValue };
+    // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic)
+    if (std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc{}) {
+      return defaultValue;
+    }
+    return value;
+  }
+
+}  // namespace
+
+// usage: latency [messages] [message size] [ping cpu] [pong cpu]
+auto main(int argc, char const *argv[]) -> int
+{
+  try {
+    std::span const args{ argv, static_cast<std::size_t>(argc) };
+    auto const messages = args.size() > 1 ? parse_arg(args[1], DefaultMessages) : DefaultMessages;
+    auto const messageSize = std::max<unsigned>(
+      args.size() > 2 ? parse_arg(args[2], DefaultMessageSize) : DefaultMessageSize, sizeof(timestamps)
+    );
+    // a message must fit in one batch reservation
+    if (messageSize >= BatchReserve) {
+      fmt::println(
+        "usage: latency [messages] [message size {} to {}] [ping cpu] [pong cpu]", sizeof(timestamps), BatchReserve - 1
+      );
+      return 1;
+    }
+    auto const pingCpu = args.size() > 3 ? parse_arg(args[3], DefaultPingCpu) : DefaultPingCpu;
+    auto const pongCpu = args.size() > 4 ? parse_arg(args[4], DefaultPongCpu) : DefaultPongCpu;
+
+    auto ver = arquebus::version();
+    fmt::println("arquebus version: {} #{}", ver.version_string, ver.commit_short_hash);
+    fmt::println(
+      "spsc ping-pong latency: queue 2^{} bytes, {} messages, {} byte messages, cpus {} and {}",
+      QueueSizeBits,
+      messages,
+      messageSize,
+      pingCpu,
+      pongCpu
+    );
+
+    HostType pingHost{ PingQueueName };
+    HostType pongHost{ PongQueueName };
+    pingHost.create(arquebus::danger_delete_existing_shared_memory_segment_tag{});
+    pongHost.create(arquebus::danger_delete_existing_shared_memory_segment_tag{});
+
+    auto const child = fork();
+    if (child < 0) {
+      fmt::println("error: unable to fork pong process");
+      return 1;
+    }
+    if (child == 0) {
+      _exit(run_pong(pongCpu, warmup_messages(messages) + messages, messageSize));
+    }
+
+    run_result result;
+    run_ping(pingCpu, messages, messageSize, result);
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (not WIFEXITED(status) or WEXITSTATUS(status) != 0) {
+      fmt::println("error: pong process failed");
+      return 1;
+    }
+
+    fmt::println(
+      "{:>12} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}",
+      "ns",
+      "min",
+      "mean",
+      "p50",
+      "p99",
+      "p99.9",
+      "p99.99",
+      "max"
+    );
+    print_row("one-way", result.oneWay);
+    print_row("round-trip", result.roundTrip);
+
+    return 0;
+  } catch (std::exception const &e) {
+    fmt::println("error: {}", e.what());
+    return 1;
+  }
+}
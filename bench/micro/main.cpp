@@ -0,0 +1,339 @@
+#include "common/affinity.hpp"
+#include "common/cycles.hpp"
+
+#include <arquebus/ready_set.hpp>
+#include <arquebus/spsc/var_msg/consumer.hpp>
+#include <arquebus/spsc/var_msg/host.hpp>
+#include <arquebus/spsc/var_msg/poller.hpp>
+#include <arquebus/spsc/var_msg/producer.hpp>
+
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Micro benchmarks of the SPSC var_msg hot paths.
+//
+// Each benchmark reports the time per call and a "cycles" counter, the cycle counter delta per call (see
+// read_cycle_counter() for what a cycle means on each platform). The single core benchmarks run with the
+// queue entirely in the local cache. The two core benchmarks have a second thread on another CPU touching
+// the shared index cache lines, which is what the hot paths cost in a real deployment.
+//
+// reserve() and update_cached_indices() are private, so they are measured through the public calls that
+// are forced to take them on every (or nearly every) call.
+
+namespace {
+
+  constexpr unsigned MainCpu = 0;
+  constexpr unsigned OtherCpu = 1;
+  constexpr std::uint32_t MessageSize = 32;
+
+  void set_cycle_counter(benchmark::State &state, std::uint64_t cycles, std::int64_t calls)
+  {
+    state.counters["cycles"] = benchmark::Counter(
+      static_cast<double>(cycles) / static_cast<double>(calls)
+    );
+  }
+
+  template<std::uint8_t Size2NBits, std::size_t BatchReserve>
+  struct queue
+  {
+    using HostType = arquebus::spsc::var_msg::host<Size2NBits>;
+    using ProducerType = arquebus::spsc::var_msg::producer<Size2NBits, BatchReserve>;
+    using ConsumerType = arquebus::spsc::var_msg::consumer<Size2NBits>;
+
+    explicit queue(std::string_view name)
+      : host(name)
+      , producer(name)
+      , consumer(name)
+    {
+      host.create(arquebus::danger_delete_existing_shared_memory_segment_tag{});
+      producer.attach();
+      consumer.attach();
+    }
+
+    HostType host;
+    ProducerType producer;
+    ConsumerType consumer;
+  };
+
+  // allocate_write() when the batch reservation covers the message, the common case
+  void allocate_write(benchmark::State &state)
+  {
+    arquebus::bench::pin_to_cpu(MainCpu);
+    queue<20, 65536> q{ "micro_allocate_write" };
+
+    auto const start = arquebus::bench::read_cycle_counter();
+    for (auto _ : state) {
+      auto buffer = q.producer.allocate_write(MessageSize);
+      benchmark::DoNotOptimize(buffer.data());
+    }
+    set_cycle_counter(state, arquebus::bench::read_cycle_counter() - start, state.iterations());
+  }
+  BENCHMARK(allocate_write);
+
+  // allocate_write() with a reservation that only covers one message, so reserve() is taken almost every call
+  void reserve(benchmark::State &state)
+  {
+    arquebus::bench::pin_to_cpu(MainCpu);
+    queue<20, 64> q{ "micro_reserve" };
+
+    auto const start = arquebus::bench::read_cycle_counter();
+    for (auto _ : state) {
+      auto buffer = q.producer.allocate_write(60);
+      benchmark::DoNotOptimize(buffer.data());
+    }
+    set_cycle_counter(state, arquebus::bench::read_cycle_counter() - start, state.iterations());
+  }
+  BENCHMARK(reserve);
+
+  // allocate_write() with messages that are a large part of a small queue, so reserve() writes a skip and
+  // wraps around the end of the queue every few calls
+  void reserve_wrap(benchmark::State &state)
+  {
+    arquebus::bench::pin_to_cpu(MainCpu);
+    queue<12, 1024> q{ "micro_reserve_wrap" };
+
+    auto const start = arquebus::bench::read_cycle_counter();
+    for (auto _ : state) {
+      auto buffer = q.producer.allocate_write(1000);
+      benchmark::DoNotOptimize(buffer.data());
+    }
+    set_cycle_counter(state, arquebus::bench::read_cycle_counter() - start, state.iterations());
+  }
+  BENCHMARK(reserve_wrap);
+
+  void flush(benchmark::State &state)
+  {
+    arquebus::bench::pin_to_cpu(MainCpu);
+    queue<20, 65536> q{ "micro_flush" };
+
+    auto const start = arquebus::bench::read_cycle_counter();
+    for (auto _ : state) {
+      q.producer.flush();
+      benchmark::ClobberMemory();
+    }
+    set_cycle_counter(state, arquebus::bench::read_cycle_counter() - start, state.iterations());
+  }
+  BENCHMARK(flush);
+
+  // read() of messages already in the queue. The queue is refilled outside of the timed region, every
+  // iteration reads one batch of messages.
+  void read(benchmark::State &state)
+  {
+    constexpr std::int64_t MessagesPerBatch = 1024;
+
+    arquebus::bench::pin_to_cpu(MainCpu);
+    queue<20, 65536> q{ "micro_read" };
+
+    std::uint64_t cycles = 0;
+    for (auto _ : state) {
+      state.PauseTiming();
+      for (std::int64_t i = 0; i < MessagesPerBatch; ++i) {
+        auto buffer = q.producer.allocate_write(MessageSize);
+        std::memcpy(buffer.data(), &i, sizeof(i));
+      }
+      q.producer.flush();
+      state.ResumeTiming();
+
+      auto const start = arquebus::bench::read_cycle_counter();
+      for (std::int64_t i = 0; i < MessagesPerBatch; ++i) {
+        auto message = q.consumer.read();
+        benchmark::DoNotOptimize(message);
+      }
+      cycles += arquebus::bench::read_cycle_counter() - start;
+    }
+    state.SetItemsProcessed(state.iterations() * MessagesPerBatch);
+    set_cycle_counter(state, cycles, state.iterations() * MessagesPerBatch);
+  }
+  BENCHMARK(read);
+
+
+  // The same batch as read, drained with one index load
+  void for_each_available(benchmark::State &state)
+  {
+    constexpr std::int64_t MessagesPerBatch = 1024;
+
+    arquebus::bench::pin_to_cpu(MainCpu);
+    queue<20, 65536> q{ "micro_for_each_available" };
+
+    std::uint64_t cycles = 0;
+    for (auto _ : state) {
+      state.PauseTiming();
+      for (std::int64_t i = 0; i < MessagesPerBatch; ++i) {
+        auto buffer = q.producer.allocate_write(MessageSize);
+        std::memcpy(buffer.data(), &i, sizeof(i));
+      }
+      q.producer.flush();
+      state.ResumeTiming();
+
+      auto const start = arquebus::bench::read_cycle_counter();
+      auto const count = q.consumer.for_each_available([](std::span<std::byte const> message) {
+        benchmark::DoNotOptimize(message);
+      });
+      cycles += arquebus::bench::read_cycle_counter() - start;
+      benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * MessagesPerBatch);
+    set_cycle_counter(state, cycles, state.iterations() * MessagesPerBatch);
+  }
+  BENCHMARK(for_each_available);
+
+  // read() of an empty queue, every call goes through update_cached_indices()
+  void update_cached_indices(benchmark::State &state)
+  {
+    arquebus::bench::pin_to_cpu(MainCpu);
+    queue<20, 65536> q{ "micro_update_cached_indices" };
+
+    auto const start = arquebus::bench::read_cycle_counter();
+    for (auto _ : state) {
+      auto message = q.consumer.read();
+      benchmark::DoNotOptimize(message);
+    }
+    set_cycle_counter(state, arquebus::bench::read_cycle_counter() - start, state.iterations());
+  }
+  BENCHMARK(update_cached_indices);
+
+  // update_cached_indices() while the producer on another core keeps writing the shared index cache line,
+  // so most calls have to fetch the line from the other core.
+  void update_cached_indices_contended(benchmark::State &state)
+  {
+    if (std::thread::hardware_concurrency() < 2) {
+      state.SkipWithError("requires at least two cpus");
+      return;
+    }
+    arquebus::bench::pin_to_cpu(MainCpu);
+    queue<20, 65536> q{ "micro_update_cached_indices_contended" };
+
+    std::atomic_bool running{ true };
+    std::jthread other{ [&] {
+      arquebus::bench::pin_to_cpu(OtherCpu);
+      // flush without allocating, the index does not move so the consumer never sees a message
+      while (running.load(std::memory_order_relaxed)) {
+        q.producer.flush();
+      }
+    } };
+
+    auto const start = arquebus::bench::read_cycle_counter();
+    for (auto _ : state) {
+      auto message = q.consumer.read();
+      benchmark::DoNotOptimize(message);
+    }
+    set_cycle_counter(state, arquebus::bench::read_cycle_counter() - start, state.iterations());
+
+    running.store(false);
+  }
+  BENCHMARK(update_cached_indices_contended)->UseRealTime();
+
+  // allocate_write() + flush() on one core and read() on another, each iteration is one message through the
+  // queue. The queue is lossy, so the producer only runs a quarter of the queue ahead of the consumer.
+  void write_read_two_cores(benchmark::State &state)
+  {
+    if (std::thread::hardware_concurrency() < 2) {
+      state.SkipWithError("requires at least two cpus");
+      return;
+    }
+    constexpr std::uint64_t MaxAhead = (std::uint64_t{ 1 } << 20) / 4 / (MessageSize + sizeof(std::uint32_t));
+
+    arquebus::bench::pin_to_cpu(MainCpu);
+    queue<20, 65536> q{ "micro_write_read_two_cores" };
+
+    std::atomic_uint64_t consumed{ 0 };
+    std::atomic_bool running{ true };
+    std::jthread other{ [&] {
+      arquebus::bench::pin_to_cpu(OtherCpu);
+      std::uint64_t produced = 0;
+      while (running.load(std::memory_order_relaxed)) {
+        if (produced - consumed.load(std::memory_order_acquire) < MaxAhead) {
+          auto buffer = q.producer.allocate_write(MessageSize);
+          std::memcpy(buffer.data(), &produced, sizeof(produced));
+          q.producer.flush();
+          ++produced;
+        }
+      }
+    } };
+
+    std::uint64_t received = 0;
+    auto const start = arquebus::bench::read_cycle_counter();
+    for (auto _ : state) {
+      auto message = q.consumer.read();
+      while (not message.has_value()) {
+        message = q.consumer.read();
+      }
+      benchmark::DoNotOptimize(message);
+      // publishing progress is part of the cost of keeping the lossy queue from overrunning
+      if ((++received % 64) == 0) {
+        consumed.store(received, std::memory_order_release);
+      }
+    }
+    set_cycle_counter(state, arquebus::bench::read_cycle_counter() - start, state.iterations());
+
+    running.store(false);
+  }
+  BENCHMARK(write_read_two_cores)->UseRealTime();
+
+  // poll() of a poller draining state.range(0) queues, when only one of them has a message. With state.range(1)
+  // set the producers mark a ready set, so the sweep only reads the active queue, otherwise it checks every
+  // queue. Each iteration writes one message to the next queue in turn, the cycles are those of the sweep.
+  void poll_sweep(benchmark::State &state)
+  {
+    using Host = arquebus::spsc::var_msg::host<16>;
+    using Producer = arquebus::spsc::var_msg::producer<16, 1024>;
+    using Poller = arquebus::spsc::var_msg::poller<16>;
+
+    auto const queueCount = static_cast<std::size_t>(state.range(0));
+    auto const useReadySet = state.range(1) != 0;
+
+    arquebus::bench::pin_to_cpu(MainCpu);
+    arquebus::ready_set_host<> readySetHost{ "micro_poll_sweep_ready_set" };
+    readySetHost.create(arquebus::danger_delete_existing_shared_memory_segment_tag{});
+    arquebus::ready_set<> readySet{ "micro_poll_sweep_ready_set" };
+    readySet.attach();
+
+    auto poller = useReadySet ? std::make_unique<Poller>(readySet) : std::make_unique<Poller>();
+    std::vector<std::unique_ptr<Host>> hosts;
+    std::vector<std::unique_ptr<Producer>> producers;
+    for (std::size_t i = 0; i < queueCount; ++i) {
+      auto const name = "micro_poll_sweep_" + std::to_string(i);
+      hosts.push_back(std::make_unique<Host>(name));
+      hosts.back()->create(arquebus::danger_delete_existing_shared_memory_segment_tag{});
+      producers.push_back(std::make_unique<Producer>(name));
+      producers.back()->attach();
+      auto const slot = poller->add(name);
+      if (useReadySet) {
+        producers.back()->signal_ready(readySet, slot);
+      }
+    }
+    // the first sweep reads every queue
+    static_cast<void>(poller->poll([](std::size_t, std::span<std::byte const>) {}));
+
+    std::size_t next = 0;
+    std::uint64_t cycles = 0;
+    for (auto _ : state) {
+      auto &producer = *producers[next];
+      next = (next + 1) % queueCount;
+      auto buffer = producer.allocate_write(MessageSize);
+      benchmark::DoNotOptimize(buffer.data());
+      producer.flush();
+
+      auto const start = arquebus::bench::read_cycle_counter();
+      auto const count = poller->poll([](std::size_t slot, std::span<std::byte const> message) {
+        benchmark::DoNotOptimize(slot);
+        benchmark::DoNotOptimize(message);
+      });
+      cycles += arquebus::bench::read_cycle_counter() - start;
+      benchmark::DoNotOptimize(count);
+    }
+    set_cycle_counter(state, cycles, state.iterations());
+  }
+  BENCHMARK(poll_sweep)->ArgsProduct({ { 1, 4, 16, 40, 64 }, { 0, 1 } })->ArgNames({ "queues", "ready_set" });
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,164 @@
+#include <arquebus/mpsc/var_msg/consumer.hpp>
+#include <arquebus/mpsc/var_msg/host.hpp>
+#include <arquebus/mpsc/var_msg/producer.hpp>
+#include <arquebus/version.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fmt/core.h>
+#include <latch>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Measures the cost of the shared reservation index as the number of producers increases.
+//
+// Every producer thread attaches its own producer to the queue, exactly as a separate process would, and
+// writes a fixed number of messages as fast as it can. A single consumer thread drains the queue.
+
+namespace {
+
+  constexpr auto QueueSizeBits = 20u;
+  constexpr auto MaxProducers = 16u;
+  constexpr auto ProducerCounts = std::array{ 2u, 4u, 8u, 16u };
+  constexpr auto DefaultMessagesPerProducer = 1'000'000u;
+  constexpr auto DefaultMessageSize = 32u;
+
+  using Clock = std::chrono::steady_clock;
+  using HostType = arquebus::mpsc::var_msg::host<QueueSizeBits, MaxProducers>;
+  using ProducerType = arquebus::mpsc::var_msg::producer<QueueSizeBits, MaxProducers>;
+  using ConsumerType = arquebus::mpsc::var_msg::consumer<QueueSizeBits, MaxProducers>;
+
+  struct run_result
+  {
+    std::chrono::nanoseconds elapsed{};
+    std::chrono::nanoseconds slowestProducer{};
+    std::uint64_t messages{};
+  };
+
+  auto run(std::string_view name, unsigned producerCount, unsigned messagesPerProducer, unsigned messageSize)
+    -> run_result
+  {
+    HostType host{ name };
+    host.create(arquebus::danger_delete_existing_shared_memory_segment_tag{});
+
+    ConsumerType consumer{ name };
+    consumer.attach();
+
+    std::latch ready{ producerCount + 1 };
+    std::vector<std::chrono::nanoseconds> producerElapsed(producerCount);
+    std::vector<std::jthread> producers;
+    producers.reserve(producerCount);
+
+    for (unsigned p = 0; p < producerCount; ++p) {
+      producers.emplace_back([&, p] {
+        ProducerType producer{ name };
+        producer.attach();
+
+        ready.arrive_and_wait();
+        auto const start = Clock::now();
+        for (unsigned i = 0; i < messagesPerProducer; ++i) {
+          auto buffer = producer.allocate_write(messageSize);
+          // main() only passes sizes the producer accepts, this keeps the copy below in bounds regardless
+          if (buffer.size() < sizeof(i)) [[unlikely]] {
+            std::abort();
+          }
+          std::memcpy(buffer.data(), &i, sizeof(i));
+          producer.commit(buffer);
+        }
+        producerElapsed[p] = Clock::now() - start;
+      });
+    }
+
+    auto const expected = std::uint64_t{ producerCount } * messagesPerProducer;
+    std::uint64_t received = 0;
+
+    ready.arrive_and_wait();
+    auto const start = Clock::now();
+    while (received < expected) {
+      if (consumer.read().has_value()) {
+        ++received;
+      }
+    }
+    auto const elapsed = Clock::now() - start;
+
+    producers.clear();
+
+    return { .elapsed = elapsed,
+             .slowestProducer = *std::ranges::max_element(producerElapsed),
+             .messages = received };
+  }
+
+  auto parse_arg(char const *arg, unsigned defaultValue) -> unsigned
+  {
+    std::string_view const text{ arg };
+    unsigned value{ defaultValue };
+    // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic)
+    if (std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc{}) {
+      return defaultValue;
+    }
+    return value;
+  }
+
+}  // namespace
+
+// usage: mpsc_contention [messages per producer] [message size]
+auto main(int argc, char const *argv[]) -> int
+{
+  try {
+    std::span const args{ argv, static_cast<std::size_t>(argc) };
+    auto const messagesPerProducer = args.size() > 1 ? parse_arg(args[1], DefaultMessagesPerProducer)
+                                                     : DefaultMessagesPerProducer;
+    auto const messageSize = args.size() > 2 ? parse_arg(args[2], DefaultMessageSize) : DefaultMessageSize;
+    // every message carries its sequence number
+    if (messageSize < sizeof(unsigned) or messageSize > ProducerType::MaxMessageSize) {
+      fmt::println(
+        "usage: mpsc_contention [messages per producer] [message size {} to {}]",
+        sizeof(unsigned),
+        ProducerType::MaxMessageSize
+      );
+      return 1;
+    }
+
+    auto ver = arquebus::version();
+    fmt::println("arquebus version: {} #{}", ver.version_string, ver.commit_short_hash);
+    fmt::println(
+      "mpsc contention: queue 2^{} bytes, {} messages per producer, {} byte messages",
+      QueueSizeBits,
+      messagesPerProducer,
+      messageSize
+    );
+    fmt::println(
+      "{:>10} {:>12} {:>12} {:>14} {:>18}", "producers", "messages", "elapsed ms", "Mmsg/s", "ns/msg/producer"
+    );
+
+    for (auto producerCount : ProducerCounts) {
+      auto const result = run("mpsc_contention", producerCount, messagesPerProducer, messageSize);
+
+      auto const seconds = std::chrono::duration<double>(result.elapsed).count();
+      auto const perProducerNs =
+        static_cast<double>(result.slowestProducer.count()) / static_cast<double>(messagesPerProducer);
+
+      fmt::println(
+        "{:>10} {:>12} {:>12.1f} {:>14.2f} {:>18.1f}",
+        producerCount,
+        result.messages,
+        seconds * 1e3,                                            // NOLINT(*-magic-numbers)
+        static_cast<double>(result.messages) / seconds / 1e6,     // NOLINT(*-magic-numbers)
+        perProducerNs
+      );
+    }
+
+    return 0;
+  } catch (std::exception const &e) {
+    fmt::println("error: {}", e.what());
+    return 1;
+  }
+}
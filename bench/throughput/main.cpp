@@ -0,0 +1,446 @@
+#include "common/affinity.hpp"
+
+#include <arquebus/spsc/mirrored_msg/consumer.hpp>
+#include <arquebus/spsc/mirrored_msg/host.hpp>
+#include <arquebus/spsc/mirrored_msg/producer.hpp>
+#include <arquebus/spsc/var_msg/consumer.hpp>
+#include <arquebus/spsc/var_msg/host.hpp>
+#include <arquebus/spsc/var_msg/producer.hpp>
+#include <arquebus/version.hpp>
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fmt/core.h>
+#include <new>
+#include <random>
+#include <span>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+// Measures SPSC throughput across a process boundary for a range of queue template parameters, comparing the
+// var_msg layout (skip markers at the end of each lap) with the mirrored_msg layout (double mapped data).
+//
+// Each configuration is run with a fixed, a uniform and a bimodal message size distribution. The consumer
+// runs in a forked child process, and the results are reported from the consumer's point of view, from the
+// first message received to the last.
+//
+// The queue is lossy, so the producer is held back by a credit counter that the consumer publishes
+// through a separate shared mapping. The consumer only publishes every 1/16th of the queue, so the cost
+// of the flow control is small, but it is a cost real users of the queue pay in some form too.
+//
+// The output is CSV by default, or JSON, so runs can be compared and plotted.
+
+namespace {
+
+  constexpr auto DefaultMessages = 2'000'000u;
+  constexpr auto DefaultProducerCpu = 0u;
+  constexpr auto DefaultConsumerCpu = 1u;
+  constexpr auto SizeSequenceLength = 4096u;
+  constexpr auto SizeSequenceSeed = 42u;
+  constexpr auto MaxMessageSize = 1024u;
+
+  using Clock = std::chrono::steady_clock;
+
+  struct var_msg_layout
+  {
+    static constexpr std::string_view Name{ "var_msg" };
+
+    template<std::uint8_t Size2NBits, std::unsigned_integral TMessageSize>
+    using host = arquebus::spsc::var_msg::host<Size2NBits, TMessageSize>;
+    template<std::uint8_t Size2NBits, std::size_t BatchReserve, std::unsigned_integral TMessageSize>
+    using producer = arquebus::spsc::var_msg::producer<Size2NBits, BatchReserve, TMessageSize>;
+    template<std::uint8_t Size2NBits, std::unsigned_integral TMessageSize>
+    using consumer = arquebus::spsc::var_msg::consumer<Size2NBits, TMessageSize>;
+  };
+
+  struct mirrored_msg_layout
+  {
+    static constexpr std::string_view Name{ "mirrored_msg" };
+
+    template<std::uint8_t Size2NBits, std::unsigned_integral TMessageSize>
+    using host = arquebus::spsc::mirrored_msg::host<Size2NBits, TMessageSize>;
+    template<std::uint8_t Size2NBits, std::size_t BatchReserve, std::unsigned_integral TMessageSize>
+    using producer = arquebus::spsc::mirrored_msg::producer<Size2NBits, BatchReserve, TMessageSize>;
+    template<std::uint8_t Size2NBits, std::unsigned_integral TMessageSize>
+    using consumer = arquebus::spsc::mirrored_msg::consumer<Size2NBits, TMessageSize>;
+  };
+
+  template<
+    typename TLayout,
+    std::uint8_t Size2NBits,
+    std::size_t NBytesBatchMessageReserve,
+    std::unsigned_integral TMessageSize>
+  struct config
+  {
+    using Layout = TLayout;
+    static constexpr auto QueueSizeBits = Size2NBits;
+    static constexpr auto BatchReserve = NBytesBatchMessageReserve;
+    using MessageSize = TMessageSize;
+  };
+
+  // the configurations to sweep, add to this list to measure other combinations
+  using Configurations = std::tuple<
+    config<var_msg_layout, 16, 1024, std::uint32_t>,
+    config<var_msg_layout, 16, 4096, std::uint32_t>,
+    config<var_msg_layout, 20, 1024, std::uint32_t>,
+    config<var_msg_layout, 20, 16384, std::uint32_t>,
+    config<var_msg_layout, 20, 65536, std::uint32_t>,
+    config<var_msg_layout, 23, 65536, std::uint32_t>,
+    config<var_msg_layout, 23, 262144, std::uint32_t>,
+    config<var_msg_layout, 20, 16384, std::uint16_t>,
+    config<var_msg_layout, 20, 16384, std::uint64_t>,
+    config<mirrored_msg_layout, 16, 1024, std::uint32_t>,
+    config<mirrored_msg_layout, 16, 4096, std::uint32_t>,
+    config<mirrored_msg_layout, 20, 16384, std::uint32_t>,
+    config<mirrored_msg_layout, 23, 65536, std::uint32_t>>;
+
+  struct distribution
+  {
+    std::string_view name;
+    std::vector<std::uint32_t> sizes;
+  };
+
+  // The message sizes are generated up front, so the cost of the random number generation is not measured.
+  // The producer and consumer both cycle through the same sequence.
+  auto make_distributions() -> std::vector<distribution>
+  {
+    std::mt19937 generator{ SizeSequenceSeed };
+    std::uniform_int_distribution<std::uint32_t> uniform{ 16, 512 };
+    std::bernoulli_distribution isLarge{ 0.1 };
+
+    distribution fixed{ .name = "fixed", .sizes = {} };
+    distribution uniformSizes{ .name = "uniform", .sizes = {} };
+    distribution bimodal{ .name = "bimodal", .sizes = {} };
+
+    for (unsigned i = 0; i < SizeSequenceLength; ++i) {
+      fixed.sizes.push_back(64);
+      uniformSizes.sizes.push_back(uniform(generator));
+      // mostly small updates, with the occasional snapshot
+      bimodal.sizes.push_back(isLarge(generator) ? MaxMessageSize : 32);
+    }
+
+    return { fixed, uniformSizes, bimodal };
+  }
+
+  // Shared between the processes through an anonymous shared mapping made before the fork
+  struct control_block
+  {
+    alignas(std::hardware_destructive_interference_size) std::atomic_uint64_t consumedBytes;
+    alignas(std::hardware_destructive_interference_size) std::atomic_uint64_t elapsedNs;
+    std::atomic_uint64_t payloadBytes;
+    std::atomic_uint64_t errors;
+  };
+
+  struct result
+  {
+    std::uint64_t messages{};
+    std::uint64_t payloadBytes{};
+    std::uint64_t errors{};
+    double seconds{};
+  };
+
+  template<typename Config>
+  class throughput_run
+  {
+    using Layout = typename Config::Layout;
+    using HostType = typename Layout::template host<Config::QueueSizeBits, typename Config::MessageSize>;
+    using ProducerType =
+      typename Layout::template producer<Config::QueueSizeBits, Config::BatchReserve, typename Config::MessageSize>;
+    using ConsumerType = typename Layout::template consumer<Config::QueueSizeBits, typename Config::MessageSize>;
+
+    static constexpr std::uint64_t QueueBytes = std::uint64_t{ 1 } << Config::QueueSizeBits;
+    // how far the producer may run ahead of the consumer, this leaves room for the batch reservation and
+    // the bytes skipped when a message does not fit at the end of the queue.
+    static constexpr std::uint64_t Window = QueueBytes / 2;
+    static constexpr std::uint64_t CreditInterval = QueueBytes / 16;
+
+    static_assert(
+      Config::BatchReserve + (2 * (MaxMessageSize + sizeof(typename Config::MessageSize))) < Window,
+      "batch reservation is too large for the queue"
+    );
+
+  public:
+    throughput_run(control_block &control, unsigned producerCpu, unsigned consumerCpu)
+      : m_control(control)
+      , m_producerCpu(producerCpu)
+      , m_consumerCpu(consumerCpu)
+    {}
+
+    auto run(std::string_view name, std::vector<std::uint32_t> const &sizes, unsigned messages) -> result
+    {
+      HostType host{ name };
+      host.create(arquebus::danger_delete_existing_shared_memory_segment_tag{});
+
+      m_control.consumedBytes.store(0);
+      m_control.elapsedNs.store(0);
+      m_control.payloadBytes.store(0);
+      m_control.errors.store(0);
+
+      auto const child = fork();
+      if (child < 0) {
+        throw std::runtime_error("unable to fork consumer process");
+      }
+      if (child == 0) {
+        _exit(consume(name, sizes, messages));
+      }
+
+      produce(name, sizes, messages);
+
+      int status = 0;
+      waitpid(child, &status, 0);
+      if (not WIFEXITED(status) or WEXITSTATUS(status) != 0) {
+        throw std::runtime_error("consumer process failed");
+      }
+
+      return { .messages = messages,
+               .payloadBytes = m_control.payloadBytes.load(),
+               .errors = m_control.errors.load(),
+               .seconds = static_cast<double>(m_control.elapsedNs.load()) / 1e9 };  // NOLINT(*-magic-numbers)
+    }
+
+  private:
+    control_block &m_control;
+    unsigned m_producerCpu;
+    unsigned m_consumerCpu;
+
+    static auto queue_bytes(std::uint32_t size) noexcept -> std::uint64_t
+    {
+      return std::uint64_t{ size } + sizeof(typename Config::MessageSize);
+    }
+
+    void produce(std::string_view name, std::vector<std::uint32_t> const &sizes, unsigned messages)
+    {
+      arquebus::bench::pin_to_cpu(m_producerCpu);
+
+      ProducerType producer{ name };
+      producer.attach();
+
+      std::uint64_t produced = 0;
+      std::uint64_t credit = Window;
+      for (unsigned i = 0; i < messages; ++i) {
+        auto const size = sizes[i % sizes.size()];
+
+        produced += queue_bytes(size);
+        while (produced > credit) {
+          credit = m_control.consumedBytes.load(std::memory_order_acquire) + Window;
+        }
+
+        auto buffer = producer.allocate_write(static_cast<typename Config::MessageSize>(size));
+        std::memcpy(buffer.data(), &i, sizeof(i));
+        producer.flush();
+      }
+    }
+
+    auto consume(std::string_view name, std::vector<std::uint32_t> const &sizes, unsigned messages) noexcept -> int
+    {
+      try {
+        arquebus::bench::pin_to_cpu(m_consumerCpu);
+
+        ConsumerType consumer{ name };
+        consumer.attach();
+
+        std::uint64_t consumed = 0;
+        std::uint64_t published = 0;
+        std::uint64_t payload = 0;
+        std::uint64_t errors = 0;
+        Clock::time_point start{};
+
+        for (unsigned i = 0; i < messages; ++i) {
+          auto message = consumer.read();
+          while (not message.has_value()) {
+            message = consumer.read();
+          }
+          if (i == 0) {
+            start = Clock::now();
+          }
+
+          auto const expectedSize = sizes[i % sizes.size()];
+          unsigned sequence{};
+          std::memcpy(&sequence, message->data(), sizeof(sequence));
+          if (message->size() != expectedSize or sequence != i) {
+            ++errors;
+          }
+
+          payload += message->size();
+          consumed += queue_bytes(expectedSize);
+          if (consumed - published >= CreditInterval) {
+            m_control.consumedBytes.store(consumed, std::memory_order_release);
+            published = consumed;
+          }
+        }
+
+        auto const elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+        m_control.consumedBytes.store(consumed, std::memory_order_release);
+        m_control.payloadBytes.store(payload);
+        m_control.errors.store(errors);
+        m_control.elapsedNs.store(static_cast<std::uint64_t>(elapsed.count()));
+        return 0;
+      } catch (std::exception const &e) {
+        fmt::println("consumer error: {}", e.what());
+        return 1;
+      }
+    }
+  };
+
+  enum class output_format : std::uint8_t { Csv, Json };
+
+  struct report_row
+  {
+    std::string_view layout;
+    unsigned queueSizeBits;
+    std::size_t batchReserve;
+    std::size_t prefixBytes;
+    std::string_view distribution;
+    result measured;
+  };
+
+  void print_header(output_format format)
+  {
+    if (format == output_format::Csv) {
+      fmt::println(
+        "layout,queue_size_bits,batch_reserve,prefix_bytes,distribution,messages,payload_bytes,errors,seconds,msgs_per_s,gb_per_s"
+      );
+    } else {
+      fmt::println("[");
+    }
+  }
+
+  void print_row(output_format format, report_row const &row, bool first)
+  {
+    auto const msgsPerSecond = static_cast<double>(row.measured.messages) / row.measured.seconds;
+    auto const gbPerSecond = static_cast<double>(row.measured.payloadBytes) / row.measured.seconds / 1e9;  // NOLINT(*-magic-numbers)
+
+    if (format == output_format::Csv) {
+      fmt::println(
+        "{},{},{},{},{},{},{},{},{:.6f},{:.0f},{:.3f}",
+        row.layout,
+        row.queueSizeBits,
+        row.batchReserve,
+        row.prefixBytes,
+        row.distribution,
+        row.measured.messages,
+        row.measured.payloadBytes,
+        row.measured.errors,
+        row.measured.seconds,
+        msgsPerSecond,
+        gbPerSecond
+      );
+    } else {
+      fmt::println(
+        R"({}  {{ "layout": "{}", "queue_size_bits": {}, "batch_reserve": {}, "prefix_bytes": {}, "distribution": "{}", )"
+        R"("messages": {}, "payload_bytes": {}, "errors": {}, "seconds": {:.6f}, "msgs_per_s": {:.0f}, "gb_per_s": {:.3f} }})",
+        first ? " " : ",",
+        row.layout,
+        row.queueSizeBits,
+        row.batchReserve,
+        row.prefixBytes,
+        row.distribution,
+        row.measured.messages,
+        row.measured.payloadBytes,
+        row.measured.errors,
+        row.measured.seconds,
+        msgsPerSecond,
+        gbPerSecond
+      );
+    }
+  }
+
+  void print_footer(output_format format)
+  {
+    if (format == output_format::Json) {
+      fmt::println("]");
+    }
+  }
+
+  auto parse_arg(char const *arg, unsigned defaultValue) -> unsigned
+  {
+    std::string_view const text{ arg };
+    unsigned value{ defaultValue };
+    // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic)
+    if (std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc{}) {
+      return defaultValue;
+    }
+    return value;
+  }
+
+}  // namespace
+
+// usage: throughput [messages] [csv|json] [producer cpu] [consumer cpu]
+//
+// Progress and version information goes to stderr, so stdout can be redirected straight to a file.
+auto main(int argc, char const *argv[]) -> int
+{
+  try {
+    std::span const args{ argv, static_cast<std::size_t>(argc) };
+    auto const messages = args.size() > 1 ? parse_arg(args[1], DefaultMessages) : DefaultMessages;
+    auto const format =
+      (args.size() > 2 and std::string_view{ args[2] } == "json") ? output_format::Json : output_format::Csv;
+    auto const producerCpu = args.size() > 3 ? parse_arg(args[3], DefaultProducerCpu) : DefaultProducerCpu;
+    auto const consumerCpu = args.size() > 4 ? parse_arg(args[4], DefaultConsumerCpu) : DefaultConsumerCpu;
+
+    auto ver = arquebus::version();
+    fmt::println(stderr, "arquebus version: {} #{}", ver.version_string, ver.commit_short_hash);
+    fmt::println(stderr, "spsc throughput: {} messages per run, cpus {} and {}", messages, producerCpu, consumerCpu);
+
+    auto *mapping =
+      ::mmap(nullptr, sizeof(control_block), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+      throw std::runtime_error("unable to map control block");
+    }
+    // NOLINTNEXTLINE(*-owning-memory)
+    auto *control = ::new (mapping) control_block{};
+
+    auto const distributions = make_distributions();
+
+    print_header(format);
+    bool first = true;
+    std::apply(
+      [&]<typename... Configs>(Configs... /*unused*/) {
+        auto const runConfig = [&]<typename Config>(Config /*unused*/) {
+          throughput_run<Config> runner{ *control, producerCpu, consumerCpu };
+          for (auto const &dist : distributions) {
+            fmt::println(
+              stderr,
+              "running {} 2^{} queue, {} byte batch, {} byte prefix, {}",
+              Config::Layout::Name,
+              Config::QueueSizeBits,
+              Config::BatchReserve,
+              sizeof(typename Config::MessageSize),
+              dist.name
+            );
+            auto const measured = runner.run("throughput", dist.sizes, messages);
+            print_row(
+              format,
+              { .layout = Config::Layout::Name,
+                .queueSizeBits = Config::QueueSizeBits,
+                .batchReserve = Config::BatchReserve,
+                .prefixBytes = sizeof(typename Config::MessageSize),
+                .distribution = dist.name,
+                .measured = measured },
+              first
+            );
+            first = false;
+          }
+        };
+        (runConfig(Configs{}), ...);
+      },
+      Configurations{}
+    );
+    print_footer(format);
+
+    ::munmap(mapping, sizeof(control_block));
+    return 0;
+  } catch (std::exception const &e) {
+    fmt::println(stderr, "error: {}", e.what());
+    return 1;
+  }
+}
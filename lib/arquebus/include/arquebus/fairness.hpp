@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+namespace arquebus {
+
+  /// How a poller shares a sweep between the queues that have messages to read
+  enum class fairness : std::uint8_t {
+    RoundRobin,  // one message from each queue in turn, starting after where the last sweep stopped
+    Weighted,    // up to each queue's weight of messages from each queue in turn
+    Priority,    // all available messages from each queue in the order they were added, the first added first
+  };
+
+}  // namespace arquebus
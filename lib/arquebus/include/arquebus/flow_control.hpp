@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+namespace arquebus {
+
+  /// What a producer does when it laps a consumer that has not read everything, chosen by the host.
+  enum class flow_control : std::uint8_t {
+    // the producer never waits, the consumer detects that it was overrun when it next reads
+    Overwrite,
+    // the producer never writes over unread data, allocations wait (or fail) until the consumer frees space
+    Backpressure,
+  };
+
+  /// What a consumer does when it finds that the producer has overwritten messages it had not read. Only
+  /// possible with flow_control::Overwrite.
+  enum class overrun_policy : std::uint8_t {
+    // throw a std::runtime_error, the consumer can not be used again
+    Throw,
+    // skip ahead to a recent message and keep reading, counting what was lost
+    Resync,
+  };
+
+  /// What a consumer has lost to overruns, with overrun_policy::Resync
+  struct overrun_losses
+  {
+    // the number of times the consumer was overrun and skipped ahead
+    std::uint64_t overruns{ 0 };
+    // the messages skipped
+    std::uint64_t messages{ 0 };
+    // the bytes of queue skipped, including the framing around the messages
+    std::uint64_t bytes{ 0 };
+  };
+
+}  // namespace arquebus
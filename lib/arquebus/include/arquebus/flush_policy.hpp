@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+namespace arquebus {
+
+  /// When a producer's flush() publishes the flushed messages to the consumer.
+  ///
+  /// Publishing is a release store to the read index, and moves its cache line over to the consumer, so
+  /// publishing every message costs throughput while holding messages back costs latency. A policy lets each
+  /// queue choose where it sits without changing the code that calls flush(). Messages that flush() holds
+  /// back are published by a later flush(), or flush_now(), which a producer should call before it goes idle.
+  class flush_policy
+  {
+  public:
+    enum class kind : std::uint8_t {
+      EveryFlush,  // publish on every flush()
+      Messages,    // publish once limit messages are waiting
+      Bytes,       // publish once limit bytes of queue are waiting
+      Cycles,      // publish once the oldest waiting flush is limit cycles old
+      Adaptive,    // publish at once while the consumer is keeping up, otherwise once limit messages are waiting
+    };
+
+    /// Publish every flush, the default
+    static constexpr auto every_flush() noexcept -> flush_policy { return { kind::EveryFlush, 0 }; }
+
+    /// Publish once messages messages are waiting
+    static constexpr auto every_messages(std::uint64_t messages) noexcept -> flush_policy
+    {
+      return { kind::Messages, messages };
+    }
+
+    /// Publish once bytes bytes of the queue are waiting, including the framing
+    static constexpr auto every_bytes(std::uint64_t bytes) noexcept -> flush_policy { return { kind::Bytes, bytes }; }
+
+    /// Publish once the first waiting flush is cycles old, measured with the CPU cycle counter (the TSC on x86)
+    static constexpr auto cycle_budget(std::uint64_t cycles) noexcept -> flush_policy
+    {
+      return { kind::Cycles, cycles };
+    }
+
+    /// Publish at once while the consumer has read everything published so far, as it is waiting for more.
+    /// Once it falls behind it will not see new messages straight away anyway, so hold back until maxMessages
+    /// are waiting, or it catches up.
+    static constexpr auto adaptive(std::uint64_t maxMessages) noexcept -> flush_policy
+    {
+      return { kind::Adaptive, maxMessages };
+    }
+
+    [[nodiscard]] constexpr auto type() const noexcept -> kind { return m_kind; }
+    [[nodiscard]] constexpr auto limit() const noexcept -> std::uint64_t { return m_limit; }
+
+  private:
+    constexpr flush_policy(kind type, std::uint64_t limit) noexcept
+      : m_kind{ type }
+      , m_limit{ limit }
+    {}
+
+    kind m_kind;
+    std::uint64_t m_limit;
+  };
+
+}  // namespace arquebus
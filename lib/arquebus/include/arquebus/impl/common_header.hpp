@@ -25,9 +25,17 @@ namespace arquebus {
     std::atomic<queue_type> type{ queue_type::None };
     semantic_version arquebus_version{};
     std::size_t message_size_type_size{};
+    // only used by fixed message length queues, zero otherwise
+    std::size_t message_size{};
+    // the alignment of fixed length messages, or the payload alignment of aligned variable length queues
+    std::size_t message_alignment{};
     std::size_t max_producers{};
     std::size_t max_consumers{};
     std::uint64_t size_of_queue{};
+    // the NUMA node the host bound the segment to, or -1 if it is not bound to a single node
+    std::int32_t numa_node{ -1 };
+    // identifies the message types of a typed queue, zero otherwise
+    std::uint64_t catalog_hash{};
   };
 
 }  // namespace arquebus
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "event_notification.hpp"
+#include "futex.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace arquebus::impl {
+
+  // The words a consumer parks on when it is idle, or arms to have its eventfd signalled, and the producer checks
+  // to wake it.
+  //
+  // This sits on its own cache line in the queue. Once a consumer has parked, the producer pays for a full fence
+  // and a load of this line in every flush. Until then it is a single relaxed load of a line that is never
+  // written, so queues whose consumers only spin are not slowed down.
+  //
+  // A consumer raises waiting (or armed) before its final check for data and the producer checks them after it
+  // publishes data, with a full fence between the two in both, so one of them must see the other. The exception
+  // is the first park, where the producer may not yet see parks and skip the check. The consumer only ever parks
+  // for a bounded time, so that can delay a message by at most one park timeout. An eventfd wait has no timeout,
+  // so the host sets parks from the start for a queue with notification::EventFd.
+  struct consumer_wakeup
+  {
+    // set once a consumer has parked, so the producer knows to check waiting and armed
+    std::atomic_uint32_t parks{ 0 };
+    // the futex word, non zero while the consumer is parked or about to park
+    std::atomic_uint32_t waiting{ 0 };
+    // non zero while the consumer is waiting for its eventfd to be signalled
+    std::atomic_uint32_t armed{ 0 };
+
+    // Park the consumer for up to timeout, unless ready() says there is data to read. May return early.
+    template<typename Ready>
+    void park(std::chrono::nanoseconds timeout, Ready &&ready) noexcept
+    {
+      if (parks.load(std::memory_order_relaxed) == 0) [[unlikely]] {
+        parks.store(1, std::memory_order_relaxed);
+      }
+
+      waiting.store(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      if (not ready()) {
+        futex_wait(waiting, 1, timeout);
+      }
+      waiting.store(0, std::memory_order_relaxed);
+    }
+
+    // Arm the eventfd to be signalled by the next flush, unless ready() says there is already data to read.
+    // Returns false, without arming, if there is.
+    template<typename Ready>
+    auto arm(Ready &&ready) noexcept -> bool
+    {
+      armed.store(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      if (ready()) {
+        armed.store(0, std::memory_order_relaxed);
+        return false;
+      }
+      return true;
+    }
+
+    // Wake the consumer if it is parked, and signal eventFd if it is armed. Called by the producer after
+    // publishing data.
+    void notify(int eventFd) noexcept
+    {
+      if (parks.load(std::memory_order_relaxed) != 0) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed) != 0 and waiting.exchange(0, std::memory_order_relaxed) != 0) {
+          futex_wake(waiting);
+        }
+        if (armed.load(std::memory_order_relaxed) != 0 and armed.exchange(0, std::memory_order_relaxed) != 0) {
+          signal_eventfd(eventFd);
+        }
+      }
+    }
+  };
+
+}  // namespace arquebus::impl
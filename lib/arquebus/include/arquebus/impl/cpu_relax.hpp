@@ -0,0 +1,16 @@
+#pragma once
+
+namespace arquebus::impl {
+
+  // Hint to the CPU that we are in a spin-wait loop. This reduces power and frees execution resources
+  // for a sibling hyper-thread without giving up the core.
+  inline void cpu_relax() noexcept
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+  }
+
+}  // namespace arquebus::impl
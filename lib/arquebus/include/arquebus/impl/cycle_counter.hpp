@@ -0,0 +1,33 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace arquebus::impl {
+
+  // Read the CPU's free running cycle counter.
+  //
+  // On x86 this is the TSC, which counts reference cycles at a constant rate rather than core clock cycles,
+  // so it will under report when the core is boosting. On AArch64 it is the virtual counter, which runs at a
+  // much lower fixed frequency. Elsewhere it falls back to nanoseconds.
+  inline auto read_cycle_counter() noexcept -> std::uint64_t
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    std::uint64_t value{};
+    asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count()
+    );
+#endif
+  }
+
+}  // namespace arquebus::impl
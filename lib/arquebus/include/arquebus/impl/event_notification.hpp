@@ -0,0 +1,73 @@
+#pragma once
+
+#include "fd_handle.hpp"
+#include "fd_passing.hpp"
+
+// POSIX
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace arquebus::impl {
+
+  // A queue's eventfd is created by the host and handed to the producer and consumer over an abstract socket,
+  // in the same way as a MemFd segment. It works with either transport, and goes away with the host.
+
+  // the abstract socket name for the eventfd of the segment segmentName (see shared_memory_helper::name())
+  inline auto eventfd_socket_name(std::string_view segmentName) -> std::string
+  {
+    // drop the leading '/' of the shm name
+    std::string name{ segmentName.substr(1) };
+    name.append(".eventfd");
+    return name;
+  }
+
+  // The host's end, creates the eventfd and hands it out until destroyed
+  class eventfd_host
+  {
+  public:
+    // Non blocking, so a consumer can drain it without checking that it is readable first
+    explicit eventfd_host(std::string_view segmentName)
+      : m_fd{ ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK) }
+    {
+      if (m_fd < 0) {
+        throw std::runtime_error("Failed to create queue eventfd");
+      }
+      m_server = std::make_unique<fd_server>(eventfd_socket_name(segmentName), m_fd);
+    }
+
+  private:
+    fd_handle m_fd;
+    std::unique_ptr<fd_server> m_server;
+  };
+
+  // a producer or consumer receives the eventfd from the host
+  inline auto request_eventfd(std::string_view segmentName) -> fd_handle
+  {
+    fd_handle fd{ request_fd(eventfd_socket_name(segmentName)) };
+    if (fd < 0) {
+      throw std::runtime_error("Failed to receive queue eventfd");
+    }
+    return fd;
+  }
+
+  // make the eventfd readable
+  inline void signal_eventfd(int fd) noexcept
+  {
+    std::uint64_t const one{ 1 };
+    static_cast<void>(::write(fd, &one, sizeof(one)));
+  }
+
+  // reset the eventfd to not readable
+  inline void drain_eventfd(int fd) noexcept
+  {
+    std::uint64_t count{ 0 };
+    static_cast<void>(::read(fd, &count, sizeof(count)));
+  }
+
+}  // namespace arquebus::impl
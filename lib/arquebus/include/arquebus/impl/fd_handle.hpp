@@ -2,26 +2,48 @@
 
 #include <unistd.h>
 
+#include <utility>
+
 namespace arquebus::impl {
 
   class fd_handle
   {
   public:
+    fd_handle() = default;
+
     explicit fd_handle(int fd)
       : m_fd(fd)
     {}
 
-    ~fd_handle()
+    ~fd_handle() { reset(); }
+
+    // the descriptor has a single owner, it can be moved but not copied
+    fd_handle(fd_handle &&other) noexcept
+      : m_fd(std::exchange(other.m_fd, -1))
+    {}
+    auto operator=(fd_handle &&other) noexcept -> fd_handle &
     {
-      if (m_fd != -1) {
-        ::close(m_fd);
+      if (this != &other) {
+        reset(std::exchange(other.m_fd, -1));
       }
+      return *this;
     }
+    fd_handle(fd_handle const &) = delete;
+    auto operator=(fd_handle const &) -> fd_handle & = delete;
 
     operator int() const { return m_fd; }
 
+    // close the current descriptor, if any, and take ownership of fd
+    void reset(int fd = -1) noexcept
+    {
+      if (m_fd != -1) {
+        ::close(m_fd);
+      }
+      m_fd = fd;
+    }
+
   private:
-    int m_fd;
+    int m_fd{ -1 };
   };
 
 
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "fd_handle.hpp"
+
+// POSIX
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace arquebus::impl {
+
+  // Passing a segment's file descriptor from the host to producers and consumers over an AF_UNIX socket.
+  //
+  // The socket lives in the abstract namespace, so there is nothing in the file system to clean up. It goes
+  // away when the host closes it, even if the host crashes, and a second host binding the same name fails
+  // while the first is still alive.
+
+  // the socket address for a segment name, the leading nul selects the abstract namespace
+  inline auto make_abstract_address(std::string_view name, sockaddr_un &address) -> socklen_t
+  {
+    address = {};
+    address.sun_family = AF_UNIX;
+    if (name.empty() or name.size() >= sizeof(address.sun_path) - 1) {
+      throw std::invalid_argument("name is empty or too long");
+    }
+    std::memcpy(&address.sun_path[1], name.data(), name.size());
+    return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + name.size());
+  }
+
+  // send fd as SCM_RIGHTS ancillary data alongside a single byte
+  inline auto send_fd(int socket, int fd) noexcept -> bool
+  {
+    char byte{ 0 };
+    iovec data{ .iov_base = &byte, .iov_len = 1 };
+    alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int))> control{};
+
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control.data();
+    message.msg_controllen = control.size();
+
+    auto *header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(header), &fd, sizeof(int));
+
+    return ::sendmsg(socket, &message, MSG_NOSIGNAL) == 1;
+  }
+
+  // receive a descriptor sent by send_fd, -1 if none was received
+  inline auto receive_fd(int socket) noexcept -> int
+  {
+    char byte{ 0 };
+    iovec data{ .iov_base = &byte, .iov_len = 1 };
+    alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int))> control{};
+
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control.data();
+    message.msg_controllen = control.size();
+
+    if (::recvmsg(socket, &message, MSG_CMSG_CLOEXEC) != 1) {
+      return -1;
+    }
+
+    auto const *header = CMSG_FIRSTHDR(&message);
+    if (
+      header == nullptr or header->cmsg_level != SOL_SOCKET or header->cmsg_type != SCM_RIGHTS
+      or header->cmsg_len != CMSG_LEN(sizeof(int))
+    ) {
+      return -1;
+    }
+
+    int fd{ -1 };
+    std::memcpy(&fd, CMSG_DATA(header), sizeof(int));
+    return fd;
+  }
+
+  // connect to the host's socket for name and receive the segment descriptor, -1 if the host is not there
+  inline auto request_fd(std::string_view name) -> int
+  {
+    sockaddr_un address{};
+    auto const addressLength = make_abstract_address(name, address);
+
+    fd_handle const socket{ ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0) };
+    if (socket < 0) {
+      return -1;
+    }
+    // NOLINTNEXTLINE(*-reinterpret-cast)
+    if (::connect(socket, reinterpret_cast<sockaddr const *>(&address), addressLength) < 0) {
+      return -1;
+    }
+    return receive_fd(socket);
+  }
+
+
+  // Listens on the abstract socket for name and hands fd to every process that connects, until destroyed.
+  //
+  // Only processes running as the same user are given the descriptor, the same as the 0600 permissions we
+  // give a named segment.
+  class fd_server
+  {
+  public:
+    fd_server(std::string_view name, int fd)
+      : m_listen{ ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0) }
+      , m_stop{ ::eventfd(0, EFD_CLOEXEC) }
+    {
+      if (m_listen < 0 or m_stop < 0) {
+        throw std::runtime_error("Failed to create segment socket");
+      }
+
+      sockaddr_un address{};
+      auto const addressLength = make_abstract_address(name, address);
+      // NOLINTNEXTLINE(*-reinterpret-cast)
+      if (::bind(m_listen, reinterpret_cast<sockaddr const *>(&address), addressLength) < 0) {
+        if (errno == EADDRINUSE) {
+          throw std::runtime_error("Shared memory segment already exists");
+        }
+        throw std::runtime_error("Failed to bind segment socket");
+      }
+      if (::listen(m_listen, SOMAXCONN) < 0) {
+        throw std::runtime_error("Failed to listen on segment socket");
+      }
+
+      m_thread = std::jthread{ [this, fd] { serve(fd); } };
+    }
+
+    ~fd_server()
+    {
+      std::uint64_t const wake{ 1 };
+      static_cast<void>(::write(m_stop, &wake, sizeof(wake)));
+    }
+
+    fd_server(fd_server &&) = delete;
+    auto operator=(fd_server &&) -> fd_server & = delete;
+    fd_server(fd_server const &) = delete;
+    auto operator=(fd_server const &) -> fd_server & = delete;
+
+  private:
+    fd_handle m_listen;
+    fd_handle m_stop;
+    // declared last, so it is joined before the sockets are closed
+    std::jthread m_thread;
+
+    void serve(int fd) const noexcept
+    {
+      std::array<pollfd, 2> waiting{ pollfd{ .fd = m_listen, .events = POLLIN, .revents = 0 },
+                                     pollfd{ .fd = m_stop, .events = POLLIN, .revents = 0 } };
+
+      while (true) {
+        if (::poll(waiting.data(), waiting.size(), -1) < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          return;
+        }
+        if (waiting[1].revents != 0) {
+          return;
+        }
+
+        fd_handle const connection{ ::accept4(m_listen, nullptr, nullptr, SOCK_CLOEXEC) };
+        if (connection < 0) {
+          continue;
+        }
+
+        ucred peer{};
+        socklen_t peerLength = sizeof(peer);
+        if (::getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &peer, &peerLength) == 0 and peer.uid == ::geteuid()) {
+          static_cast<void>(send_fd(connection, fd));
+        }
+      }
+    }
+  };
+
+}  // namespace arquebus::impl
@@ -0,0 +1,35 @@
+#pragma once
+
+// POSIX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+
+namespace arquebus::impl {
+
+  // Sleep while word still holds expected, until woken by futex_wake() or the timeout passes. The word lives in
+  // shared memory, so this is a shared (not FUTEX_PRIVATE_FLAG) futex that can be woken from another process.
+  // Spurious wake ups are possible, the caller must re-check its condition.
+  inline void futex_wait(std::atomic_uint32_t &word, std::uint32_t expected, std::chrono::nanoseconds timeout) noexcept
+  {
+    auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    timespec const relative{ .tv_sec = seconds.count(), .tv_nsec = (timeout - seconds).count() };
+
+    // NOLINTNEXTLINE(*-vararg)
+    static_cast<void>(::syscall(SYS_futex, &word, FUTEX_WAIT, expected, &relative, nullptr, 0));
+  }
+
+  // Wake every thread sleeping in futex_wait() on word
+  inline void futex_wake(std::atomic_uint32_t &word) noexcept
+  {
+    // NOLINTNEXTLINE(*-vararg)
+    static_cast<void>(::syscall(SYS_futex, &word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0));
+  }
+
+}  // namespace arquebus::impl
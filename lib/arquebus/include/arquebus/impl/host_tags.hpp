@@ -0,0 +1,11 @@
+#pragma once
+
+namespace arquebus {
+
+  // Tag to request a host deletes any pre-existing shared memory segment of the same name before
+  // creating its own.
+  struct danger_delete_existing_shared_memory_segment_tag
+  {
+  };
+
+}  // namespace arquebus
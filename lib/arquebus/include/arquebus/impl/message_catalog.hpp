@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <source_location>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+namespace arquebus::impl {
+
+  // The name of T as the compiler spells it, taken from the signature of this function. GCC and Clang both
+  // write it as "[with T = name; ...]" or "[T = name]", anything else falls back to the whole signature.
+  template<typename T>
+  constexpr auto type_name() noexcept -> std::string_view
+  {
+    std::string_view const signature{ std::source_location::current().function_name() };
+    constexpr std::string_view Marker{ "T = " };
+
+    auto const start = signature.find(Marker);
+    if (start == std::string_view::npos) {
+      return signature;
+    }
+    auto const name = signature.substr(start + Marker.size());
+    return name.substr(0, name.find_first_of(";]"));
+  }
+
+  // The name T is hashed under in a message_catalog, T::catalog_name if it declares one
+  template<typename T>
+  constexpr auto catalog_name() noexcept -> std::string_view
+  {
+    if constexpr (requires { std::string_view{ T::catalog_name }; }) {
+      return T::catalog_name;
+    } else {
+      return type_name<T>();
+    }
+  }
+
+  // 64 bit FNV-1a, continuing from hash
+  constexpr auto fnv1a(std::uint64_t hash, std::string_view bytes) noexcept -> std::uint64_t
+  {
+    constexpr std::uint64_t Prime = 0x100000001b3;
+    for (auto const byte : bytes) {
+      hash = (hash ^ static_cast<std::uint8_t>(byte)) * Prime;
+    }
+    return hash;
+  }
+
+  constexpr auto fnv1a(std::uint64_t hash, std::uint64_t value) noexcept -> std::uint64_t
+  {
+    constexpr std::uint64_t Prime = 0x100000001b3;
+    for (int i = 0; i < 8; ++i) {
+      hash = (hash ^ (value & 0xFFU)) * Prime;
+      value >>= 8U;
+    }
+    return hash;
+  }
+
+  // The message types of a typed queue.
+  //
+  // Each message payload starts with the type id, the index of the type in Msgs, followed by the message
+  // itself at MessageOffset. The payload alignment covers every type, so the message can be used in place.
+  //
+  // The hash covers the name, size and alignment of each type in order, it is stored in the queue's header by
+  // the host so that a producer or consumer built with a different catalog fails to attach.
+  //
+  // It says nothing about the fields, a type with its fields reordered but the same size and alignment keeps
+  // its hash. And by default the name is as the compiler spells it, which differs between GCC and Clang, so a
+  // producer and consumer built by different compilers fail to attach even with the same catalog. A type can
+  // declare a stable name, static constexpr std::string_view catalog_name, to be hashed under instead, and
+  // change it (say with a version suffix) whenever its layout changes.
+  template<typename... Msgs>
+  struct message_catalog
+  {
+    static_assert(sizeof...(Msgs) > 0, "a message catalog needs at least one type");
+    static_assert(sizeof...(Msgs) <= 65'536, "a message catalog can have at most 65536 types");
+    static_assert((std::is_trivially_copyable_v<Msgs> and ...), "every message type must be trivially copyable");
+    static_assert((not std::is_const_v<Msgs> and ...), "message types must not be const");
+
+    using TypeId = std::conditional_t<sizeof...(Msgs) <= 256, std::uint8_t, std::uint16_t>;
+
+    static constexpr std::size_t Count = sizeof...(Msgs);
+    static constexpr std::size_t Alignment = std::max({ alignof(TypeId), alignof(Msgs)... });
+    static constexpr std::size_t MessageOffset = (sizeof(TypeId) + Alignment - 1) & ~(Alignment - 1);
+    static constexpr std::size_t MaxPayload = MessageOffset + std::max({ sizeof(Msgs)... });
+
+    // the payload size of each type
+    static constexpr std::array<std::size_t, Count> PayloadSizes{ (MessageOffset + sizeof(Msgs))... };
+
+    template<typename T>
+    static constexpr std::size_t Occurrences = (std::size_t{ std::is_same_v<T, Msgs> } + ...);
+
+    static_assert(((Occurrences<Msgs> == 1) and ...), "every message type must be distinct");
+
+    template<typename T>
+      requires(Occurrences<T> == 1)
+    static constexpr TypeId IdOf = []() {
+      constexpr std::array<bool, Count> Matches{ std::is_same_v<T, Msgs>... };
+      return static_cast<TypeId>(std::ranges::find(Matches, true) - Matches.begin());
+    }();
+
+    static constexpr std::uint64_t Hash = []() {
+      constexpr std::uint64_t OffsetBasis = 0xcbf29ce484222325;
+      auto hash = fnv1a(OffsetBasis, std::uint64_t{ Count });
+      ((hash = fnv1a(fnv1a(fnv1a(hash, catalog_name<Msgs>()), sizeof(Msgs)), alignof(Msgs))), ...);
+      // zero marks an untyped queue
+      return hash == 0 ? 1 : hash;
+    }();
+
+    // Call visitor with the message in payload, through a table of one entry per type. A payload that does not
+    // match the catalog throws std::runtime_error.
+    template<typename Visitor>
+    static void visit(std::span<std::byte const> payload, Visitor &visitor)
+    {
+      using Handler = void (*)(std::byte const *, Visitor &);
+      static constexpr std::array<Handler, Count> Handlers{ &visit_as<Msgs, Visitor>... };
+
+      TypeId id{};
+      if (payload.size() >= sizeof(TypeId)) [[likely]] {
+        std::memcpy(&id, payload.data(), sizeof(TypeId));
+      }
+      if (id >= Count or payload.size() != PayloadSizes[id]) [[unlikely]] {
+        throw std::runtime_error("message does not match the catalog");
+      }
+      Handlers[id](payload.data() + MessageOffset, visitor);
+    }
+
+    template<typename T, typename Visitor>
+    static void visit_as(std::byte const *message, Visitor &visitor)
+    {
+      // NOLINTNEXTLINE(*-reinterpret-cast)
+      visitor(*std::launder(reinterpret_cast<T const *>(message)));
+    }
+  };
+
+}  // namespace arquebus::impl
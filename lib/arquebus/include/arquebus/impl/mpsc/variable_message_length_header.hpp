@@ -0,0 +1,163 @@
+#pragma once
+
+#include "arquebus/impl/buffer_size.hpp"
+#include "arquebus/impl/common_header.hpp"
+#include "arquebus/impl/queue_type.hpp"
+#include "arquebus/version.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+namespace arquebus::impl::mpsc {
+
+  // Each message in the queue is preceded by an 8 byte record word. The producer that claimed the record
+  // publishes it by atomically storing a non-zero record word once the payload has been written. This
+  // gives every message its own commit flag, so a slow producer only delays messages claimed after its
+  // own and never prevents other producers from writing.
+  //
+  // Records are always a multiple of 8 bytes so the record words stay naturally aligned for atomic access
+  // and the payloads are 8 byte aligned.
+  //
+  // The consumer zeroes the records it has consumed before releasing the space back to the producers. A
+  // zero record word therefore always means "not yet committed".
+  struct record
+  {
+    using Word = std::uint64_t;
+
+    static constexpr auto HeaderSize = std::uint64_t{ sizeof(Word) };
+    static constexpr auto Alignment = std::uint64_t{ sizeof(Word) };
+
+    static constexpr auto LengthMask = Word{ 0xFFFF'FFFFu };
+    static constexpr auto MessageFlag = Word{ 1u } << 32u;
+    static constexpr auto PaddingFlag = Word{ 2u } << 32u;
+
+    static constexpr auto size_for(std::uint64_t payloadSize) noexcept -> std::uint64_t
+    {
+      return HeaderSize + ((payloadSize + Alignment - 1) & ~(Alignment - 1));
+    }
+
+    static constexpr auto make_message(std::uint64_t payloadSize) noexcept -> Word
+    {
+      return MessageFlag | (payloadSize & LengthMask);
+    }
+
+    static constexpr auto make_padding(std::uint64_t recordSize) noexcept -> Word
+    {
+      return PaddingFlag | ((recordSize - HeaderSize) & LengthMask);
+    }
+
+    static constexpr auto is_padding(Word word) noexcept -> bool { return (word & PaddingFlag) != 0; }
+    static constexpr auto length(Word word) noexcept -> std::uint64_t { return word & LengthMask; }
+  };
+
+
+  template<std::uint8_t Size2NBits, std::size_t MaxProducers, std::size_t CacheLineSize>
+  struct variable_message_length_header
+  {
+    using BufferSize = buffer_size<Size2NBits>;
+    using MessageSize = std::uint32_t;
+
+    static constexpr auto QueueType = queue_type::MultiProducerSingleConsumerVariableMessageLength;
+
+    static_assert(MaxProducers > 0, "At least one producer must be supported");
+    static_assert(BufferSize::Bytes >= 4 * record::HeaderSize, "Queue is too small");
+
+    common_header header{};
+    // The reservation index is claimed by the producers with an atomic fetch-add. Every byte before it
+    // has been handed to exactly one producer.
+    alignas(CacheLineSize) std::atomic_uint64_t reserve_index{ 0 };
+    // The consumer index is published by the consumer, all bytes before it have been consumed and zeroed
+    // and can be claimed again by the producers.
+    alignas(CacheLineSize) std::atomic_uint64_t consumer_index{ 0 };
+    // The number of producers currently attached.
+    alignas(CacheLineSize) std::atomic_uint64_t attached_producers{ 0 };
+
+    // we are using C-style array to avoid initialisation, it will be zero filled when we
+    // map it into memory as a shared memory region. We store it as record words so we can
+    // access the record headers atomically.
+    // NOLINTNEXTLINE(*-avoid-c-arrays)
+    alignas(CacheLineSize) record::Word data[BufferSize::Bytes / sizeof(record::Word)];
+
+
+    [[nodiscard]] auto record_word(std::uint64_t index) noexcept -> std::atomic_ref<record::Word>
+    {
+      return std::atomic_ref<record::Word>{ data[BufferSize::to_offset(index) / sizeof(record::Word)] };
+    }
+
+    [[nodiscard]] auto bytes(std::uint64_t index) noexcept -> std::byte *
+    {
+      // NOLINTNEXTLINE(*-pro-type-reinterpret-cast, *-pro-bounds-pointer-arithmetic)
+      return reinterpret_cast<std::byte *>(data) + BufferSize::to_offset(index);
+    }
+
+    // the owner should initialise the queue
+    void initialise()
+    {
+      auto type = header.type.load(std::memory_order_acquire);
+      if (type != queue_type::None) {
+        throw std::logic_error("queue is already initialised");
+      }
+
+      header.arquebus_version = version_details{}.version;
+      header.message_size_type_size = sizeof(MessageSize);
+      header.max_producers = MaxProducers;
+      header.max_consumers = 1;
+      header.size_of_queue = BufferSize::Bytes;
+
+      reserve_index.store(0, std::memory_order_release);
+      consumer_index.store(0, std::memory_order_release);
+      attached_producers.store(0, std::memory_order_release);
+      header.type.store(QueueType, std::memory_order_release);
+    }
+
+
+    // a user (producer or consumer) should wait for the queue to be initialised and
+    // validate that it meets expectations.
+    void wait_and_validate()
+    {
+      queue_type type = queue_type::None;
+      do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        type = header.type.load(std::memory_order_seq_cst);
+      } while (type == queue_type::None);
+
+      // owner has initialised
+      if (header.magic_number != common_header::HeaderMagicNumber) {
+        throw std::logic_error("bad magic number for header");
+      }
+      if (type != QueueType) {
+        throw std::logic_error("incorrect queue type");
+      }
+      if (header.message_size_type_size != sizeof(MessageSize)) {
+        throw std::logic_error("incorrect message size type");
+      }
+      if (header.max_producers != MaxProducers) {
+        throw std::logic_error("incorrect max producers");
+      }
+      if (header.max_consumers != 1) {
+        throw std::logic_error("incorrect max consumers");
+      }
+      if (header.size_of_queue != BufferSize::Bytes) {
+        throw std::logic_error("incorrect size of queue");
+      }
+    }
+
+    // register a producer, fails if the maximum number of producers are already attached
+    void register_producer()
+    {
+      auto attached = attached_producers.load(std::memory_order_relaxed);
+      do {
+        if (attached >= MaxProducers) {
+          throw std::runtime_error("maximum number of producers already attached");
+        }
+      } while (not attached_producers.compare_exchange_weak(attached, attached + 1, std::memory_order_acq_rel));
+    }
+
+    void unregister_producer() noexcept { attached_producers.fetch_sub(1, std::memory_order_acq_rel); }
+  };
+
+}  // namespace arquebus::impl::mpsc
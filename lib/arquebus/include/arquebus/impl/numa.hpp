@@ -0,0 +1,70 @@
+#pragma once
+
+#include "arquebus/mapping_options.hpp"
+
+// Linux
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace arquebus::impl {
+
+  // The NUMA node recorded in the common_header when the segment is not bound to a single node
+  inline constexpr std::int32_t NoNumaNode = -1;
+
+  // Apply the NUMA placement to a mapping. This must happen before any page of the mapping is touched, the
+  // policy only affects pages as they are faulted in. For a shared mapping the policy is attached to the
+  // shared memory object itself, so it holds no matter which process touches a page first.
+  //
+  // We call mbind directly rather than through libnuma, so there is no extra library to link.
+  inline void apply_numa_placement(void *mapping, std::size_t size, numa_placement placement, unsigned node)
+  {
+    if (placement == numa_placement::Default) {
+      return;
+    }
+
+    constexpr std::size_t MaxNodes = 1024;
+    constexpr std::size_t BitsPerWord = sizeof(unsigned long) * CHAR_BIT;
+    std::array<unsigned long, MaxNodes / BitsPerWord> nodeMask{};
+
+    int mode = MPOL_INTERLEAVE;
+    if (placement == numa_placement::Bind) {
+      if (node >= MaxNodes) {
+        throw std::invalid_argument("invalid NUMA node");
+      }
+      mode = MPOL_BIND;
+      nodeMask.at(node / BitsPerWord) = 1UL << (node % BitsPerWord);
+    } else {
+      // the kernel masks this down to the nodes that have memory and that we are allowed to use
+      nodeMask.fill(~0UL);
+    }
+
+    if (::syscall(SYS_mbind, mapping, size, mode, nodeMask.data(), MaxNodes, 0) < 0) {
+      throw std::runtime_error("Failed to set NUMA placement for shared memory segment");
+    }
+  }
+
+  // the NUMA node of the CPU the calling thread is running on
+  [[nodiscard]] inline auto current_numa_node() noexcept -> std::int32_t
+  {
+    unsigned cpu{};
+    unsigned node{};
+    if (::syscall(SYS_getcpu, &cpu, &node, nullptr) < 0) {
+      return NoNumaNode;
+    }
+    return static_cast<std::int32_t>(node);
+  }
+
+  // true if the segment is bound to a node, and it is not the node the calling thread is running on
+  [[nodiscard]] inline auto is_remote_numa_node(std::int32_t segmentNode) noexcept -> bool
+  {
+    return segmentNode != NoNumaNode and segmentNode != current_numa_node();
+  }
+
+}  // namespace arquebus::impl
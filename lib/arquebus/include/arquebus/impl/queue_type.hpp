@@ -11,6 +11,12 @@ namespace arquebus {
     SingleProducerSingleConsumerVariableMessageLength,
     SingleProducerMultiConsumerVariableMessageLength,
     MultiProducerSingleConsumerVariableMessageLength,
+    SingleProducerSingleConsumerFixedMessageLength,
+    SingleProducerMultiConsumerWorkDistributionFixedMessageLength,
+    SingleProducerMultiConsumerSequencedFixedMessageLength,
+    SingleProducerSingleConsumerMirroredVariableMessageLength,
+    SingleProducerSingleConsumerRuntimeSizedVariableMessageLength,
+    ReadySet,  // not a queue, the ready bitmap shared by the producers of queues drained by one poller
   };
 
 }
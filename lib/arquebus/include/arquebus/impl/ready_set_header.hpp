@@ -0,0 +1,91 @@
+#pragma once
+
+#include "arquebus/impl/common_header.hpp"
+#include "arquebus/impl/queue_type.hpp"
+#include "arquebus/version.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+namespace arquebus::impl {
+
+  // A bit per queue, set by the queue's producer after it publishes messages and taken by the poller before it
+  // reads them, so the poller reads one cache line to find which of its queues have anything to read.
+  //
+  // The producer only writes the line when its bit is clear, so a busy queue does not keep taking the line
+  // away from the poller and the other producers. A producer publishes, fences, and then checks its bit, while
+  // the poller takes the bits and fences before it reads the queues. With a full fence on both sides either
+  // the producer sees its bit cleared and sets it again, or the poller sees the published messages.
+  template<std::size_t CacheLineSize>
+  struct ready_set_header
+  {
+    static constexpr auto QueueType = queue_type::ReadySet;
+    static constexpr std::size_t MaxQueues = 64;
+
+    common_header header{};
+    alignas(CacheLineSize) std::atomic_uint64_t ready{ 0 };
+
+    // the owner should initialise the set
+    void initialise()
+    {
+      auto type = header.type.load(std::memory_order_acquire);
+      if (type != queue_type::None) {
+        throw std::logic_error("ready set is already initialised");
+      }
+
+      header.arquebus_version = version_details{}.version;
+      header.max_producers = MaxQueues;
+      header.max_consumers = 1;
+      header.size_of_queue = sizeof(ready);
+      ready.store(0, std::memory_order_release);
+      header.type.store(QueueType, std::memory_order_release);
+    }
+
+    // a producer marks its queue as having messages, after it has published them
+    void mark(std::uint64_t mask) noexcept
+    {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if ((ready.load(std::memory_order_relaxed) & mask) == 0) {
+        ready.fetch_or(mask, std::memory_order_release);
+      }
+    }
+
+    // the poller takes the marked queues, before it reads them
+    [[nodiscard]] auto take() noexcept -> std::uint64_t
+    {
+      // nothing marked, leave the line shared with the producers
+      if (ready.load(std::memory_order_relaxed) == 0) {
+        return 0;
+      }
+      auto const marked = ready.exchange(0, std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      return marked;
+    }
+
+    // a user (producer or poller) should wait for the set to be initialised and validate it
+    void wait_and_validate()
+    {
+      queue_type type = queue_type::None;
+      do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        type = header.type.load(std::memory_order_seq_cst);
+      } while (type == queue_type::None);
+
+      if (header.magic_number != common_header::HeaderMagicNumber) {
+        throw std::logic_error("bad magic number for header");
+      }
+      if (type != QueueType) {
+        throw std::logic_error("incorrect queue type");
+      }
+      if (header.max_producers != MaxQueues) {
+        throw std::logic_error("incorrect max producers");
+      }
+    }
+  };
+
+}  // namespace arquebus::impl
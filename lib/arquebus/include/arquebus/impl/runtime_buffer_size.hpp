@@ -0,0 +1,69 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+
+namespace arquebus::impl {
+
+  // __extension__ keeps -Wpedantic quiet, GCC and Clang both provide a 128 bit integer on 64 bit targets
+  __extension__ typedef unsigned __int128 uint128_t;  // NOLINT(*-use-using)
+
+  // The runtime equivalent of buffer_size, for queues whose size is only known once the header is read.
+  //
+  // Power of two sizes keep the mask. Any other size uses Lemire's fastmod: a multiply by a precomputed
+  // 128 bit reciprocal and a multiply high, which is a handful of cycles rather than the 20 to 90 of a 64 bit
+  // divide. See "Faster Remainder by Direct Computation" (Lemire, Kaser, Kurz 2019).
+  class runtime_buffer_size
+  {
+  public:
+    runtime_buffer_size() = default;
+
+    explicit runtime_buffer_size(std::uint64_t bytes)
+      : m_bytes(bytes)
+      , m_mask(bytes - 1)
+      , m_reciprocal(compute_reciprocal(bytes))
+      , m_isPowerOfTwo(std::has_single_bit(bytes))
+    {}
+
+    [[nodiscard]] auto bytes() const noexcept -> std::uint64_t { return m_bytes; }
+
+    [[nodiscard]] auto to_offset(std::uint64_t index) const noexcept -> std::uint64_t
+    {
+      if (m_isPowerOfTwo) [[likely]] {
+        return index bitand m_mask;
+      }
+      return fastmod(index);
+    }
+
+    [[nodiscard]] auto distance_to_buffer_start(std::uint64_t index) const noexcept -> std::uint64_t
+    {
+      return m_bytes - to_offset(index);
+    }
+
+  private:
+    std::uint64_t m_bytes{ 0 };
+    std::uint64_t m_mask{ 0 };
+    uint128_t m_reciprocal{ 0 };
+    bool m_isPowerOfTwo{ false };
+
+    static auto compute_reciprocal(std::uint64_t bytes) -> uint128_t
+    {
+      if (bytes == 0) {
+        throw std::invalid_argument("queue size must not be zero");
+      }
+      return (~static_cast<uint128_t>(0) / bytes) + 1;
+    }
+
+    [[nodiscard]] auto fastmod(std::uint64_t index) const noexcept -> std::uint64_t
+    {
+      constexpr auto Shift = 64U;
+      uint128_t const lowBits = m_reciprocal * index;
+      // the high 64 bits of the 192 bit product lowBits * m_bytes
+      uint128_t const bottom = (static_cast<std::uint64_t>(lowBits) * static_cast<uint128_t>(m_bytes)) >> Shift;
+      uint128_t const top = (lowBits >> Shift) * m_bytes;
+      return static_cast<std::uint64_t>((bottom + top) >> Shift);
+    }
+  };
+
+}  // namespace arquebus::impl
@@ -1,11 +1,22 @@
 #pragma once
 
+#include "arquebus/mapping_options.hpp"
 #include "fd_handle.hpp"
+#include "fd_passing.hpp"
+#include "numa.hpp"
 
 // POSIX
 #include <fcntl.h>
+#include <linux/magic.h>
+#include <linux/memfd.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
 #include <climits>
 #include <cstdint>
 #include <memory>
@@ -14,6 +25,7 @@
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <utility>
 
 namespace arquebus::impl {
 
@@ -23,9 +35,27 @@ namespace arquebus::impl {
     // shm namespace prefix for all shared memory objects created by this class
     static constexpr std::string_view ShmPrefix = "/arquebus_";
 
-    shared_memory_helper(std::string_view name, std::size_t mappingSize)
+    // A non zero mirrorSize maps the last mirrorSize bytes of the segment a second time, directly after the end
+    // of the mapping. A span that starts in that region can run past the end of the segment and continue from
+    // the start of the region, see mirrored_header.
+    shared_memory_helper(
+      std::string_view name,
+      std::size_t mappingSize,
+      mapping_options const &options = {},
+      std::size_t mirrorSize = 0
+    )
       : m_name{ make_shm_name(name) }
+      , m_hugePagePath{ make_huge_page_path(options.huge_page_mount, m_name) }
+      , m_hugePageMount{ options.huge_page_mount }
+      , m_transport{ options.transport }
+      , m_pages{ options.pages }
+      , m_populate{ options.populate }
+      , m_prefault{ options.prefault }
+      , m_lock{ options.lock }
+      , m_numa{ options.numa }
+      , m_numaNode{ options.numa_node }
       , m_mappingSize{ mappingSize }
+      , m_mirrorSize{ mirrorSize }
     {}
     ~shared_memory_helper() { close(); }
 
@@ -37,10 +67,22 @@ namespace arquebus::impl {
 
     [[nodiscard]] auto name() const -> std::string const & { return m_name; }
     [[nodiscard]] auto mapping() const -> void * { return m_mapping; }
+    // the page size backing the current mapping
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_pageSize; }
+    // the size of the current mapping, not including any mirror
+    [[nodiscard]] auto mapped_size() const -> std::size_t { return m_mappedSize; }
+    // the NUMA node the segment is bound to, or NoNumaNode
+    [[nodiscard]] auto numa_node() const -> std::int32_t
+    {
+      return m_numa == numa_placement::Bind ? static_cast<std::int32_t>(m_numaNode) : NoNumaNode;
+    }
+    // why huge pages were requested but not used, empty if they were not requested or are in use
+    [[nodiscard]] auto fallback_reason() const -> std::string_view { return m_fallbackReason; }
 
     void delete_existing()
     {
         ::shm_unlink(m_name.c_str());
+        ::unlink(m_hugePagePath.c_str());
     }
 
     // attempt to open and map the shared memory segment
@@ -50,15 +92,47 @@ namespace arquebus::impl {
         throw std::logic_error("Shared memory segment already exists");
       }
 
-      // attempt to open the shm object, but do not create it
-      fd_handle const shmFd{ ::shm_open(m_name.c_str(), O_RDWR, 0) };
+      fd_handle shmFd;
+      auto pageSize = system_page_size();
+      if (m_transport == segment_transport::MemFd) {
+        // ask the host for the descriptor, there is nothing to look up in the file system
+        shmFd.reset(request_fd(socket_name()));
+        if (shmFd >= 0) {
+          auto const seals = ::fcntl(shmFd, F_GET_SEALS);
+          if (seals < 0) {
+            throw std::runtime_error("Failed to query shared memory segment seals");
+          }
+          if ((seals & F_SEAL_SHRINK) == 0) {
+            throw std::runtime_error("Shared memory segment is not sealed");
+          }
+        }
+        pageSize = std::max(fd_page_size(shmFd), pageSize);
+      } else {
+        // attempt to open the shm object, but do not create it. If the host used huge pages it will be in the
+        // hugetlbfs mount instead.
+        shmFd.reset(::shm_open(m_name.c_str(), O_RDWR, 0));
+        if (shmFd < 0 and errno == ENOENT) {
+          shmFd.reset(::open(m_hugePagePath.c_str(), O_RDWR));
+          pageSize = std::max(huge_page_mount_page_size(m_hugePageMount), pageSize);
+        }
+      }
 
       if (shmFd < 0) {
         throw std::runtime_error("Failed to open shared memory segment");
       }
 
+      // the host may have rounded the segment up to a whole number of huge pages, map all of it.
+      struct stat status{};
+      if (::fstat(shmFd, &status) < 0) {
+        throw std::runtime_error("Failed to query shared memory segment");
+      }
+      auto const segmentSize = static_cast<std::size_t>(status.st_size);
+      if (segmentSize < m_mappingSize) {
+        throw std::runtime_error("Shared memory segment is too small");
+      }
+
       // create mapping
-      auto *memMapping = ::mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+      auto *memMapping = map_segment(shmFd, segmentSize, map_flags(false));
       if (memMapping == MAP_FAILED) {
         throw std::runtime_error("Failed to map shared memory segment");
       }
@@ -66,6 +140,10 @@ namespace arquebus::impl {
       // mapped
       m_isMappingOwner = false;
       m_mapping = memMapping;
+      m_mappedSize = segmentSize;
+      m_pageSize = pageSize;
+
+      prepare_mapping();
     }
 
     // attempt to create or open the shared memory segment as the owner
@@ -75,6 +153,15 @@ namespace arquebus::impl {
         throw std::logic_error("Shared memory segment already exists");
       }
 
+      if (m_transport == segment_transport::MemFd) {
+        create_memfd();
+        return;
+      }
+
+      if (m_pages != arquebus::page_size::Default and create_huge_pages()) {
+        return;
+      }
+
       // attempt to open or create the sgm object
       fd_handle const shmFd{ ::shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600) };
 
@@ -92,35 +179,297 @@ namespace arquebus::impl {
       }
 
       // create mapping
-      auto *memMapping = ::mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+      auto *memMapping = map_segment(shmFd, m_mappingSize, map_flags(true));
       if (memMapping == MAP_FAILED) {
         throw std::runtime_error("Failed to map shared memory segment");
       }
 
       // mapped
       m_isMappingOwner = true;
+      m_isHugePageBacked = false;
       m_mapping = memMapping;
+      m_mappedSize = m_mappingSize;
+      m_pageSize = system_page_size();
+
+      prepare_mapping();
     }
 
     // close the shared memory segment and unmap it
     // safe to call if already closed, or the open failed.
     void close()
     {
+      // stop handing out the descriptor before we close it
+      m_fdServer.reset();
+      m_memFd.reset();
+
       if (m_mapping != nullptr) {
-        ::munmap(m_mapping, m_mappingSize);
+        ::munmap(m_mapping, m_mappedSize + m_mirrorSize);
         m_mapping = nullptr;
       }
 
-      if (m_isMappingOwner) {
-        ::shm_unlink(m_name.c_str());
+      // a MemFd segment is anonymous, there is nothing to unlink
+      if (m_isMappingOwner and m_transport == segment_transport::Named) {
+        if (m_isHugePageBacked) {
+          ::unlink(m_hugePagePath.c_str());
+        } else {
+          ::shm_unlink(m_name.c_str());
+        }
       }
+      m_isMappingOwner = false;
     }
 
   private:
     std::string m_name;
+    std::string m_hugePagePath;
+    std::string m_hugePageMount;
+    segment_transport m_transport;
+    arquebus::page_size m_pages;
+    bool m_populate;
+    bool m_prefault;
+    bool m_lock;
+    numa_placement m_numa;
+    unsigned m_numaNode;
+    std::string_view m_fallbackReason;
     bool m_isMappingOwner{ false };
+    bool m_isHugePageBacked{ false };
     void *m_mapping{ nullptr };
     std::size_t const m_mappingSize;
+    std::size_t const m_mirrorSize;
+    // the mapping size rounded up to whole pages of the backing page size
+    std::size_t m_mappedSize{ 0 };
+    std::size_t m_pageSize{ 0 };
+    // only used by the owner of a MemFd segment
+    fd_handle m_memFd;
+    std::unique_ptr<fd_server> m_fdServer;
+
+    // the abstract socket name a MemFd segment is handed out on
+    [[nodiscard]] auto socket_name() const -> std::string_view { return std::string_view{ m_name }.substr(1); }
+
+    // Map the segment, and if required the mirror of its tail directly after it. For the mirror we reserve the
+    // whole address range first, then map the segment and the tail over it with MAP_FIXED, so nothing else can
+    // be mapped into the gap between them.
+    [[nodiscard]] auto map_segment(int fd, std::size_t size, int flags) const noexcept -> void *
+    {
+      if (m_mirrorSize == 0) {
+        return ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, fd, 0);
+      }
+
+      auto const pageSize = system_page_size();
+      if (m_mirrorSize > size or (m_mirrorSize % pageSize) != 0 or (size % pageSize) != 0) {
+        return MAP_FAILED;
+      }
+
+      auto *reserved = ::mmap(nullptr, size + m_mirrorSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if (reserved == MAP_FAILED) {
+        return MAP_FAILED;
+      }
+
+      auto *base = static_cast<std::byte *>(reserved);
+      auto const mirrorOffset = static_cast<off_t>(size - m_mirrorSize);
+      // NOLINTBEGIN(*-pointer-arithmetic)
+      if (
+        ::mmap(base, size, PROT_READ | PROT_WRITE, flags | MAP_FIXED, fd, 0) == MAP_FAILED
+        or ::mmap(base + size, m_mirrorSize, PROT_READ | PROT_WRITE, flags | MAP_FIXED, fd, mirrorOffset) == MAP_FAILED
+      ) {
+        ::munmap(reserved, size + m_mirrorSize);
+        return MAP_FAILED;
+      }
+      // NOLINTEND(*-pointer-arithmetic)
+
+      return reserved;
+    }
+
+    // MAP_POPULATE would fault the pages in before we can set the NUMA placement, so when there is a placement
+    // to apply the mapping is prefaulted after it instead.
+    [[nodiscard]] auto populate_after_mapping(bool isOwner) const noexcept -> bool
+    {
+      return m_populate and isOwner and m_numa != numa_placement::Default;
+    }
+
+    [[nodiscard]] auto map_flags(bool isOwner) const noexcept -> int
+    {
+      return m_populate and not populate_after_mapping(isOwner) ? MAP_SHARED | MAP_POPULATE : MAP_SHARED;
+    }
+
+    // move the page fault cost of the mapping to now, rather than the first lap of the queue
+    void prepare_mapping()
+    {
+      if (m_isMappingOwner) {
+        apply_numa_placement(m_mapping, m_mappedSize, m_numa, m_numaNode);
+      }
+
+      if (m_prefault or populate_after_mapping(m_isMappingOwner)) {
+        prefault();
+      }
+
+      if (m_lock and ::mlock(m_mapping, m_mappedSize + m_mirrorSize) < 0) {
+        throw std::runtime_error("Failed to lock shared memory segment");
+      }
+    }
+
+    void prefault() const noexcept
+    {
+#ifdef MADV_POPULATE_WRITE
+      // fault every page in writable without touching the contents (Linux 5.14+)
+      if (::madvise(m_mapping, m_mappedSize + m_mirrorSize, MADV_POPULATE_WRITE) == 0) {
+        return;
+      }
+#endif
+      // Older kernels, read every page. The other processes may already be using the queue so we can not
+      // write to it. On a shared mapping of shm or hugetlbfs this maps the page writable as well.
+      auto const *bytes = static_cast<std::byte const volatile *>(m_mapping);
+      for (std::size_t offset = 0; offset < m_mappedSize + m_mirrorSize; offset += m_pageSize) {
+        static_cast<void>(bytes[offset]);  // NOLINT(*-pointer-arithmetic)
+      }
+    }
+
+    static auto system_page_size() noexcept -> std::size_t
+    {
+      return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    }
+
+    static auto requested_page_size(arquebus::page_size pages) noexcept -> std::size_t
+    {
+      constexpr std::size_t Huge2MiB = std::size_t{ 2 } << 20U;
+      constexpr std::size_t Huge1GiB = std::size_t{ 1 } << 30U;
+      return pages == arquebus::page_size::Huge1GiB ? Huge1GiB : Huge2MiB;
+    }
+
+    // the page size of a hugetlbfs mount, or zero if the path is not a hugetlbfs mount
+    static auto huge_page_mount_page_size(std::string const &mount) noexcept -> std::size_t
+    {
+      struct statfs fs{};
+      if (::statfs(mount.c_str(), &fs) < 0 or fs.f_type != HUGETLBFS_MAGIC) {
+        return 0;
+      }
+      return static_cast<std::size_t>(fs.f_bsize);
+    }
+
+    // Try to create the segment as a file in the hugetlbfs mount. The huge pages are reserved when the file is
+    // mapped, so if there are not enough free huge pages we find out here rather than by a SIGBUS on first
+    // touch. Returns false, with the reason recorded, if we should fall back to normal shared memory.
+    auto create_huge_pages() -> bool
+    {
+      if (m_mirrorSize != 0) {
+        m_fallbackReason = "mirrored segments do not support huge pages";
+        return false;
+      }
+
+      auto const pageSize = requested_page_size(m_pages);
+      auto const mountPageSize = huge_page_mount_page_size(m_hugePageMount);
+      if (mountPageSize == 0) {
+        m_fallbackReason = "huge page mount is not a hugetlbfs file system";
+        return false;
+      }
+      if (mountPageSize != pageSize) {
+        m_fallbackReason = "huge page mount has a different page size";
+        return false;
+      }
+
+      fd_handle const fd{ ::open(m_hugePagePath.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600) };
+      if (fd < 0) {
+        if (errno == EEXIST) {
+          throw std::runtime_error("Shared memory segment already exists");
+        }
+        m_fallbackReason = "unable to create file in huge page mount";
+        return false;
+      }
+
+      auto const mappedSize = (m_mappingSize + pageSize - 1) & ~(pageSize - 1);
+      void *memMapping = MAP_FAILED;
+      if (::ftruncate(fd, static_cast<std::int64_t>(mappedSize)) == 0) {
+        memMapping = map_segment(fd, mappedSize, map_flags(true));
+      }
+      if (memMapping == MAP_FAILED) {
+        ::unlink(m_hugePagePath.c_str());
+        m_fallbackReason = "not enough free huge pages";
+        return false;
+      }
+
+      m_isMappingOwner = true;
+      m_isHugePageBacked = true;
+      m_mapping = memMapping;
+      m_mappedSize = mappedSize;
+      m_pageSize = pageSize;
+      m_fallbackReason = {};
+
+      prepare_mapping();
+      return true;
+    }
+
+    // the page size backing a descriptor, or zero if it is not on hugetlbfs
+    static auto fd_page_size(int fd) noexcept -> std::size_t
+    {
+      struct statfs fs{};
+      if (::fstatfs(fd, &fs) < 0 or fs.f_type != HUGETLBFS_MAGIC) {
+        return 0;
+      }
+      return static_cast<std::size_t>(fs.f_bsize);
+    }
+
+    // Create the segment as a sealed memfd and start handing its descriptor out. Huge pages come from the
+    // kernel's hugetlb pool directly, no hugetlbfs mount is needed.
+    void create_memfd()
+    {
+      if (m_pages != arquebus::page_size::Default) {
+        if (m_mirrorSize != 0) {
+          m_fallbackReason = "mirrored segments do not support huge pages";
+        } else {
+          auto const hugeFlags =
+            MFD_HUGETLB | (m_pages == arquebus::page_size::Huge1GiB ? MFD_HUGE_1GB : MFD_HUGE_2MB);
+          if (not open_memfd(hugeFlags, requested_page_size(m_pages))) {
+            m_fallbackReason = "not enough free huge pages";
+          }
+        }
+      }
+
+      if (m_mapping == nullptr and not open_memfd(0, system_page_size())) {
+        throw std::runtime_error("Failed to create shared memory segment");
+      }
+
+      prepare_mapping();
+
+      // fails if another host is already serving this name
+      try {
+        m_fdServer = std::make_unique<fd_server>(socket_name(), m_memFd);
+      } catch (...) {
+        close();
+        throw;
+      }
+    }
+
+    // The size is sealed so a user can never see the segment shrink under its mapping, which would SIGBUS.
+    auto open_memfd(unsigned flags, std::size_t pageSize) -> bool
+    {
+      fd_handle fd{ ::memfd_create(socket_name().data(), MFD_CLOEXEC | MFD_ALLOW_SEALING | flags) };
+      if (fd < 0) {
+        return false;
+      }
+
+      auto const mappedSize = (m_mappingSize + pageSize - 1) & ~(pageSize - 1);
+      if (
+        ::ftruncate(fd, static_cast<std::int64_t>(mappedSize)) < 0
+        or ::fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0
+      ) {
+        return false;
+      }
+
+      auto *memMapping = map_segment(fd, mappedSize, map_flags(true));
+      if (memMapping == MAP_FAILED) {
+        return false;
+      }
+
+      m_isMappingOwner = true;
+      m_isHugePageBacked = (flags & MFD_HUGETLB) != 0;
+      m_mapping = memMapping;
+      m_mappedSize = mappedSize;
+      m_pageSize = pageSize;
+      m_memFd = std::move(fd);
+      if (m_isHugePageBacked) {
+        m_fallbackReason = {};
+      }
+      return true;
+    }
 
     static auto make_shm_name(std::string_view name) -> std::string
     {
@@ -133,16 +482,30 @@ namespace arquebus::impl {
 
       return fullName;
     }
+
+    static auto make_huge_page_path(std::string_view mount, std::string const &shmName) -> std::string
+    {
+      std::string path{ mount };
+      path.append(shmName);
+      return path;
+    }
   };
 
 
+  // A non zero trailingBytes sizes the segment for a T followed by that many bytes, for layouts whose data
+  // region is only known at runtime.
   template<typename T>
     requires std::is_trivially_copyable_v<T>
   class shared_memory_owner
   {
   public:
-    explicit shared_memory_owner(std::string_view name)
-      : m_sharedMemory{ name, sizeof(T) }
+    explicit shared_memory_owner(
+      std::string_view name,
+      mapping_options const &options = {},
+      std::size_t mirrorSize = 0,
+      std::size_t trailingBytes = 0
+    )
+      : m_sharedMemory{ name, sizeof(T) + trailingBytes, options, mirrorSize }
     {}
     ~shared_memory_owner() = default;
 
@@ -165,6 +528,9 @@ namespace arquebus::impl {
 
     [[nodiscard]] auto name() const -> std::string const & { return m_sharedMemory.name(); }
     [[nodiscard]] auto mapping() const -> T * { return m_mapping; }
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_sharedMemory.page_size(); }
+    [[nodiscard]] auto fallback_reason() const -> std::string_view { return m_sharedMemory.fallback_reason(); }
+    [[nodiscard]] auto numa_node() const -> std::int32_t { return m_sharedMemory.numa_node(); }
 
     void close() { m_sharedMemory.close(); }
 
@@ -180,8 +546,8 @@ namespace arquebus::impl {
   {
 
   public:
-    explicit shared_memory_user(std::string_view name)
-      : m_sharedMemory{ name, sizeof(T) }
+    explicit shared_memory_user(std::string_view name, mapping_options const &options = {}, std::size_t mirrorSize = 0)
+      : m_sharedMemory{ name, sizeof(T), options, mirrorSize }
     {}
     ~shared_memory_user() = default;
 
@@ -208,6 +574,9 @@ namespace arquebus::impl {
 
     [[nodiscard]] auto name() const -> std::string const & { return m_sharedMemory.name(); }
     [[nodiscard]] auto mapping() const -> T * { return m_mapping; }
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_sharedMemory.page_size(); }
+    // the whole segment is mapped, which may be larger than sizeof(T) for runtime sized layouts
+    [[nodiscard]] auto mapped_size() const -> std::size_t { return m_sharedMemory.mapped_size(); }
 
     void close() { m_sharedMemory.close(); }
 
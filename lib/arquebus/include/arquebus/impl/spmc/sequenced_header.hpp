@@ -0,0 +1,188 @@
+#pragma once
+
+#include "arquebus/impl/buffer_size.hpp"
+#include "arquebus/impl/common_header.hpp"
+#include "arquebus/impl/queue_type.hpp"
+#include "arquebus/version.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+namespace arquebus::impl::spmc {
+
+  // The state for one consumer stage of a sequenced queue. Each stage has a cache line of its own so the
+  // only writer of the line is the stage that owns it.
+  template<std::size_t CacheLineSize>
+  struct alignas(CacheLineSize) stage_state
+  {
+    // The number of messages this stage has finished with. Stages that depend on this one, and the
+    // producer, gate on this value.
+    std::atomic_uint64_t sequence;
+    // Bit mask of the stages this stage must wait for. A stage with no dependencies waits on the producer.
+    std::uint64_t dependencies;
+    // set while a consumer is attached as this stage
+    std::atomic_bool attached;
+  };
+
+
+  // A fixed slot ring shared by a producer and a set of consumer stages. Messages are written once by the
+  // producer and then processed in place by each stage in turn. A stage may only read a message once all
+  // the stages it depends on have finished with it, and the producer may only reuse a slot once every
+  // stage has finished with it.
+  //
+  // All indices are message sequence numbers, the buffer_size is the number of slots so the generation
+  // and offset split gives the lap and slot for a sequence.
+  template<typename T, std::uint8_t Size2NBits, std::size_t MaxStages, std::size_t CacheLineSize>
+    requires std::is_trivially_copyable_v<T>
+  struct sequenced_header
+  {
+    using Message = T;
+    using BufferSize = buffer_size<Size2NBits>;
+    using Stage = stage_state<CacheLineSize>;
+    using Dependencies = std::array<std::uint64_t, MaxStages>;
+
+    static constexpr auto QueueType = queue_type::SingleProducerMultiConsumerSequencedFixedMessageLength;
+    static constexpr auto SlotSize = std::uint64_t{ sizeof(T) };
+    static constexpr auto SlotAlignment = std::max(alignof(T), CacheLineSize);
+
+    static_assert(MaxStages > 0, "At least one stage must be supported");
+    static_assert(MaxStages <= std::numeric_limits<std::uint64_t>::digits, "Too many stages");
+
+    static constexpr auto AllStages = [] {
+      if constexpr (MaxStages == std::numeric_limits<std::uint64_t>::digits) {
+        return std::numeric_limits<std::uint64_t>::max();
+      } else {
+        return (std::uint64_t{ 1 } << MaxStages) - 1;
+      }
+    }();
+
+    common_header header{};
+    // The number of messages the producer has published.
+    alignas(CacheLineSize) std::atomic_uint64_t cursor{ 0 };
+    // NOLINTNEXTLINE(*-avoid-c-arrays)
+    Stage stages[MaxStages];
+
+    // we are using C-style array to avoid initialisation, it will be zero filled when we
+    // map it into memory as a shared memory region
+    // NOLINTNEXTLINE(*-avoid-c-arrays)
+    alignas(SlotAlignment) std::byte data[BufferSize::Bytes * SlotSize];
+
+    [[nodiscard]] auto slot(std::uint64_t index) noexcept -> std::byte *
+    {
+      return &data[BufferSize::to_offset(index) * SlotSize];
+    }
+
+    // the stages that no other stage depends on, the producer only needs to gate on these as every other
+    // stage is at least as far along as the stages that depend on it.
+    [[nodiscard]] auto final_stages() const noexcept -> std::uint64_t
+    {
+      std::uint64_t dependedOn = 0;
+      for (auto const &stage : stages) {
+        dependedOn |= stage.dependencies;
+      }
+      return ~dependedOn & AllStages;
+    }
+
+    // the lowest sequence of all the stages in the mask
+    [[nodiscard]] auto minimum_sequence(std::uint64_t stageMask) const noexcept -> std::uint64_t
+    {
+      auto minimum = std::numeric_limits<std::uint64_t>::max();
+      while (stageMask != 0) {
+        auto const stage = static_cast<std::size_t>(std::countr_zero(stageMask));
+        minimum = std::min(minimum, stages[stage].sequence.load(std::memory_order_acquire));
+        stageMask &= stageMask - 1;
+      }
+      return minimum;
+    }
+
+    // the owner should initialise the queue
+    //
+    // Stages may only depend on stages with a lower index, this keeps the dependency graph acyclic.
+    void initialise(Dependencies const &dependencies)
+    {
+      auto type = header.type.load(std::memory_order_acquire);
+      if (type != queue_type::None) {
+        throw std::logic_error("queue is already initialised");
+      }
+
+      for (std::size_t i = 0; i < MaxStages; ++i) {
+        if ((dependencies.at(i) >> i) != 0) {
+          throw std::invalid_argument("stages may only depend on stages with a lower index");
+        }
+      }
+
+      header.arquebus_version = version_details{}.version;
+      header.message_size_type_size = 0;
+      header.message_size = sizeof(T);
+      header.message_alignment = alignof(T);
+      header.max_producers = 1;
+      header.max_consumers = MaxStages;
+      header.size_of_queue = BufferSize::Bytes;
+
+      for (std::size_t i = 0; i < MaxStages; ++i) {
+        stages[i].dependencies = dependencies.at(i);
+        stages[i].sequence.store(0, std::memory_order_relaxed);
+        stages[i].attached.store(false, std::memory_order_relaxed);
+      }
+
+      cursor.store(0, std::memory_order_release);
+      header.type.store(QueueType, std::memory_order_release);
+    }
+
+
+    // a user (producer or consumer) should wait for the queue to be initialised and
+    // validate that it meets expectations.
+    void wait_and_validate()
+    {
+      queue_type type = queue_type::None;
+      do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        type = header.type.load(std::memory_order_seq_cst);
+      } while (type == queue_type::None);
+
+      // owner has initialised
+      if (header.magic_number != common_header::HeaderMagicNumber) {
+        throw std::logic_error("bad magic number for header");
+      }
+      if (type != QueueType) {
+        throw std::logic_error("incorrect queue type");
+      }
+      if (header.message_size != sizeof(T) or header.message_alignment != alignof(T)) {
+        throw std::logic_error("incorrect message type");
+      }
+      if (header.max_producers != 1) {
+        throw std::logic_error("incorrect max producers");
+      }
+      if (header.max_consumers != MaxStages) {
+        throw std::logic_error("incorrect max consumers");
+      }
+      if (header.size_of_queue != BufferSize::Bytes) {
+        throw std::logic_error("incorrect size of queue");
+      }
+    }
+
+    // claim a stage for a consumer, fails if the stage is already in use
+    void register_stage(std::size_t stage)
+    {
+      if (stage >= MaxStages) {
+        throw std::invalid_argument("invalid stage");
+      }
+      if (stages[stage].attached.exchange(true, std::memory_order_acq_rel)) {
+        throw std::runtime_error("stage already attached");
+      }
+    }
+
+    void unregister_stage(std::size_t stage) noexcept { stages[stage].attached.store(false, std::memory_order_release); }
+  };
+
+}  // namespace arquebus::impl::spmc
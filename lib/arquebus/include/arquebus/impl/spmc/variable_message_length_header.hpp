@@ -0,0 +1,125 @@
+#pragma once
+
+#include "arquebus/impl/buffer_size.hpp"
+#include "arquebus/impl/common_header.hpp"
+#include "arquebus/impl/queue_type.hpp"
+#include "arquebus/version.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+namespace arquebus::impl::spmc {
+
+  // The broadcast queue uses exactly the same framing as the SPSC variable message length queue. Each
+  // message is written once by the producer and every consumer reads the same ring, tracking its own
+  // read position privately. The only shared state a consumer touches is the attachment count, which
+  // is only used during attach and detach.
+  template<
+    std::uint8_t Size2NBits,
+    std::size_t MaxConsumers,
+    std::unsigned_integral TMessageSize,
+    std::size_t CacheLineSize>
+  struct variable_message_length_header
+  {
+    using MessageSize = TMessageSize;
+    using BufferSize = buffer_size<Size2NBits>;
+
+    static constexpr auto QueueType = queue_type::SingleProducerMultiConsumerVariableMessageLength;
+
+    static_assert(MaxConsumers > 0, "At least one consumer must be supported");
+
+    // The largest frame the producer can write, half a lap after the first size, and the largest message that
+    // fits in it. See impl::spsc::variable_message_length_header::MaxFrameSize.
+    static constexpr std::uint64_t MaxFrameSize = (BufferSize::Bytes - (2 * sizeof(MessageSize))) / 2;
+    static constexpr std::uint64_t MaxMessageSize =
+      std::min<std::uint64_t>(MaxFrameSize - sizeof(MessageSize), std::numeric_limits<MessageSize>::max());
+
+    common_header header{};
+    // The write index is what the producer has "reserved" up to and, it will be writing into these bytes
+    alignas(CacheLineSize) std::atomic_uint64_t write_index{ 0 };
+    // The read index is what the producer has "released" to the consumers as valid message data.
+    alignas(CacheLineSize) std::atomic_uint64_t read_index{ 0 };
+    // The number of consumers currently attached. Kept away from the indices so attach/detach does not
+    // disturb the producer.
+    alignas(CacheLineSize) std::atomic_uint64_t attached_consumers{ 0 };
+
+    // we are using C-style array to avoid initialisation, it will be zero filled when we
+    // map it into memory as a shared memory region
+    // NOLINTNEXTLINE(*-avoid-c-arrays)
+    alignas(CacheLineSize) std::byte data[BufferSize::Bytes];
+
+
+    // the owner should initialise the queue
+    void initialise()
+    {
+      auto type = header.type.load(std::memory_order_acquire);
+      if (type != queue_type::None) {
+        throw std::logic_error("queue is already initialised");
+      }
+
+      header.arquebus_version = version_details{}.version;
+      header.message_size_type_size = sizeof(MessageSize);
+      header.max_producers = 1;
+      header.max_consumers = MaxConsumers;
+      header.size_of_queue = BufferSize::Bytes;
+
+      write_index.store(0, std::memory_order_release);
+      read_index.store(0, std::memory_order_release);
+      attached_consumers.store(0, std::memory_order_release);
+      header.type.store(QueueType, std::memory_order_release);
+    }
+
+
+    // a user (producer or consumer) should wait for the queue to be initialised and
+    // validate that it meets expectations.
+    void wait_and_validate()
+    {
+      queue_type type = queue_type::None;
+      do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        type = header.type.load(std::memory_order_seq_cst);
+      } while (type == queue_type::None);
+
+      // owner has initialised
+      if (header.magic_number != common_header::HeaderMagicNumber) {
+        throw std::logic_error("bad magic number for header");
+      }
+      if (type != QueueType) {
+        throw std::logic_error("incorrect queue type");
+      }
+      if (header.message_size_type_size != sizeof(MessageSize)) {
+        throw std::logic_error("incorrect message size type");
+      }
+      if (header.max_producers != 1) {
+        throw std::logic_error("incorrect max producers");
+      }
+      if (header.max_consumers != MaxConsumers) {
+        throw std::logic_error("incorrect max consumers");
+      }
+      if (header.size_of_queue != BufferSize::Bytes) {
+        throw std::logic_error("incorrect size of queue");
+      }
+    }
+
+    // register a consumer, fails if the maximum number of consumers are already attached
+    void register_consumer()
+    {
+      auto attached = attached_consumers.load(std::memory_order_relaxed);
+      do {
+        if (attached >= MaxConsumers) {
+          throw std::runtime_error("maximum number of consumers already attached");
+        }
+      } while (not attached_consumers.compare_exchange_weak(attached, attached + 1, std::memory_order_acq_rel));
+    }
+
+    void unregister_consumer() noexcept { attached_consumers.fetch_sub(1, std::memory_order_acq_rel); }
+  };
+
+}  // namespace arquebus::impl::spmc
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "arquebus/impl/buffer_size.hpp"
+#include "arquebus/impl/common_header.hpp"
+#include "arquebus/impl/queue_type.hpp"
+#include "arquebus/version.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+namespace arquebus::impl::spmc {
+
+  // Each slot carries its own sequence number which tells the producer and the consumers who owns it:
+  //
+  // * sequence == index            the slot is free for the producer to write the message at index
+  // * sequence == index + 1        the message at index has been published and can be claimed
+  // * sequence == index + Slots    the message has been consumed and the slot is free for the next lap
+  //
+  // Consumers compete for messages with a CAS on the shared claim index. Once a consumer wins the claim
+  // for an index, it is the only one that will touch that slot until it hands it back to the producer by
+  // advancing the sequence. There is no lock shared between consumers, and the producer never writes
+  // the claim index.
+  template<typename T, std::size_t CacheLineSize>
+    requires std::is_trivially_copyable_v<T>
+  struct alignas(CacheLineSize) work_slot
+  {
+    std::atomic_uint64_t sequence;
+    // raw storage, the producer constructs the message in place
+    // NOLINTNEXTLINE(*-avoid-c-arrays)
+    alignas(T) std::byte message[sizeof(T)];
+  };
+
+
+  template<typename T, std::uint8_t Size2NBits, std::size_t MaxConsumers, std::size_t CacheLineSize>
+    requires std::is_trivially_copyable_v<T>
+  struct work_distribution_header
+  {
+    using Message = T;
+    using BufferSize = buffer_size<Size2NBits>;
+    using Slot = work_slot<T, CacheLineSize>;
+
+    static constexpr auto QueueType = queue_type::SingleProducerMultiConsumerWorkDistributionFixedMessageLength;
+
+    static_assert(MaxConsumers > 0, "At least one consumer must be supported");
+    // with one slot index + 1 and index + Slots are the same, published and consumed could not be told apart
+    static_assert(Size2NBits > 0, "At least two slots are required");
+
+    common_header header{};
+    // The next message index to be claimed by a consumer.
+    alignas(CacheLineSize) std::atomic_uint64_t claim_index{ 0 };
+    // The number of consumers currently attached.
+    alignas(CacheLineSize) std::atomic_uint64_t attached_consumers{ 0 };
+
+    // we are using C-style array to avoid initialisation, the sequence numbers are set by initialise()
+    // NOLINTNEXTLINE(*-avoid-c-arrays)
+    Slot slots[BufferSize::Bytes];
+
+    [[nodiscard]] auto slot(std::uint64_t index) noexcept -> Slot & { return slots[BufferSize::to_offset(index)]; }
+
+    // the owner should initialise the queue
+    void initialise()
+    {
+      auto type = header.type.load(std::memory_order_acquire);
+      if (type != queue_type::None) {
+        throw std::logic_error("queue is already initialised");
+      }
+
+      header.arquebus_version = version_details{}.version;
+      header.message_size_type_size = 0;
+      header.message_size = sizeof(T);
+      header.message_alignment = alignof(T);
+      header.max_producers = 1;
+      header.max_consumers = MaxConsumers;
+      header.size_of_queue = BufferSize::Bytes;
+
+      // every slot starts free for the first lap
+      for (std::uint64_t i = 0; i < BufferSize::Bytes; ++i) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+      }
+
+      claim_index.store(0, std::memory_order_release);
+      attached_consumers.store(0, std::memory_order_release);
+      header.type.store(QueueType, std::memory_order_release);
+    }
+
+
+    // a user (producer or consumer) should wait for the queue to be initialised and
+    // validate that it meets expectations.
+    void wait_and_validate()
+    {
+      queue_type type = queue_type::None;
+      do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        type = header.type.load(std::memory_order_seq_cst);
+      } while (type == queue_type::None);
+
+      // owner has initialised
+      if (header.magic_number != common_header::HeaderMagicNumber) {
+        throw std::logic_error("bad magic number for header");
+      }
+      if (type != QueueType) {
+        throw std::logic_error("incorrect queue type");
+      }
+      if (header.message_size != sizeof(T) or header.message_alignment != alignof(T)) {
+        throw std::logic_error("incorrect message type");
+      }
+      if (header.max_producers != 1) {
+        throw std::logic_error("incorrect max producers");
+      }
+      if (header.max_consumers != MaxConsumers) {
+        throw std::logic_error("incorrect max consumers");
+      }
+      if (header.size_of_queue != BufferSize::Bytes) {
+        throw std::logic_error("incorrect size of queue");
+      }
+    }
+
+    // register a consumer, fails if the maximum number of consumers are already attached
+    void register_consumer()
+    {
+      auto attached = attached_consumers.load(std::memory_order_relaxed);
+      do {
+        if (attached >= MaxConsumers) {
+          throw std::runtime_error("maximum number of consumers already attached");
+        }
+      } while (not attached_consumers.compare_exchange_weak(attached, attached + 1, std::memory_order_acq_rel));
+    }
+
+    void unregister_consumer() noexcept { attached_consumers.fetch_sub(1, std::memory_order_acq_rel); }
+  };
+
+}  // namespace arquebus::impl::spmc
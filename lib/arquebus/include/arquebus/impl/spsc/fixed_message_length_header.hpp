@@ -0,0 +1,104 @@
+#pragma once
+
+#include "arquebus/impl/buffer_size.hpp"
+#include "arquebus/impl/common_header.hpp"
+#include "arquebus/impl/queue_type.hpp"
+#include "arquebus/version.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+namespace arquebus::impl::spsc {
+
+  // Fixed length messages are stored in an array of slots, one message per slot. The indices count
+  // slots rather than bytes, so the buffer_size is the number of slots in the queue. There is no size
+  // prefix and no skip marker, every slot is naturally aligned for T and a message can never straddle
+  // the end of the buffer.
+  template<typename T, std::uint8_t Size2NBits, std::size_t CacheLineSize>
+    requires std::is_trivially_copyable_v<T>
+  struct fixed_message_length_header
+  {
+    using Message = T;
+    using BufferSize = buffer_size<Size2NBits>;
+
+    static constexpr auto QueueType = queue_type::SingleProducerSingleConsumerFixedMessageLength;
+    static constexpr auto SlotSize = std::uint64_t{ sizeof(T) };
+    static constexpr auto SlotAlignment = std::max(alignof(T), CacheLineSize);
+
+    common_header header{};
+    // The write index is the slot the producer has "reserved" up to and, it will be writing into these slots
+    alignas(CacheLineSize) std::atomic_uint64_t write_index{ 0 };
+    // The read index is the slot the producer has "released" to the consumer as valid messages.
+    alignas(CacheLineSize) std::atomic_uint64_t read_index{ 0 };
+
+    // we are using C-style array to avoid initialisation, it will be zero filled when we
+    // map it into memory as a shared memory region
+    // NOLINTNEXTLINE(*-avoid-c-arrays)
+    alignas(SlotAlignment) std::byte data[BufferSize::Bytes * SlotSize];
+
+    [[nodiscard]] auto slot(std::uint64_t index) noexcept -> std::byte *
+    {
+      return &data[BufferSize::to_offset(index) * SlotSize];
+    }
+
+    // the owner should initialise the queue
+    void initialise()
+    {
+      auto type = header.type.load(std::memory_order_acquire);
+      if (type != queue_type::None) {
+        throw std::logic_error("queue is already initialised");
+      }
+
+      header.arquebus_version = version_details{}.version;
+      header.message_size_type_size = 0;
+      header.message_size = sizeof(T);
+      header.message_alignment = alignof(T);
+      header.max_producers = 1;
+      header.max_consumers = 1;
+      header.size_of_queue = BufferSize::Bytes;
+
+      write_index.store(0, std::memory_order_release);
+      read_index.store(0, std::memory_order_release);
+      header.type.store(QueueType, std::memory_order_release);
+    }
+
+
+    // a user (producer or consumer) should wait for the queue to be initialised and
+    // validate that it meets expectations.
+    void wait_and_validate()
+    {
+      queue_type type = queue_type::None;
+      do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        type = header.type.load(std::memory_order_seq_cst);
+      } while (type == queue_type::None);
+
+      // owner has initialised
+      if (header.magic_number != common_header::HeaderMagicNumber) {
+        throw std::logic_error("bad magic number for header");
+      }
+      if (type != QueueType) {
+        throw std::logic_error("incorrect queue type");
+      }
+      if (header.message_size != sizeof(T) or header.message_alignment != alignof(T)) {
+        throw std::logic_error("incorrect message type");
+      }
+      if (header.max_producers != 1) {
+        throw std::logic_error("incorrect max producers");
+      }
+      if (header.max_consumers != 1) {
+        throw std::logic_error("incorrect max consumers");
+      }
+      if (header.size_of_queue != BufferSize::Bytes) {
+        throw std::logic_error("incorrect size of queue");
+      }
+    }
+  };
+
+}  // namespace arquebus::impl::spsc
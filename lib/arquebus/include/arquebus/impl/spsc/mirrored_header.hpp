@@ -0,0 +1,111 @@
+#pragma once
+
+#include "arquebus/impl/buffer_size.hpp"
+#include "arquebus/impl/common_header.hpp"
+#include "arquebus/impl/queue_type.hpp"
+#include "arquebus/version.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+namespace arquebus::impl::spsc {
+
+  // The same protocol as the variable_message_length_header, but the data region is mapped twice, back to
+  // back, in virtual memory (see shared_memory_helper). A message that runs past the end of data[] carries
+  // on in the second mapping, which is the same physical memory as the start of data[]. So there is no skip
+  // marker at the end of a lap, every byte of the queue is usable and a message can be almost as large as
+  // the queue.
+  //
+  // The indices are exact byte counts, the read index can never be further than the size of the queue
+  // behind the write index without the consumer having been overrun.
+  //
+  // The data region has to start on a page boundary and be a whole number of pages, it is the last member
+  // so the mirror can be mapped from the end of the segment.
+  template<std::uint8_t Size2NBits, std::unsigned_integral TMessageSize, std::size_t CacheLineSize>
+  struct mirrored_header
+  {
+    using MessageSize = TMessageSize;
+    using BufferSize = buffer_size<Size2NBits>;
+
+    static constexpr auto QueueType = queue_type::SingleProducerSingleConsumerMirroredVariableMessageLength;
+    // the smallest page size we support, mapping will fail on systems with larger pages
+    static constexpr std::size_t PageSize = 4096;
+    static constexpr std::size_t MirrorSize = BufferSize::Bytes;
+
+    static_assert(BufferSize::Bytes >= PageSize, "A mirrored queue must be at least one page");
+
+    common_header header{};
+    // The write index is what the producer has "reserved" up to and, it will be writing into these bytes
+    alignas(CacheLineSize) std::atomic_uint64_t write_index{ 0 };
+    // The read index is what the producer has "released" to the consumer as valid message data.
+    alignas(CacheLineSize) std::atomic_uint64_t read_index{ 0 };
+
+    // we are using C-style array to avoid initialisation, it will be zero filled when we
+    // map it into memory as a shared memory region. The mirror follows it directly in the mapping.
+    // NOLINTNEXTLINE(*-avoid-c-arrays)
+    alignas(PageSize) std::byte data[BufferSize::Bytes];
+
+    // a pointer to the byte at index, up to the size of the queue can be addressed from here
+    [[nodiscard]] auto at(std::uint64_t index) noexcept -> std::byte *
+    {
+      return &data[BufferSize::to_offset(index)];
+    }
+
+    // the owner should initialise the queue
+    void initialise()
+    {
+      auto type = header.type.load(std::memory_order_acquire);
+      if (type != queue_type::None) {
+        throw std::logic_error("queue is already initialised");
+      }
+
+      header.arquebus_version = version_details{}.version;
+      header.message_size_type_size = sizeof(MessageSize);
+      header.max_producers = 1;
+      header.max_consumers = 1;
+      header.size_of_queue = BufferSize::Bytes;
+
+      write_index.store(0, std::memory_order_release);
+      read_index.store(0, std::memory_order_release);
+      header.type.store(QueueType, std::memory_order_release);
+    }
+
+
+    // a user (producer or consumer) should wait for the queue to be initialised and
+    // validate that it meets expectations.
+    void wait_and_validate()
+    {
+      queue_type type = queue_type::None;
+      do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        type = header.type.load(std::memory_order_seq_cst);
+      } while (type == queue_type::None);
+
+      // owner has initialised
+      if (header.magic_number != common_header::HeaderMagicNumber) {
+        throw std::logic_error("bad magic number for header");
+      }
+      if (type != QueueType) {
+        throw std::logic_error("incorrect queue type");
+      }
+      if (header.message_size_type_size != sizeof(MessageSize)) {
+        throw std::logic_error("incorrect message size type");
+      }
+      if (header.max_producers != 1) {
+        throw std::logic_error("incorrect max producers");
+      }
+      if (header.max_consumers != 1) {
+        throw std::logic_error("incorrect max consumers");
+      }
+      if (header.size_of_queue != BufferSize::Bytes) {
+        throw std::logic_error("incorrect size of queue");
+      }
+    }
+  };
+
+}  // namespace arquebus::impl::spsc
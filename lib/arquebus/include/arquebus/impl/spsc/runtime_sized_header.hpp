@@ -0,0 +1,97 @@
+#pragma once
+
+#include "arquebus/impl/common_header.hpp"
+#include "arquebus/impl/queue_type.hpp"
+#include "arquebus/version.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+namespace arquebus::impl::spsc {
+
+  // The same protocol as the variable_message_length_header, but the size of the data region is chosen by
+  // the host at runtime and published in header.size_of_queue. The producer and consumer read it at attach,
+  // so the queue can be resized without recompiling them.
+  //
+  // The data region is not part of the struct, it directly follows it in the shared memory segment. The
+  // struct is cache line aligned so the data region starts on a cache line as well.
+  template<std::unsigned_integral TMessageSize, std::size_t CacheLineSize>
+  struct alignas(CacheLineSize) runtime_sized_header
+  {
+    using MessageSize = TMessageSize;
+
+    static constexpr auto QueueType = queue_type::SingleProducerSingleConsumerRuntimeSizedVariableMessageLength;
+
+    common_header header{};
+    // The write index is what the producer has "reserved" up to and, it will be writing into these bytes
+    alignas(CacheLineSize) std::atomic_uint64_t write_index{ 0 };
+    // The read index is what the producer has "released" to the consumer as valid message data.
+    alignas(CacheLineSize) std::atomic_uint64_t read_index{ 0 };
+
+    // the first byte of the data region, size_of_queue bytes long
+    [[nodiscard]] auto data() noexcept -> std::byte *
+    {
+      // NOLINTNEXTLINE(*-reinterpret-cast, *-pointer-arithmetic)
+      return reinterpret_cast<std::byte *>(this + 1);
+    }
+
+    // the owner should initialise the queue
+    void initialise(std::uint64_t sizeOfQueue)
+    {
+      auto type = header.type.load(std::memory_order_acquire);
+      if (type != queue_type::None) {
+        throw std::logic_error("queue is already initialised");
+      }
+
+      header.arquebus_version = version_details{}.version;
+      header.message_size_type_size = sizeof(MessageSize);
+      header.max_producers = 1;
+      header.max_consumers = 1;
+      header.size_of_queue = sizeOfQueue;
+
+      write_index.store(0, std::memory_order_release);
+      read_index.store(0, std::memory_order_release);
+      header.type.store(QueueType, std::memory_order_release);
+    }
+
+
+    // a user (producer or consumer) should wait for the queue to be initialised and
+    // validate that it meets expectations. The size of the queue is whatever the owner chose, the user
+    // must check it fits in the segment it mapped.
+    void wait_and_validate(std::size_t mappedSize)
+    {
+      queue_type type = queue_type::None;
+      do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        type = header.type.load(std::memory_order_seq_cst);
+      } while (type == queue_type::None);
+
+      // owner has initialised
+      if (header.magic_number != common_header::HeaderMagicNumber) {
+        throw std::logic_error("bad magic number for header");
+      }
+      if (type != QueueType) {
+        throw std::logic_error("incorrect queue type");
+      }
+      if (header.message_size_type_size != sizeof(MessageSize)) {
+        throw std::logic_error("incorrect message size type");
+      }
+      if (header.max_producers != 1) {
+        throw std::logic_error("incorrect max producers");
+      }
+      if (header.max_consumers != 1) {
+        throw std::logic_error("incorrect max consumers");
+      }
+      if (header.size_of_queue <= sizeof(MessageSize) or header.size_of_queue > mappedSize - sizeof(*this)) {
+        throw std::logic_error("incorrect size of queue");
+      }
+    }
+  };
+
+}  // namespace arquebus::impl::spsc
@@ -1,20 +1,35 @@
 #pragma once
 
+#include "arquebus/flow_control.hpp"
 #include "arquebus/impl/buffer_size.hpp"
 #include "arquebus/impl/common_header.hpp"
+#include "arquebus/impl/consumer_wakeup.hpp"
 #include "arquebus/impl/queue_type.hpp"
+#include "arquebus/notification.hpp"
 #include "arquebus/version.hpp"
 
+#include <algorithm>
 #include <atomic>
+#include <bit>
 #include <chrono>
 #include <concepts>
+#include <cstddef>
+#include <limits>
 #include <new>
 #include <stdexcept>
 #include <thread>
 
 namespace arquebus::impl::spsc {
 
-  template<std::uint8_t Size2NBits, std::unsigned_integral TMessageSize, std::size_t CacheLineSize>
+  // Each message is framed as a MessageSize prefix followed directly by the payload. With a PayloadAlignment
+  // greater than one, every frame is padded out to a multiple of the alignment and the first frame starts
+  // FramePadding bytes into the buffer (and into each lap after a skip), so every payload starts on an
+  // aligned offset. With the default of one there is no padding at all.
+  template<
+    std::uint8_t Size2NBits,
+    std::unsigned_integral TMessageSize,
+    std::size_t CacheLineSize,
+    std::size_t PayloadAlignment>
   struct variable_message_length_header
   {
     using MessageSize = TMessageSize;
@@ -22,20 +37,58 @@ namespace arquebus::impl::spsc {
 
     static constexpr auto QueueType = queue_type::SingleProducerSingleConsumerVariableMessageLength;
 
+    static_assert(std::has_single_bit(PayloadAlignment), "PayloadAlignment must be a power of two");
+    static_assert(PayloadAlignment < BufferSize::Bytes, "PayloadAlignment must be smaller than the queue");
+
+    // the index of the first payload, the smallest aligned offset that leaves room for the size before it
+    static constexpr std::uint64_t FirstPayload =
+      (sizeof(MessageSize) + PayloadAlignment - 1) & ~std::uint64_t{ PayloadAlignment - 1 };
+    // the unused bytes at the start of each lap, before the first size
+    static constexpr std::uint64_t FramePadding = FirstPayload - sizeof(MessageSize);
+
+    // the bytes from one size to the next for a message of messageSize
+    static constexpr auto frame_size(std::uint64_t messageSize) noexcept -> std::uint64_t
+    {
+      return (messageSize + sizeof(MessageSize) + PayloadAlignment - 1) & ~std::uint64_t{ PayloadAlignment - 1 };
+    }
+
+    // The largest frame the producer can write, half a lap after the frame padding. A frame that does not fit in
+    // the rest of a lap skips to the next one, leaving a skip marker behind it, and only a frame of at most half
+    // a lap is sure to end before that marker and any messages after it that have not been read. A larger one
+    // would overrun even a consumer that has read everything with flow_control::Overwrite, or wait for itself
+    // for ever with flow_control::Backpressure.
+    static constexpr std::uint64_t MaxFrameSize =
+      ((BufferSize::Bytes - FirstPayload - sizeof(MessageSize)) / 2) & ~std::uint64_t{ PayloadAlignment - 1 };
+    // the largest message that fits in MaxFrameSize, and in a MessageSize
+    static constexpr std::uint64_t MaxMessageSize =
+      std::min<std::uint64_t>(MaxFrameSize - sizeof(MessageSize), std::numeric_limits<MessageSize>::max());
+
     common_header header{};
+    flow_control flow{ flow_control::Overwrite };
+    notification notify{ notification::None };
     // The write index is what the producer has "reserved" up to and, it will be writing into these bytes
     alignas(CacheLineSize) std::atomic_uint64_t write_index{ 0 };
+    // A recent message boundary, and the number of messages before it, that an overrun consumer can skip ahead
+    // to. The producer publishes it with each reservation, under the sync_version seqlock, see sync_point.
+    std::atomic_uint64_t sync_version{ 0 };
+    std::atomic_uint64_t sync_index{ 0 };
+    std::atomic_uint64_t sync_messages{ 0 };
     // The read index is what the producer has "released" to the consumer as valid message data.
     alignas(CacheLineSize) std::atomic_uint64_t read_index{ 0 };
+    // Where a consumer parks when it has nothing to read, see wait::spin_then_park, or arms its eventfd
+    alignas(CacheLineSize) consumer_wakeup wakeup{};
+    // The index the consumer has read up to, published each time it asks for more messages. With
+    // flow_control::Backpressure the producer will not write at or beyond a full queue past this.
+    alignas(CacheLineSize) std::atomic_uint64_t consumer_index{ 0 };
 
     // we are using C-style array to avoid initialisation, it will be zero filled when we
     // map it into memory as a shared memory region
     // NOLINTNEXTLINE(*-avoid-c-arrays)
-    alignas(CacheLineSize) std::byte data[BufferSize::Bytes];
+    alignas(std::max(CacheLineSize, PayloadAlignment)) std::byte data[BufferSize::Bytes];
 
 
     // the owner should initialise the queue
-    void initialise()
+    void initialise(flow_control flowControl, notification notifyBy, std::uint64_t catalogHash)
     {
       auto type = header.type.load(std::memory_order_acquire);
       if (type != queue_type::None) {
@@ -44,16 +97,56 @@ namespace arquebus::impl::spsc {
 
       header.arquebus_version = version_details{}.version;
       header.message_size_type_size = sizeof(MessageSize);
+      header.message_alignment = PayloadAlignment;
       header.max_producers = 1;
       header.max_consumers = 1;
       header.size_of_queue = BufferSize::Bytes;
+      header.catalog_hash = catalogHash;
+      flow = flowControl;
+      notify = notifyBy;
+      // the producer must always check for an armed eventfd, see consumer_wakeup
+      wakeup.parks.store(notifyBy == notification::EventFd ? 1 : 0, std::memory_order_relaxed);
 
+      consumer_index.store(0, std::memory_order_release);
+      publish_sync_point(FramePadding, 0);
       write_index.store(0, std::memory_order_release);
       read_index.store(0, std::memory_order_release);
       header.type.store(QueueType, std::memory_order_release);
     }
 
 
+    // the message boundary index, and the messages before it, that a consumer can resynchronise to
+    struct sync_point
+    {
+      std::uint64_t index;
+      std::uint64_t messages;
+    };
+
+    // the producer publishes a new sync point
+    void publish_sync_point(std::uint64_t index, std::uint64_t messages) noexcept
+    {
+      auto const version = sync_version.load(std::memory_order_relaxed);
+      sync_version.store(version + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      sync_index.store(index, std::memory_order_relaxed);
+      sync_messages.store(messages, std::memory_order_relaxed);
+      sync_version.store(version + 2, std::memory_order_release);
+    }
+
+    // the consumer reads the latest sync point, retrying if the producer is part way through publishing one
+    [[nodiscard]] auto load_sync_point() const noexcept -> sync_point
+    {
+      while (true) {
+        auto const version = sync_version.load(std::memory_order_acquire);
+        sync_point const point{ .index = sync_index.load(std::memory_order_relaxed),
+                                .messages = sync_messages.load(std::memory_order_relaxed) };
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ((version & 1U) == 0 and sync_version.load(std::memory_order_relaxed) == version) {
+          return point;
+        }
+      }
+    }
+
     // a user (producer or consumer) should wait for the queue to be initialised and
     // validate that it meets expectations.
     void wait_and_validate()
@@ -74,6 +167,9 @@ namespace arquebus::impl::spsc {
       if (header.message_size_type_size != sizeof(MessageSize)) {
         throw std::logic_error("incorrect message size type");
       }
+      if (header.message_alignment != PayloadAlignment) {
+        throw std::logic_error("incorrect payload alignment");
+      }
       if (header.max_producers != 1) {
         throw std::logic_error("incorrect max producers");
       }
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace arquebus {
+
+  /// The page size used to back a queue's shared memory segment.
+  enum class page_size : std::uint8_t {
+    Default,   // normal pages from POSIX shared memory (/dev/shm)
+    Huge2MiB,  // 2 MiB huge pages from a hugetlbfs mount
+    Huge1GiB,  // 1 GiB huge pages from a hugetlbfs mount
+  };
+
+  /// How the host shares a queue's segment with producers and consumers.
+  enum class segment_transport : std::uint8_t {
+    Named,  // a named POSIX shared memory object (or hugetlbfs file) that is opened by name
+    MemFd,  // an anonymous, sealed memfd whose descriptor the host passes over an abstract AF_UNIX socket
+  };
+
+  /// Where the pages of a queue's shared memory segment are placed on a NUMA machine.
+  ///
+  /// With Bind, a producer or consumer running on any other node crosses the interconnect for every access to
+  /// the queue. Their is_remote_numa_node() reports this once attached, the thread should then be pinned to a
+  /// CPU on the queue's node.
+  enum class numa_placement : std::uint8_t {
+    Default,     // the kernel's default, first touch, policy
+    Bind,        // all pages on numa_node
+    Interleave,  // pages spread round robin over all nodes
+  };
+
+  /// Options for how a host, producer or consumer maps a queue's shared memory segment.
+  ///
+  /// By default pages are faulted in as the queue first touches them, which shows up as latency outliers on
+  /// the first lap of a new queue. populate, prefault and lock move that cost to create() / attach(), and
+  /// each process can choose them independently.
+  ///
+  /// Huge pages are only chosen by the host when it creates the segment. If they can not be used (no
+  /// hugetlbfs mount of the right page size, or no free huge pages), the host falls back to normal shared
+  /// memory, and reports why through fallback_reason(). Producers and consumers find the segment wherever
+  /// the host created it, they only need the huge_page_mount if the host was given a non default one.
+  ///
+  /// The transport must match between the host, producers and consumers. A MemFd segment has no name in the
+  /// file system, so it can not be left behind by a crash, and it only exists while the host is running.
+  struct mapping_options
+  {
+    segment_transport transport{ segment_transport::Named };
+    page_size pages{ page_size::Default };
+    // the hugetlbfs mount to create huge page backed segments in, its page size must match `pages`
+    std::string_view huge_page_mount{ "/dev/hugepages" };
+    // map with MAP_POPULATE, so the page tables are filled in when the segment is mapped
+    bool populate{ false };
+    // fault in every page of the mapping for writing, without changing the contents
+    bool prefault{ false };
+    // mlock the mapping so it can not be paged out, this is subject to RLIMIT_MEMLOCK
+    bool lock{ false };
+    // NUMA placement is only applied by the host, when it creates the segment
+    numa_placement numa{ numa_placement::Default };
+    unsigned numa_node{ 0 };
+  };
+
+}  // namespace arquebus
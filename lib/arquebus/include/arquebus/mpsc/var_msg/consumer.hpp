@@ -0,0 +1,128 @@
+#pragma once
+
+#include "arquebus/impl/mpsc/variable_message_length_header.hpp"
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace arquebus::mpsc::var_msg {
+
+  /// Multi Producer Single Consumer Queue Consumer interface
+  ///
+  /// Messages are read in the order the producers claimed them. A message that has been claimed but
+  /// not yet committed holds back the messages behind it until its producer commits it.
+  ///
+  /// @tparam Size2NBits Queue Size in exponent for 2^N
+  /// @tparam MaxProducers Maximum number of producers that may be attached at once
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<
+    std::uint8_t Size2NBits,
+    std::size_t MaxProducers,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class consumer
+  {
+    using QueueLayout = impl::mpsc::variable_message_length_header<Size2NBits, MaxProducers, CacheLineSize>;
+    using Record = impl::mpsc::record;
+
+    // We give consumed space back to the producers in chunks to avoid writing the consumer index for every
+    // message. Space is always released when the queue is empty, so the producers can never wait on
+    // space we are holding when there is nothing left to read.
+    static constexpr auto ReleaseThreshold = std::uint64_t{ QueueLayout::BufferSize::Bytes / 8 };
+
+  public:
+    /// Create a consumer for the given queue name. The name must match that created by the host
+    /// and used by the producers.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    explicit consumer(std::string_view name, mapping_options const &options = {})
+      : m_queueUser(name, options)
+    {}
+
+    /// Attach the consumer to the queue that has been created by a host.
+    void attach()
+    {
+      m_queueUser.attach();
+
+      m_queue = m_queueUser.mapping();
+      m_queue->wait_and_validate();
+    }
+
+    /// Read the next message from the queue.
+    ///
+    /// This will not block and return immediately. If there is no available message, the optional will be empty.
+    /// The caller is responsible for managing the spinning and retrying for new messages.
+    ///
+    /// The returned span is valid until the next call to read().
+    ///
+    /// @return An optional span containing the next message data
+    auto read() noexcept -> std::optional<std::span<std::byte const>>
+    {
+      if (m_readIndex - m_releasedIndex >= ReleaseThreshold) [[unlikely]] {
+        release();
+      }
+
+      while (true) {
+        auto const word = m_queue->record_word(m_readIndex).load(std::memory_order_acquire);
+
+        if (word == 0) {
+          // next message is not committed yet, give back everything we have consumed while we wait
+          release();
+          return std::nullopt;
+        }
+
+        auto const *pBuffer = m_queue->bytes(m_readIndex + Record::HeaderSize);
+        auto const length = Record::length(word);
+        m_readIndex += Record::size_for(length);
+
+        if (not Record::is_padding(word)) [[likely]] {
+          return std::span<std::byte const>{ pBuffer, length };
+        }
+      }
+    }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
+  private:
+    impl::shared_memory_user<QueueLayout> m_queueUser;
+    QueueLayout *m_queue{ nullptr };
+    std::uint64_t m_readIndex{ 0 };
+    // everything before this index has been zeroed and given back to the producers
+    std::uint64_t m_releasedIndex{ 0 };
+
+    // zero the consumed records, so they read as uncommitted next time around, and publish our position
+    void release() noexcept
+    {
+      if (m_releasedIndex == m_readIndex) {
+        return;
+      }
+
+      while (m_releasedIndex < m_readIndex) {
+        auto const count =
+          std::min(m_readIndex - m_releasedIndex, QueueLayout::BufferSize::distance_to_buffer_start(m_releasedIndex));
+        std::memset(m_queue->bytes(m_releasedIndex), 0, count);
+        m_releasedIndex += count;
+      }
+
+      m_queue->consumer_index.store(m_releasedIndex, std::memory_order_release);
+    }
+  };
+
+}  // namespace arquebus::mpsc::var_msg
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "arquebus/impl/host_tags.hpp"
+#include "arquebus/impl/mpsc/variable_message_length_header.hpp"
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <stdexcept>
+#include <string_view>
+
+namespace arquebus::mpsc::var_msg {
+
+  using arquebus::danger_delete_existing_shared_memory_segment_tag;
+
+  /// Multi Producer Single Consumer Queue Host interface
+  ///
+  /// @tparam Size2NBits Queue Size in exponent for 2^N
+  /// @tparam MaxProducers Maximum number of producers that may be attached at once
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<
+    std::uint8_t Size2NBits,
+    std::size_t MaxProducers,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class host
+  {
+    using QueueLayout = impl::mpsc::variable_message_length_header<Size2NBits, MaxProducers, CacheLineSize>;
+
+  public:
+    /// Create a host for the given queue name. The name must match that used by the producers and consumer.
+    ///
+    /// @param name The unique name of the queue to create
+    /// @param options How to map the shared memory segment
+    explicit host(std::string_view name, mapping_options const &options = {})
+      : m_queueOwner(name, options)
+    {}
+
+    /// Open and create the shared memory queue.
+    ///
+    /// This must occur before the producers or consumer can attempt to connect.
+    void create()
+    {
+      m_queueOwner.create();
+
+      m_queue = m_queueOwner.mapping();
+      m_queue->header.numa_node = m_queueOwner.numa_node();
+      m_queue->initialise();
+    }
+
+    /// If the shared memory segment already exists, delete it before creating a new one
+    ///
+    /// WARNING: existing open mapping will still see old segment, new mappings will see
+    ///          new file. Be VERY sure you want to do this!
+    void create(danger_delete_existing_shared_memory_segment_tag /*unused*/)
+    {
+      m_queueOwner.delete_existing();
+      create();
+    }
+
+    /// The number of producers currently attached to the queue
+    [[nodiscard]] auto attached_producers() const -> std::size_t
+    {
+      return m_queue->attached_producers.load(std::memory_order_acquire);
+    }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueOwner.page_size(); }
+
+    /// If huge pages were requested and could not be used, the reason why. Empty otherwise.
+    [[nodiscard]] auto fallback_reason() const -> std::string_view { return m_queueOwner.fallback_reason(); }
+
+  private:
+    impl::shared_memory_owner<QueueLayout> m_queueOwner;
+    QueueLayout *m_queue{ nullptr };
+  };
+
+}  // namespace arquebus::mpsc::var_msg
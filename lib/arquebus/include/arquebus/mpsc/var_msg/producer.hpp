@@ -0,0 +1,161 @@
+#pragma once
+
+#include "arquebus/impl/cpu_relax.hpp"
+#include "arquebus/impl/mpsc/variable_message_length_header.hpp"
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace arquebus::mpsc::var_msg {
+
+  /// Multi Producer Single Consumer Queue Producer interface
+  ///
+  /// Producers claim space in the queue with a single atomic fetch-add on the shared reservation index and
+  /// then publish each message individually with commit(). There are no locks between producers, a producer
+  /// that is slow to commit only delays the consumer from reading past its message.
+  ///
+  /// The queue does not allow the producers to overwrite unread messages. If the queue is full the producer
+  /// will spin in allocate_write() until the consumer has released enough space.
+  ///
+  /// @tparam Size2NBits Queue Size in exponent for 2^N
+  /// @tparam MaxProducers Maximum number of producers that may be attached at once
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<
+    std::uint8_t Size2NBits,
+    std::size_t MaxProducers,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class producer
+  {
+  public:
+    using QueueLayout = impl::mpsc::variable_message_length_header<Size2NBits, MaxProducers, CacheLineSize>;
+    using MessageSize = typename QueueLayout::MessageSize;
+    using Record = impl::mpsc::record;
+
+    /// The largest message that can be written to the queue
+    static constexpr auto MaxMessageSize = MessageSize{ (QueueLayout::BufferSize::Bytes / 2) - Record::HeaderSize };
+
+    /// Create a producer for the given queue name. The name must match that created by the host
+    /// and used by the consumer.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    explicit producer(std::string_view name, mapping_options const &options = {})
+      : m_queueUser(name, options)
+    {}
+
+    ~producer()
+    {
+      if (m_queue != nullptr) {
+        m_queue->unregister_producer();
+      }
+    }
+
+    // no move or copy, we hold a registration in the queue
+    producer(producer &&) = delete;
+    auto operator=(producer &&) -> producer & = delete;
+    producer(producer const &) = delete;
+    auto operator=(producer const &) -> producer & = delete;
+
+    /// Attach the producer to the queue that has been created by a host.
+    ///
+    /// Throws std::runtime_error if MaxProducers are already attached.
+    void attach()
+    {
+      m_queueUser.attach();
+
+      auto *queue = m_queueUser.mapping();
+      queue->wait_and_validate();
+      queue->register_producer();
+      m_queue = queue;
+    }
+
+    /// Claim a write buffer for a message of messageSizeBytes in length.
+    ///
+    /// The message is not visible to the consumer until it is passed to commit(). Messages are delivered
+    /// in the order they were claimed across all producers.
+    ///
+    /// A messageSizeBytes of zero or greater than MaxMessageSize is not supported and will return an empty
+    /// span without claiming any space.
+    ///
+    /// @param messageSizeBytes Message Length
+    /// @return a span<> for the caller to fill with message data
+    [[nodiscard]] auto allocate_write(MessageSize messageSizeBytes) noexcept -> std::span<std::byte>
+    {
+      if (messageSizeBytes == 0 or messageSizeBytes > MaxMessageSize) [[unlikely]] {
+        return {};
+      }
+
+      auto const recordSize = Record::size_for(messageSizeBytes);
+
+      while (true) {
+        auto const claimIndex = m_queue->reserve_index.fetch_add(recordSize, std::memory_order_relaxed);
+        wait_for_space(claimIndex + recordSize);
+
+        auto const distanceToEnd = QueueLayout::BufferSize::distance_to_buffer_start(claimIndex);
+        if (recordSize <= distanceToEnd) [[likely]] {
+          return { m_queue->bytes(claimIndex + Record::HeaderSize), messageSizeBytes };
+        }
+
+        // The claim crosses the end of the buffer. We own the whole claim, so fill both parts with padding
+        // records that the consumer will skip, and try again from the beginning of the buffer.
+        // Both parts are a multiple of the record alignment so are always large enough for a record word.
+        m_queue->record_word(claimIndex).store(Record::make_padding(distanceToEnd), std::memory_order_release);
+        m_queue->record_word(claimIndex + distanceToEnd)
+          .store(Record::make_padding(recordSize - distanceToEnd), std::memory_order_release);
+      }
+    }
+
+    /// Commit a message previously claimed with allocate_write(), making it visible to the consumer.
+    ///
+    /// It is the caller's responsibility to ensure the message has been completely filled before
+    /// calling commit().
+    ///
+    /// @param message The span returned from allocate_write()
+    void commit(std::span<std::byte> message) noexcept
+    {
+      if (message.empty()) [[unlikely]] {
+        return;
+      }
+
+      // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic)
+      auto const *pRecord = message.data() - Record::HeaderSize;
+      // NOLINTNEXTLINE(*-pro-type-reinterpret-cast)
+      auto const index = static_cast<std::uint64_t>(pRecord - reinterpret_cast<std::byte const *>(m_queue->data));
+      m_queue->record_word(index).store(Record::make_message(message.size()), std::memory_order_release);
+    }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
+  private:
+    impl::shared_memory_user<QueueLayout> m_queueUser;
+    QueueLayout *m_queue{ nullptr };
+    // local copy of the consumer index, we only reload it when our claim goes past it
+    std::uint64_t m_cachedConsumerIndex{ 0 };
+
+    // wait for the consumer to release the space up to the end of our claim
+    void wait_for_space(std::uint64_t claimEnd) noexcept
+    {
+      while (claimEnd > m_cachedConsumerIndex + QueueLayout::BufferSize::Bytes) [[unlikely]] {
+        m_cachedConsumerIndex = m_queue->consumer_index.load(std::memory_order_acquire);
+        if (claimEnd > m_cachedConsumerIndex + QueueLayout::BufferSize::Bytes) {
+          impl::cpu_relax();
+        }
+      }
+    }
+  };
+
+}  // namespace arquebus::mpsc::var_msg
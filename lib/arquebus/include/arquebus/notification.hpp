@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+namespace arquebus {
+
+  /// How a consumer can be told that the producer has flushed, chosen by the host.
+  enum class notification : std::uint8_t {
+    // none, the consumer polls or parks on the queue's futex, see arquebus::wait
+    None,
+    // an eventfd the consumer can add to an epoll (or poll, select) set, see the consumer's native_handle()
+    EventFd,
+  };
+
+}  // namespace arquebus
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "arquebus/impl/host_tags.hpp"
+#include "arquebus/impl/ready_set_header.hpp"
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+
+namespace arquebus {
+
+  /// Creates the shared memory for a ready_set, in the same way that a queue host creates a queue.
+  ///
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class ready_set_host
+  {
+    using Layout = impl::ready_set_header<CacheLineSize>;
+
+  public:
+    /// @param name The unique name of the ready set, it must not be the name of a queue
+    /// @param options How to map the shared memory segment
+    explicit ready_set_host(std::string_view name, mapping_options const &options = {})
+      : m_owner(name, options)
+    {}
+
+    /// Open and create the shared memory ready set.
+    void create()
+    {
+      m_owner.create();
+      m_owner.mapping()->initialise();
+    }
+
+    /// If the shared memory segment already exists, delete it before creating a new one
+    ///
+    /// WARNING: existing open mapping will still see old segment, new mappings will see
+    ///          new file. Be VERY sure you want to do this!
+    void create(danger_delete_existing_shared_memory_segment_tag /*unused*/)
+    {
+      m_owner.delete_existing();
+      create();
+    }
+
+  private:
+    impl::shared_memory_owner<Layout> m_owner;
+  };
+
+  /// A bitmap of which queues have messages to read, in a single cache line shared by the producers of up to 64
+  /// queues and the poller that drains them.
+  ///
+  /// A producer given a ready set (see spsc::var_msg::producer::signal_ready()) marks its queue each time it
+  /// publishes, and the poller takes the marked queues at the start of each sweep. An idle queue costs the
+  /// poller nothing, rather than a load of its index cache lines every sweep.
+  ///
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class ready_set
+  {
+    using Layout = impl::ready_set_header<CacheLineSize>;
+
+  public:
+    /// The most queues that can share a ready set
+    static constexpr std::size_t MaxQueues = Layout::MaxQueues;
+
+    /// @param name The unique name of the ready set, as created by a ready_set_host
+    /// @param options How to map the shared memory segment
+    explicit ready_set(std::string_view name, mapping_options const &options = {})
+      : m_user(name, options)
+    {}
+
+    /// Attach to the ready set that has been created by a ready_set_host.
+    void attach()
+    {
+      m_user.attach();
+
+      m_set = m_user.mapping();
+      m_set->wait_and_validate();
+    }
+
+    /// Mark the queue in slot as having messages to read. Called by a producer after it publishes.
+    void mark(std::size_t slot) noexcept { m_set->mark(std::uint64_t{ 1 } << slot); }
+
+    /// Take the marked queues, a bit for each slot, and clear them. Called by the poller before it reads them.
+    [[nodiscard]] auto take() noexcept -> std::uint64_t { return m_set->take(); }
+
+  private:
+    impl::shared_memory_user<Layout> m_user;
+    Layout *m_set{ nullptr };
+  };
+
+}  // namespace arquebus
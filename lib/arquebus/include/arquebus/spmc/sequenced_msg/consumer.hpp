@@ -0,0 +1,139 @@
+#pragma once
+
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/impl/spmc/sequenced_header.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+
+namespace arquebus::spmc::sequenced_msg {
+
+  /// Sequenced (Disruptor style) Queue Consumer (stage) interface
+  ///
+  /// A stage processes every message in place, once all the stages it depends on have finished with it.
+  /// The stage may modify the message, later stages will see the changes.
+  ///
+  /// Like a Disruptor event processor, a stage publishes its progress once it has worked through the batch
+  /// of messages that were available, rather than after every message. Call release() to publish earlier.
+  ///
+  /// @tparam T The message type, must be trivially copyable
+  /// @tparam Size2NBits Queue Size, in number of messages, in exponent for 2^N
+  /// @tparam MaxStages Number of consumer stages, at most 64
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<
+    typename T,
+    std::uint8_t Size2NBits,
+    std::size_t MaxStages,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class consumer
+  {
+    using QueueLayout = impl::spmc::sequenced_header<T, Size2NBits, MaxStages, CacheLineSize>;
+
+  public:
+    /// Create a consumer for the given queue name and stage. The name must match that created by the host
+    /// and used by the producer.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param stage The index of the stage this consumer is processing
+    /// @param options How to map the shared memory segment
+    consumer(std::string_view name, std::size_t stage, mapping_options const &options = {})
+      : m_queueUser(name, options)
+      , m_stage(stage)
+    {}
+
+    ~consumer()
+    {
+      if (m_queue != nullptr) {
+        m_queue->unregister_stage(m_stage);
+      }
+    }
+
+    // no move or copy, we hold a registration in the queue
+    consumer(consumer &&) = delete;
+    auto operator=(consumer &&) -> consumer & = delete;
+    consumer(consumer const &) = delete;
+    auto operator=(consumer const &) -> consumer & = delete;
+
+    /// Attach the consumer to the queue that has been created by a host.
+    ///
+    /// Throws std::runtime_error if another consumer is already attached for the stage.
+    void attach()
+    {
+      m_queueUser.attach();
+
+      auto *queue = m_queueUser.mapping();
+      queue->wait_and_validate();
+      queue->register_stage(m_stage);
+      m_queue = queue;
+
+      m_dependencies = m_queue->stages[m_stage].dependencies;
+      m_readIndex = m_queue->stages[m_stage].sequence.load(std::memory_order_acquire);
+      m_cachedAvailable = m_readIndex;
+    }
+
+    /// Read the next message from the queue.
+    ///
+    /// This will not block and return immediately. If there is no available message, nullptr is returned.
+    /// The message is valid until the next call to read() or release().
+    ///
+    /// @return A pointer to the next message in place in the queue, or nullptr
+    auto read() noexcept -> T *
+    {
+      if (m_readIndex == m_cachedAvailable) [[unlikely]] {
+        // we have finished the last batch, publish our progress and look for more
+        release();
+        m_cachedAvailable = available();
+        if (m_readIndex == m_cachedAvailable) {
+          return nullptr;
+        }
+      }
+
+      // NOLINTNEXTLINE(*-pro-type-reinterpret-cast)
+      return std::launder(reinterpret_cast<T *>(m_queue->slot(m_readIndex++)));
+    }
+
+    /// Publish that this stage has finished with every message returned so far.
+    void release() noexcept
+    {
+      if (m_releasedIndex != m_readIndex) {
+        m_queue->stages[m_stage].sequence.store(m_readIndex, std::memory_order_release);
+        m_releasedIndex = m_readIndex;
+      }
+    }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
+  private:
+    impl::shared_memory_user<QueueLayout> m_queueUser;
+    QueueLayout *m_queue{ nullptr };
+    std::size_t m_stage;
+    std::uint64_t m_dependencies{ 0 };
+    std::uint64_t m_cachedAvailable{ 0 };
+    std::uint64_t m_readIndex{ 0 };
+    std::uint64_t m_releasedIndex{ 0 };
+
+    // the sequence we may read up to, this is gated by either the producer or the stages we depend on
+    [[nodiscard]] auto available() const noexcept -> std::uint64_t
+    {
+      if (m_dependencies == 0) {
+        return m_queue->cursor.load(std::memory_order_acquire);
+      }
+      return m_queue->minimum_sequence(m_dependencies);
+    }
+  };
+
+}  // namespace arquebus::spmc::sequenced_msg
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "arquebus/impl/host_tags.hpp"
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/impl/spmc/sequenced_header.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace arquebus::spmc::sequenced_msg {
+
+  using arquebus::danger_delete_existing_shared_memory_segment_tag;
+
+  /// Sequenced (Disruptor style) Queue Host interface
+  ///
+  /// The host defines the dependency graph between the consumer stages. Each stage is given a bit mask of
+  /// the stages it must wait for before it can read a message, a stage with no dependencies reads messages
+  /// as soon as the producer publishes them. Stages may only depend on stages with a lower index.
+  ///
+  /// For example a decode -> enrich -> persist pipeline is { 0b000, 0b001, 0b010 }.
+  ///
+  /// @tparam T The message type, must be trivially copyable
+  /// @tparam Size2NBits Queue Size, in number of messages, in exponent for 2^N
+  /// @tparam MaxStages Number of consumer stages, at most 64
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<
+    typename T,
+    std::uint8_t Size2NBits,
+    std::size_t MaxStages,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class host
+  {
+    using QueueLayout = impl::spmc::sequenced_header<T, Size2NBits, MaxStages, CacheLineSize>;
+
+  public:
+    using Dependencies = typename QueueLayout::Dependencies;
+
+    /// Create a host for the given queue name. The name must match that used by the producer and consumers.
+    ///
+    /// @param name The unique name of the queue to create
+    /// @param dependencies The stages each stage must wait for, as a bit mask per stage
+    /// @param options How to map the shared memory segment
+    host(std::string_view name, Dependencies const &dependencies, mapping_options const &options = {})
+      : m_queueOwner(name, options)
+      , m_dependencies(dependencies)
+    {}
+
+    /// Open and create the shared memory queue.
+    ///
+    /// This must occur before the producer or consumers can attempt to connect.
+    void create()
+    {
+      m_queueOwner.create();
+
+      m_queue = m_queueOwner.mapping();
+      m_queue->header.numa_node = m_queueOwner.numa_node();
+      m_queue->initialise(m_dependencies);
+    }
+
+    /// If the shared memory segment already exists, delete it before creating a new one
+    ///
+    /// WARNING: existing open mapping will still see old segment, new mappings will see
+    ///          new file. Be VERY sure you want to do this!
+    void create(danger_delete_existing_shared_memory_segment_tag /*unused*/)
+    {
+      m_queueOwner.delete_existing();
+      create();
+    }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueOwner.page_size(); }
+
+    /// If huge pages were requested and could not be used, the reason why. Empty otherwise.
+    [[nodiscard]] auto fallback_reason() const -> std::string_view { return m_queueOwner.fallback_reason(); }
+
+  private:
+    impl::shared_memory_owner<QueueLayout> m_queueOwner;
+    QueueLayout *m_queue{ nullptr };
+    Dependencies m_dependencies;
+  };
+
+}  // namespace arquebus::spmc::sequenced_msg
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "arquebus/impl/cpu_relax.hpp"
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/impl/spmc/sequenced_header.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace arquebus::spmc::sequenced_msg {
+
+  /// Sequenced (Disruptor style) Queue Producer interface
+  ///
+  /// The producer never overwrites a message that a stage has not finished with. All of the stages
+  /// configured by the host must be attached and consuming, otherwise the producer will stop after one
+  /// lap of the queue.
+  ///
+  /// @tparam T The message type, must be trivially copyable
+  /// @tparam Size2NBits Queue Size, in number of messages, in exponent for 2^N
+  /// @tparam MaxStages Number of consumer stages, at most 64
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<
+    typename T,
+    std::uint8_t Size2NBits,
+    std::size_t MaxStages,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class producer
+  {
+  public:
+    using QueueLayout = impl::spmc::sequenced_header<T, Size2NBits, MaxStages, CacheLineSize>;
+
+    /// Create a producer for the given queue name. The name must match that created by the host
+    /// and used by the consumers.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    explicit producer(std::string_view name, mapping_options const &options = {})
+      : m_queueUser(name, options)
+    {}
+
+    /// Attach the producer to the queue that has been created by a host.
+    void attach()
+    {
+      m_queueUser.attach();
+
+      m_queue = m_queueUser.mapping();
+      m_queue->wait_and_validate();
+      m_gatingStages = m_queue->final_stages();
+    }
+
+    /// Allocate the next message slot for the caller to fill in place, if there is space.
+    ///
+    /// @return a pointer to the message in the queue, or nullptr if the queue is full
+    [[nodiscard]] auto try_allocate_write() noexcept -> T *
+    {
+      if (m_allocatedIndex - m_cachedGatingSequence >= QueueLayout::BufferSize::Bytes) [[unlikely]] {
+        m_cachedGatingSequence = m_queue->minimum_sequence(m_gatingStages);
+        if (m_allocatedIndex - m_cachedGatingSequence >= QueueLayout::BufferSize::Bytes) {
+          return nullptr;
+        }
+      }
+
+      return ::new (m_queue->slot(m_allocatedIndex++)) T;
+    }
+
+    /// Allocate the next message slot for the caller to fill in place, spinning until there is space.
+    ///
+    /// @return a reference to the message in the queue
+    [[nodiscard]] auto allocate_write() noexcept -> T &
+    {
+      T *message = try_allocate_write();
+      while (message == nullptr) {
+        impl::cpu_relax();
+        message = try_allocate_write();
+      }
+      return *message;
+    }
+
+    /// Construct the next message in place, spinning until there is space.
+    ///
+    /// @return a reference to the message in the queue
+    template<typename... Args>
+    auto emplace(Args &&...args) noexcept(std::is_nothrow_constructible_v<T, Args...>) -> T &
+    {
+      return *std::construct_at(&allocate_write(), std::forward<Args>(args)...);
+    }
+
+    /// Publish all allocated messages to the stages.
+    ///
+    /// It is the caller's responsibility to ensure that all
+    /// allocated messages have been filled before calling flush().
+    void flush() noexcept { m_queue->cursor.store(m_allocatedIndex, std::memory_order_release); }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
+  private:
+    impl::shared_memory_user<QueueLayout> m_queueUser;
+    QueueLayout *m_queue{ nullptr };
+    std::uint64_t m_gatingStages{ 0 };
+    // the lowest sequence of the final stages when we last looked
+    std::uint64_t m_cachedGatingSequence{ 0 };
+    std::uint64_t m_allocatedIndex{ 0 };
+  };
+
+}  // namespace arquebus::spmc::sequenced_msg
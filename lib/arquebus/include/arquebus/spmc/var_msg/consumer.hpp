@@ -0,0 +1,165 @@
+#pragma once
+
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/impl/spmc/variable_message_length_header.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace arquebus::spmc::var_msg {
+
+  /// Single Producer Multi Consumer (broadcast) Queue Consumer interface
+  ///
+  /// Every consumer sees every message published after it attached. Consumers keep their own read
+  /// position and never write to the queue while reading, so attaching more consumers does not add any
+  /// work to the producer.
+  ///
+  /// @tparam Size2NBits Queue Size in exponent for 2^N
+  /// @tparam MaxConsumers Maximum number of consumers that may be attached at once
+  /// @tparam TMessageSize Type for indicating size of message.
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<
+    std::uint8_t Size2NBits,
+    std::size_t MaxConsumers,
+    std::unsigned_integral TMessageSize = std::uint32_t,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class consumer
+  {
+    using QueueLayout =
+      impl::spmc::variable_message_length_header<Size2NBits, MaxConsumers, TMessageSize, CacheLineSize>;
+    using MessageSize = TMessageSize;
+
+  public:
+    /// Create a consumer for the given queue name. The name must match that created by the host
+    /// and used by the producer.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    explicit consumer(std::string_view name, mapping_options const &options = {})
+      : m_queueUser(name, options)
+    {}
+
+    ~consumer()
+    {
+      if (m_queue != nullptr) {
+        m_queue->unregister_consumer();
+      }
+    }
+
+    // no move or copy, we hold a registration in the queue
+    consumer(consumer &&) = delete;
+    auto operator=(consumer &&) -> consumer & = delete;
+    consumer(consumer const &) = delete;
+    auto operator=(consumer const &) -> consumer & = delete;
+
+    /// Attach the consumer to the queue that has been created by a host.
+    ///
+    /// The consumer will start reading from the most recently published message boundary, it will not
+    /// see messages that were published before it attached.
+    ///
+    /// Throws std::runtime_error if MaxConsumers are already attached.
+    void attach()
+    {
+      m_queueUser.attach();
+
+      auto *queue = m_queueUser.mapping();
+      queue->wait_and_validate();
+      queue->register_consumer();
+      m_queue = queue;
+
+      // the producer only ever releases up to a message boundary so this is a safe place to start.
+      m_readIndex = m_queue->read_index.load(std::memory_order_acquire);
+      m_cachedReadIndex = m_readIndex;
+    }
+
+    /// Read the next message from the queue.
+    ///
+    /// This will not block and return immediately. If there is no available message, the optional will be empty.
+    /// The caller is responsible for managing the spinning and retrying for new messages.
+    ///
+    /// If the consumer is overrun by the producer, a std::runtime_error will be thrown
+    ///
+    /// @return An optional span containing the next message data
+    auto read() -> std::optional<std::span<std::byte const>>
+    {
+      if (m_readIndex < m_cachedReadIndex) [[likely]] {
+        return decode_message();
+      }
+
+      update_cached_indices();
+
+      if (m_readIndex < m_cachedReadIndex) [[likely]] {
+        return decode_message();
+      }
+
+      // no waiting message
+      return std::nullopt;
+    }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
+  private:
+    impl::shared_memory_user<QueueLayout> m_queueUser;
+    QueueLayout *m_queue{ nullptr };
+    std::uint64_t m_cachedWriteIndex{ 0 };
+    std::uint64_t m_cachedReadIndex{ 0 };
+    std::uint64_t m_readIndex{ 0 };
+
+    // Decode a message waiting in the queue, see arquebus::spsc::var_msg::consumer for details of the
+    // skip handling.
+    auto decode_message() noexcept -> std::span<std::byte const>
+    {
+      MessageSize messageSize{ 0 };
+      auto *pBuffer = &m_queue->data[QueueLayout::BufferSize::to_offset(m_readIndex)];
+      std::memcpy(&messageSize, pBuffer, sizeof(MessageSize));
+
+      if (messageSize == 0) [[unlikely]] {
+        // wrap to the beginning of the buffer
+        m_readIndex += QueueLayout::BufferSize::distance_to_buffer_start(m_readIndex);
+
+        pBuffer = &m_queue->data[0];
+        std::memcpy(&messageSize, pBuffer, sizeof(MessageSize));
+      }
+
+      m_readIndex += messageSize + sizeof(MessageSize);
+
+      return { pBuffer + sizeof(MessageSize), messageSize };
+    }
+
+    void update_cached_indices()
+    {
+      m_cachedWriteIndex = m_queue->write_index.load(std::memory_order_acquire);
+
+      // check for overrun, the same as the SPSC queue. Each consumer checks against its own read position
+      // so a slow consumer is overrun independently of the others.
+      auto readGeneration = QueueLayout::BufferSize::to_generation(m_readIndex);
+      auto writeGeneration = QueueLayout::BufferSize::to_generation(m_cachedWriteIndex);
+
+      if (readGeneration < writeGeneration) [[unlikely]] {
+        auto readOffset = QueueLayout::BufferSize::to_offset(m_readIndex);
+        auto writeOffset = QueueLayout::BufferSize::to_offset(m_cachedWriteIndex);
+        if (readOffset < writeOffset) [[unlikely]] {
+          throw std::runtime_error("Queue Overrun detected");
+        }
+      }
+
+      m_cachedReadIndex = m_queue->read_index.load(std::memory_order_acquire);
+    }
+  };
+
+}  // namespace arquebus::spmc::var_msg
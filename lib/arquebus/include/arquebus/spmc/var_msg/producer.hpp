@@ -0,0 +1,185 @@
+#pragma once
+
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/impl/spmc/variable_message_length_header.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+namespace arquebus::spmc::var_msg {
+
+  /// Single Producer Multi Consumer (broadcast) Queue Producer interface
+  ///
+  /// Each message is written into the queue exactly once, regardless of how many consumers are attached.
+  /// The producer never waits on the consumers, a consumer that falls more than a queue length behind
+  /// will detect the overrun when it next reads.
+  ///
+  /// @tparam Size2NBits Queue Size in exponent for 2^N
+  /// @tparam MaxConsumers Maximum number of consumers that may be attached at once
+  /// @tparam NBytesBatchMessageReserve Number of bytes to allocate from queue as a chunk to prevent constant
+  /// write index updates.
+  /// @tparam TMessageSize Type for indicating size of message.
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  ///
+  template<
+    std::uint8_t Size2NBits,
+    std::size_t MaxConsumers,
+    std::size_t NBytesBatchMessageReserve,
+    std::unsigned_integral TMessageSize = std::uint32_t,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class producer
+  {
+  public:
+    using QueueLayout =
+      impl::spmc::variable_message_length_header<Size2NBits, MaxConsumers, TMessageSize, CacheLineSize>;
+    using MessageSize = TMessageSize;
+    static constexpr auto BatchMessageReserve = std::uint64_t{ NBytesBatchMessageReserve };
+
+    static_assert(
+      BatchMessageReserve < (QueueLayout::BufferSize::Bytes - sizeof(MessageSize)),
+      "Can not reserve more than the queue size"
+    );
+    static_assert(QueueLayout::MaxFrameSize > sizeof(MessageSize), "The queue is too small for a message");
+
+    /// The largest message the queue can take, a little under half the queue, see spsc::var_msg::producer.
+    static constexpr std::uint64_t MaxMessageSize = QueueLayout::MaxMessageSize;
+
+    /// Create a producer for the given queue name. The name must match that created by the host
+    /// and used by the consumers.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    explicit producer(std::string_view name, mapping_options const &options = {})
+      : m_queueUser(name, options)
+    {}
+
+    /// Attach the producer to the queue that has been created by a host.
+    void attach()
+    {
+      m_queueUser.attach();
+
+      m_queue = m_queueUser.mapping();
+      m_queue->wait_and_validate();
+      // establish the initial write offset
+      m_queue->write_index.store(m_cachedWriteIndex, std::memory_order_release);
+    }
+
+    /// Allocate a write buffer for a message of numberBytes in length.
+    ///
+    /// A messageSizeBytes of zero is not supported and will cause incorrect behaviour. A message larger than
+    /// BatchMessageReserve is given a reservation of its own, up to MaxMessageSize. A larger message throws
+    /// std::length_error and leaves the queue unchanged.
+    ///
+    /// @param messageSizeBytes Message Length
+    /// @return a span<> for the caller to fill with message data
+    [[nodiscard]] auto allocate_write(MessageSize messageSizeBytes) -> std::span<std::byte>
+    {
+      // message + the next size / skip block ready for next message
+      auto const allocationSize = messageSizeBytes + sizeof(MessageSize);
+
+      if (m_cachedWriteIndex - m_allocatedIndex < allocationSize) [[unlikely]] {
+        // a reservation is never larger than the largest frame, so only a message that needs one can be too large
+        check_message_size(messageSizeBytes);
+        // allocate more storage. Skipping over index wrap if required
+        reserve(allocationSize);
+      }
+
+      // we have ensured that our allocation will not wrap so safe to index in
+      auto *pBuffer = &m_queue->data[QueueLayout::BufferSize::to_offset(m_allocatedIndex)];
+
+      // write the message size into the buffer, note that this is actually already reserved
+      // and know safe place to write "before" the current allocation index
+      std::memcpy(pBuffer - sizeof(MessageSize), &messageSizeBytes, sizeof(MessageSize));
+      m_allocatedIndex += allocationSize;
+      return { pBuffer, messageSizeBytes };
+    }
+
+    /// Flush any allocated writes, releasing them to all attached consumers.
+    ///
+    /// It is the caller's responsibility to ensure that all
+    /// allocated message buffer spans have been filled before calling flush().
+    void flush() noexcept
+    {
+      // We are pre-allocating the next size/skip indicator, so we have to release to just before that
+      // as it is not yet valid
+      m_queue->read_index.store(m_allocatedIndex - sizeof(MessageSize), std::memory_order_release);
+    }
+
+    /// The largest message that can be written, MaxMessageSize
+    [[nodiscard]] static constexpr auto max_message_size() noexcept -> std::uint64_t { return MaxMessageSize; }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
+  private:
+    impl::shared_memory_user<QueueLayout> m_queueUser;
+    QueueLayout *m_queue{ nullptr };
+    // a local copy of the write index, we take chunks of data at a time
+    // any only update the atomic write index when we need more
+    std::uint64_t m_cachedWriteIndex{ sizeof(MessageSize) };
+
+    // a local read index of allocated, but not committed/flushed message data
+    // once the caller calls flush(), we release this to the consumers
+    //
+    // This actually maintains a "reserved" size area so that we know that we will always have a
+    // continuous sequence of bytes to write the next size or skip into.
+    std::uint64_t m_allocatedIndex{ sizeof(MessageSize) };
+
+    static void check_message_size(MessageSize messageSizeBytes)
+    {
+      if (messageSizeBytes > MaxMessageSize) [[unlikely]] {
+        throw std::length_error("Message is larger than the queue can take");
+      }
+    }
+
+    // Identical to the SPSC producer, see arquebus::spsc::var_msg::producer for the details of the
+    // skip handling.
+    void reserve(std::size_t minimumRequired) noexcept
+    {
+      // the batch, or enough for this message if it is larger
+      m_cachedWriteIndex =
+        std::max(m_cachedWriteIndex + BatchMessageReserve + sizeof(MessageSize), m_allocatedIndex + minimumRequired);
+
+      auto const offsetOfAllocatedIndex = QueueLayout::BufferSize::to_offset(m_allocatedIndex - sizeof(MessageSize));
+      auto const offsetOfNextAllocationIndex = QueueLayout::BufferSize::to_offset(m_allocatedIndex + minimumRequired);
+      // have we wrapped?
+      if (offsetOfNextAllocationIndex < offsetOfAllocatedIndex) [[unlikely]] {
+        // mark the remaining block as a skip so the consumers move back to the beginning of the buffer
+        auto *pBuffer = &m_queue->data[offsetOfAllocatedIndex];
+        MessageSize zero{ 0u };
+        std::memcpy(pBuffer, &zero, sizeof(MessageSize));
+
+        auto wrapCount = QueueLayout::BufferSize::distance_to_buffer_start(m_allocatedIndex - sizeof(MessageSize));
+        m_allocatedIndex += wrapCount;
+        m_cachedWriteIndex += wrapCount;
+      }
+
+      // Never reserve past the end of the buffer. The allocations from this reservation are only checked
+      // against the write index, so one that ran past the end would straddle the wrap.
+      auto const sizeIndex = m_allocatedIndex - sizeof(MessageSize);
+      m_cachedWriteIndex =
+        std::min(m_cachedWriteIndex, sizeIndex + QueueLayout::BufferSize::distance_to_buffer_start(sizeIndex));
+      // nor more than the largest frame, so a message that fits in the reservation is never too large
+      m_cachedWriteIndex = std::min(m_cachedWriteIndex, m_allocatedIndex + QueueLayout::MaxFrameSize);
+
+      // inform consumers of updated allocation
+      m_queue->write_index.store(m_cachedWriteIndex, std::memory_order_release);
+    }
+  };
+
+}  // namespace arquebus::spmc::var_msg
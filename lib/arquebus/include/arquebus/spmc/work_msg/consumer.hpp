@@ -0,0 +1,120 @@
+#pragma once
+
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/impl/spmc/work_distribution_header.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+namespace arquebus::spmc::work_msg {
+
+  /// Single Producer Multi Consumer Work Distribution Queue Consumer interface
+  ///
+  /// Consumers compete for messages, each message is delivered to exactly one consumer.
+  ///
+  /// @tparam T The message type, must be trivially copyable
+  /// @tparam Size2NBits Queue Size, in number of messages, in exponent for 2^N
+  /// @tparam MaxConsumers Maximum number of consumers that may be attached at once
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<
+    typename T,
+    std::uint8_t Size2NBits,
+    std::size_t MaxConsumers,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class consumer
+  {
+    using QueueLayout = impl::spmc::work_distribution_header<T, Size2NBits, MaxConsumers, CacheLineSize>;
+
+  public:
+    /// Create a consumer for the given queue name. The name must match that created by the host
+    /// and used by the producer.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    explicit consumer(std::string_view name, mapping_options const &options = {})
+      : m_queueUser(name, options)
+    {}
+
+    ~consumer()
+    {
+      if (m_queue != nullptr) {
+        m_queue->unregister_consumer();
+      }
+    }
+
+    // no move or copy, we hold a registration in the queue
+    consumer(consumer &&) = delete;
+    auto operator=(consumer &&) -> consumer & = delete;
+    consumer(consumer const &) = delete;
+    auto operator=(consumer const &) -> consumer & = delete;
+
+    /// Attach the consumer to the queue that has been created by a host.
+    ///
+    /// Throws std::runtime_error if MaxConsumers are already attached.
+    void attach()
+    {
+      m_queueUser.attach();
+
+      auto *queue = m_queueUser.mapping();
+      queue->wait_and_validate();
+      queue->register_consumer();
+      m_queue = queue;
+    }
+
+    /// Claim and read the next message from the queue.
+    ///
+    /// This will not block and return immediately. If there is no available message, the optional will be empty.
+    /// The message is copied out so the slot can be returned to the producer straight away.
+    ///
+    /// @return An optional containing the claimed message
+    auto read() noexcept -> std::optional<T>
+    {
+      auto index = m_queue->claim_index.load(std::memory_order_relaxed);
+
+      while (true) {
+        auto &slot = m_queue->slot(index);
+        auto const sequence = slot.sequence.load(std::memory_order_acquire);
+
+        if (sequence == index + 1) {
+          // published and unclaimed, try to take it. On failure index is updated to the current claim index.
+          if (m_queue->claim_index.compare_exchange_weak(index, index + 1, std::memory_order_relaxed)) {
+            std::array<std::byte, sizeof(T)> message{};
+            std::memcpy(message.data(), slot.message, sizeof(T));
+            // hand the slot back to the producer for the next lap
+            slot.sequence.store(index + QueueLayout::BufferSize::Bytes, std::memory_order_release);
+            return std::bit_cast<T>(message);
+          }
+        } else if (sequence < index + 1) {
+          // the producer has not published this index yet, the queue is empty
+          return std::nullopt;
+        } else {
+          // another consumer has claimed this index, catch up and try again
+          index = m_queue->claim_index.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
+  private:
+    impl::shared_memory_user<QueueLayout> m_queueUser;
+    QueueLayout *m_queue{ nullptr };
+  };
+
+}  // namespace arquebus::spmc::work_msg
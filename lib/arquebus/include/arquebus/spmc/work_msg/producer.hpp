@@ -0,0 +1,98 @@
+#pragma once
+
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/impl/spmc/work_distribution_header.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace arquebus::spmc::work_msg {
+
+  /// Single Producer Multi Consumer Work Distribution Queue Producer interface
+  ///
+  /// Every message is delivered to exactly one of the attached consumers. The queue never overwrites a
+  /// message that has not been consumed, if the queue is full the write fails and the caller decides
+  /// whether to retry or drop.
+  ///
+  /// @tparam T The message type, must be trivially copyable
+  /// @tparam Size2NBits Queue Size, in number of messages, in exponent for 2^N
+  /// @tparam MaxConsumers Maximum number of consumers that may be attached at once
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<
+    typename T,
+    std::uint8_t Size2NBits,
+    std::size_t MaxConsumers,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class producer
+  {
+  public:
+    using QueueLayout = impl::spmc::work_distribution_header<T, Size2NBits, MaxConsumers, CacheLineSize>;
+
+    /// Create a producer for the given queue name. The name must match that created by the host
+    /// and used by the consumers.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    explicit producer(std::string_view name, mapping_options const &options = {})
+      : m_queueUser(name, options)
+    {}
+
+    /// Attach the producer to the queue that has been created by a host.
+    void attach()
+    {
+      m_queueUser.attach();
+
+      m_queue = m_queueUser.mapping();
+      m_queue->wait_and_validate();
+    }
+
+    /// Construct the next message in place and publish it to the consumers
+    ///
+    /// @return false if the queue is full and the message was not written
+    template<typename... Args>
+    auto try_emplace(Args &&...args) noexcept(std::is_nothrow_constructible_v<T, Args...>) -> bool
+    {
+      auto &slot = m_queue->slot(m_writeIndex);
+
+      // until a consumer has finished with the message from the previous lap, the sequence is behind us.
+      if (slot.sequence.load(std::memory_order_acquire) != m_writeIndex) [[unlikely]] {
+        return false;
+      }
+
+      // NOLINTNEXTLINE(*-pro-type-reinterpret-cast)
+      std::construct_at(reinterpret_cast<T *>(slot.message), std::forward<Args>(args)...);
+      slot.sequence.store(m_writeIndex + 1, std::memory_order_release);
+      ++m_writeIndex;
+      return true;
+    }
+
+    /// Copy the message into the queue and publish it to the consumers
+    ///
+    /// @return false if the queue is full and the message was not written
+    auto try_write(T const &message) noexcept -> bool { return try_emplace(message); }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
+  private:
+    impl::shared_memory_user<QueueLayout> m_queueUser;
+    QueueLayout *m_queue{ nullptr };
+    // only the producer writes messages, so our position does not need to be shared
+    std::uint64_t m_writeIndex{ 0 };
+  };
+
+}  // namespace arquebus::spmc::work_msg
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/impl/spsc/fixed_message_length_header.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+
+namespace arquebus::spsc::fixed_msg {
+
+  /// Single Producer Single Consumer Fixed Message Queue Consumer interface
+  ///
+  /// @tparam T The message type, must be trivially copyable
+  /// @tparam Size2NBits Queue Size, in number of messages, in exponent for 2^N
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<typename T, std::uint8_t Size2NBits, std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class consumer
+  {
+    using QueueLayout = impl::spsc::fixed_message_length_header<T, Size2NBits, CacheLineSize>;
+
+  public:
+    /// Create a consumer for the given queue name. The name must match that created by the host
+    /// and used by the producer.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    explicit consumer(std::string_view name, mapping_options const &options = {})
+      : m_queueUser(name, options)
+    {}
+
+    /// Attach the consumer to the queue that has been created by a host.
+    void attach()
+    {
+      m_queueUser.attach();
+
+      m_queue = m_queueUser.mapping();
+      m_queue->wait_and_validate();
+    }
+
+    /// Read the next message from the queue.
+    ///
+    /// This will not block and return immediately. If there is no available message, nullptr is returned.
+    /// The caller is responsible for managing the spinning and retrying for new messages.
+    ///
+    /// The message is accessed in place in the queue and is valid until the producer overwrites the slot.
+    ///
+    /// If the consumer is overrun by the producer, a std::runtime_error will be thrown
+    ///
+    /// @return A pointer to the next message or nullptr
+    auto read() -> T const *
+    {
+      if (m_readIndex < m_cachedReadIndex) [[likely]] {
+        return decode_message();
+      }
+
+      update_cached_indices();
+
+      if (m_readIndex < m_cachedReadIndex) [[likely]] {
+        return decode_message();
+      }
+
+      // no waiting message
+      return nullptr;
+    }
+
+    /// Call callback for every message that is available now, up to maxMessages.
+    ///
+    /// The shared indices are loaded, and the consumer checked for overrun, once for the whole batch rather
+    /// than once per message. This will not block, if there is no available message the callback is not called.
+    /// The messages are accessed in place, the same as those returned by read().
+    ///
+    /// If the consumer is overrun by the producer, a std::runtime_error will be thrown
+    ///
+    /// @param callback Called with a T const & of each message in turn
+    /// @param maxMessages The most messages to process in this batch
+    /// @return The number of messages processed
+    template<std::invocable<T const &> Callback>
+    auto for_each_available(Callback &&callback, std::size_t maxMessages = std::numeric_limits<std::size_t>::max())
+      -> std::size_t
+    {
+      update_cached_indices();
+
+      // a local copy of the limit, so the callback can not force it to be reloaded every message
+      auto const readIndex = m_cachedReadIndex;
+      std::size_t count = 0;
+      for (; m_readIndex < readIndex and count < maxMessages; ++count) {
+        callback(*decode_message());
+      }
+      return count;
+    }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
+  private:
+    impl::shared_memory_user<QueueLayout> m_queueUser;
+    QueueLayout *m_queue{ nullptr };
+    std::uint64_t m_cachedWriteIndex{ 0 };
+    std::uint64_t m_cachedReadIndex{ 0 };
+    std::uint64_t m_readIndex{ 0 };
+
+    auto decode_message() noexcept -> T const *
+    {
+      // the producer constructed the message in this slot
+      // NOLINTNEXTLINE(*-pro-type-reinterpret-cast)
+      return std::launder(reinterpret_cast<T const *>(m_queue->slot(m_readIndex++)));
+    }
+
+    void update_cached_indices()
+    {
+      m_cachedWriteIndex = m_queue->write_index.load(std::memory_order_acquire);
+
+      // check for overrun
+      // The producer may be writing into any slot up to the write index, which is only safe for us
+      // if it is no more than one lap of the buffer ahead of our read index.
+      if (m_cachedWriteIndex - m_readIndex > QueueLayout::BufferSize::Bytes) [[unlikely]] {
+        throw std::runtime_error("Queue Overrun detected");
+      }
+
+      m_cachedReadIndex = m_queue->read_index.load(std::memory_order_acquire);
+    }
+  };
+
+}  // namespace arquebus::spsc::fixed_msg
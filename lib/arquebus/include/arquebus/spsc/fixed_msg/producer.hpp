@@ -0,0 +1,119 @@
+#pragma once
+
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/impl/spsc/fixed_message_length_header.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace arquebus::spsc::fixed_msg {
+
+  /// Single Producer Single Consumer Fixed Message Queue Producer interface
+  ///
+  /// Each message occupies exactly one slot of sizeof(T) bytes, aligned for T. Messages are constructed in
+  /// place in the queue and released to the consumer with flush().
+  ///
+  /// @tparam T The message type, must be trivially copyable
+  /// @tparam Size2NBits Queue Size, in number of messages, in exponent for 2^N
+  /// @tparam NSlotsBatchMessageReserve Number of slots to allocate from queue as a chunk to prevent constant
+  /// write index updates.
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<
+    typename T,
+    std::uint8_t Size2NBits,
+    std::size_t NSlotsBatchMessageReserve,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class producer
+  {
+  public:
+    using QueueLayout = impl::spsc::fixed_message_length_header<T, Size2NBits, CacheLineSize>;
+    static constexpr auto BatchMessageReserve = std::uint64_t{ NSlotsBatchMessageReserve };
+
+    static_assert(BatchMessageReserve > 0, "Must reserve at least one slot at a time");
+    static_assert(BatchMessageReserve < QueueLayout::BufferSize::Bytes, "Can not reserve more than the queue size");
+
+    /// Create a producer for the given queue name. The name must match that created by the host
+    /// and used by the consumer.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    explicit producer(std::string_view name, mapping_options const &options = {})
+      : m_queueUser(name, options)
+    {}
+
+    /// Attach the producer to the queue that has been created by a host.
+    void attach()
+    {
+      m_queueUser.attach();
+
+      m_queue = m_queueUser.mapping();
+      m_queue->wait_and_validate();
+    }
+
+    /// Allocate the next message slot for the caller to fill in place.
+    ///
+    /// The message is default initialised, so for trivial types the slot contents are indeterminate.
+    ///
+    /// @return a reference to the message in the queue
+    [[nodiscard]] auto allocate_write() noexcept -> T & { return *::new (next_slot()) T; }
+
+    /// Construct the next message in place from the given arguments
+    ///
+    /// @return a reference to the message in the queue
+    template<typename... Args>
+    auto emplace(Args &&...args) noexcept(std::is_nothrow_constructible_v<T, Args...>) -> T &
+    {
+      return *std::construct_at(reinterpret_cast<T *>(next_slot()), std::forward<Args>(args)...); // NOLINT(*-reinterpret-cast)
+    }
+
+    /// Flush any allocated writes.
+    ///
+    /// It is the caller's responsibility to ensure that all
+    /// allocated messages have been filled before calling flush().
+    void flush() noexcept { m_queue->read_index.store(m_allocatedIndex, std::memory_order_release); }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
+  private:
+    impl::shared_memory_user<QueueLayout> m_queueUser;
+    QueueLayout *m_queue{ nullptr };
+    // a local copy of the write index, we take chunks of slots at a time
+    // any only update the atomic write index when we need more
+    std::uint64_t m_cachedWriteIndex{ 0 };
+    // the next slot to allocate, everything before this has been allocated but not necessarily flushed
+    std::uint64_t m_allocatedIndex{ 0 };
+
+    auto next_slot() noexcept -> std::byte *
+    {
+      if (m_allocatedIndex == m_cachedWriteIndex) [[unlikely]] {
+        reserve();
+      }
+
+      return m_queue->slot(m_allocatedIndex++);
+    }
+
+    void reserve() noexcept
+    {
+      // slots never straddle the end of the buffer, so there is no need for any skip handling here.
+      m_cachedWriteIndex += BatchMessageReserve;
+      m_queue->write_index.store(m_cachedWriteIndex, std::memory_order_release);
+    }
+  };
+
+}  // namespace arquebus::spsc::fixed_msg
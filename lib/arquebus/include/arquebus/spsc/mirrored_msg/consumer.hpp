@@ -0,0 +1,147 @@
+#pragma once
+
+#include "arquebus/impl/numa.hpp"
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/impl/spsc/mirrored_header.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+namespace arquebus::spsc::mirrored_msg {
+
+  /// Single Producer Single Consumer Mirrored Queue Consumer interface
+  ///
+  /// @tparam Size2NBits Queue Size in exponent for 2^N, at least 12 (one page)
+  /// @tparam TMessageSize Type for indicating size of message.
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<
+    std::uint8_t Size2NBits,
+    std::unsigned_integral TMessageSize = std::uint32_t,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class consumer
+  {
+    using QueueLayout = impl::spsc::mirrored_header<Size2NBits, TMessageSize, CacheLineSize>;
+    using MessageSize = TMessageSize;
+
+  public:
+    /// Create a consumer for the given queue name. The name must match that created by the host
+    /// and used by the producer.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    explicit consumer(std::string_view name, mapping_options const &options = {})
+      : m_queueUser(name, options, QueueLayout::MirrorSize)
+    {}
+
+    /// Attach the consumer to the queue that has been created by a host.
+    void attach()
+    {
+      m_queueUser.attach();
+
+      m_queue = m_queueUser.mapping();
+      m_queue->wait_and_validate();
+    }
+
+    /// Read the next message from the queue.
+    ///
+    /// This will not block and return immediately. If there is no available message, the optional will be empty.
+    /// The caller is responsible for managing the spinning and retrying for new messages.
+    ///
+    /// If the consumer is overrun by the producer, a std::runtime_error will be thrown
+    ///
+    /// @return An optional span containing the next message data
+    auto read() -> std::optional<std::span<std::byte const>>
+    {
+      if (m_readIndex < m_cachedReadIndex) [[likely]] {
+        return decode_message();
+      }
+
+      update_cached_indices();
+
+      if (m_readIndex < m_cachedReadIndex) [[likely]] {
+        return decode_message();
+      }
+
+      // no waiting message
+      return std::nullopt;
+    }
+
+    /// Call callback for every message that is available now, up to maxMessages.
+    ///
+    /// The shared indices are loaded, and the consumer checked for overrun, once for the whole batch rather
+    /// than once per message. This will not block, if there is no available message the callback is not called.
+    /// The spans passed to the callback are the same as those returned by read().
+    ///
+    /// If the consumer is overrun by the producer, a std::runtime_error will be thrown
+    ///
+    /// @param callback Called with a std::span<std::byte const> of each message in turn
+    /// @param maxMessages The most messages to process in this batch
+    /// @return The number of messages processed
+    template<std::invocable<std::span<std::byte const>> Callback>
+    auto for_each_available(Callback &&callback, std::size_t maxMessages = std::numeric_limits<std::size_t>::max())
+      -> std::size_t
+    {
+      update_cached_indices();
+
+      // a local copy of the limit, so the callback can not force it to be reloaded every message
+      auto const readIndex = m_cachedReadIndex;
+      std::size_t count = 0;
+      for (; m_readIndex < readIndex and count < maxMessages; ++count) {
+        callback(decode_message());
+      }
+      return count;
+    }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
+  private:
+    impl::shared_memory_user<QueueLayout> m_queueUser;
+    QueueLayout *m_queue{ nullptr };
+    std::uint64_t m_cachedReadIndex{ 0 };
+    std::uint64_t m_readIndex{ 0 };
+
+    // Decode a message waiting in the queue. The message may run past the end of data[] into the mirror,
+    // so there is never anything to skip.
+    auto decode_message() noexcept -> std::span<std::byte const>
+    {
+      MessageSize messageSize{ 0 };
+      auto const *pBuffer = m_queue->at(m_readIndex);
+      std::memcpy(&messageSize, pBuffer, sizeof(MessageSize));
+
+      m_readIndex += messageSize + sizeof(MessageSize);
+      return { pBuffer + sizeof(MessageSize), messageSize };  // NOLINT(*-pointer-arithmetic)
+    }
+
+    void update_cached_indices()
+    {
+      // The indices are exact byte counts, so we have been overrun as soon as the producer has reserved
+      // more than a full queue ahead of us.
+      auto const writeIndex = m_queue->write_index.load(std::memory_order_acquire);
+      if (writeIndex - m_readIndex > QueueLayout::BufferSize::Bytes) [[unlikely]] {
+        throw std::runtime_error("Queue Overrun detected");
+      }
+
+      m_cachedReadIndex = m_queue->read_index.load(std::memory_order_acquire);
+    }
+  };
+
+}  // namespace arquebus::spsc::mirrored_msg
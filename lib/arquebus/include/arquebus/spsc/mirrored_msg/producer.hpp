@@ -0,0 +1,119 @@
+#pragma once
+
+#include "arquebus/impl/numa.hpp"
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/impl/spsc/mirrored_header.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+namespace arquebus::spsc::mirrored_msg {
+
+  /// Single Producer Single Consumer Mirrored Queue Producer interface
+  ///
+  /// Messages are written as a contiguous span even when they run past the end of the queue, the second
+  /// mapping of the data region makes that seamless. There are no skip markers, so no space is wasted at
+  /// the end of each lap.
+  ///
+  /// @tparam Size2NBits Queue Size in exponent for 2^N, at least 12 (one page)
+  /// @tparam NBytesBatchMessageReserve Number of bytes to allocate from queue as a chunk to prevent constant
+  /// write index updates.
+  /// @tparam TMessageSize Type for indicating size of message.
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<
+    std::uint8_t Size2NBits,
+    std::size_t NBytesBatchMessageReserve,
+    std::unsigned_integral TMessageSize = std::uint32_t,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class producer
+  {
+  public:
+    using QueueLayout = impl::spsc::mirrored_header<Size2NBits, TMessageSize, CacheLineSize>;
+    using MessageSize = TMessageSize;
+    static constexpr auto BatchMessageReserve = std::uint64_t{ NBytesBatchMessageReserve };
+    static constexpr auto MaxMessageSize = QueueLayout::BufferSize::Bytes - sizeof(MessageSize);
+
+    static_assert(BatchMessageReserve <= QueueLayout::BufferSize::Bytes, "Can not reserve more than the queue size");
+
+    /// Create a producer for the given queue name. The name must match that created by the host
+    /// and used by the consumer.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    explicit producer(std::string_view name, mapping_options const &options = {})
+      : m_queueUser(name, options, QueueLayout::MirrorSize)
+    {}
+
+    /// Attach the producer to the queue that has been created by a host.
+    void attach()
+    {
+      m_queueUser.attach();
+
+      m_queue = m_queueUser.mapping();
+      m_queue->wait_and_validate();
+    }
+
+    /// Allocate a write buffer for a message of numberBytes in length.
+    ///
+    /// Any size from zero up to MaxMessageSize (the size of the queue, less the size prefix) is supported.
+    /// Larger sizes will cause incorrect behaviour.
+    ///
+    /// @param messageSizeBytes Message Length
+    /// @return a span<> for the caller to fill with message data
+    [[nodiscard]] auto allocate_write(MessageSize messageSizeBytes) noexcept -> std::span<std::byte>
+    {
+      auto const allocationSize = messageSizeBytes + sizeof(MessageSize);
+
+      if (m_cachedWriteIndex - m_allocatedIndex < allocationSize) [[unlikely]] {
+        reserve(allocationSize);
+      }
+
+      // the span may run past the end of data[] into the mirror, which is the start of data[] again
+      auto *pBuffer = m_queue->at(m_allocatedIndex);
+      std::memcpy(pBuffer, &messageSizeBytes, sizeof(MessageSize));
+      m_allocatedIndex += allocationSize;
+      return { pBuffer + sizeof(MessageSize), messageSizeBytes };  // NOLINT(*-pointer-arithmetic)
+    }
+
+    /// Flush any allocated writes.
+    ///
+    /// It is the caller's responsibility to ensure that all
+    /// allocated message buffer spans have been filled before calling flush().
+    void flush() noexcept { m_queue->read_index.store(m_allocatedIndex, std::memory_order_release); }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
+  private:
+    impl::shared_memory_user<QueueLayout> m_queueUser;
+    QueueLayout *m_queue{ nullptr };
+    // a local copy of the write index, we take chunks of data at a time
+    // any only update the atomic write index when we need more
+    std::uint64_t m_cachedWriteIndex{ 0 };
+    // a local read index of allocated, but not committed/flushed message data
+    // once the caller calls flush(), we release this to the consumer
+    std::uint64_t m_allocatedIndex{ 0 };
+
+    void reserve(std::uint64_t minimumRequired) noexcept
+    {
+      // there is no wrap to handle, just make sure the reservation covers this message
+      m_cachedWriteIndex = m_allocatedIndex + std::max(BatchMessageReserve, minimumRequired);
+      m_queue->write_index.store(m_cachedWriteIndex, std::memory_order_release);
+    }
+  };
+
+}  // namespace arquebus::spsc::mirrored_msg
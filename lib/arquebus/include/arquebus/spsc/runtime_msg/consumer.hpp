@@ -0,0 +1,169 @@
+#pragma once
+
+#include "arquebus/impl/runtime_buffer_size.hpp"
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/impl/spsc/runtime_sized_header.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+namespace arquebus::spsc::runtime_msg {
+
+  /// Single Producer Single Consumer Runtime Sized Queue Consumer interface
+  ///
+  /// The queue size is read from the queue when attaching, see host.
+  ///
+  /// @tparam TMessageSize Type for indicating size of message.
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<
+    std::unsigned_integral TMessageSize = std::uint32_t,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class consumer
+  {
+    using QueueLayout = impl::spsc::runtime_sized_header<TMessageSize, CacheLineSize>;
+    using MessageSize = TMessageSize;
+
+  public:
+    /// Create a consumer for the given queue name. The name must match that created by the host
+    /// and used by the producer.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    explicit consumer(std::string_view name, mapping_options const &options = {})
+      : m_queueUser(name, options)
+    {}
+
+    /// Attach the consumer to the queue that has been created by a host.
+    void attach()
+    {
+      m_queueUser.attach();
+
+      m_queue = m_queueUser.mapping();
+      m_queue->wait_and_validate(m_queueUser.mapped_size());
+      m_bufferSize = impl::runtime_buffer_size{ m_queue->header.size_of_queue };
+      m_data = m_queue->data();
+    }
+
+    /// Read the next message from the queue.
+    ///
+    /// This will not block and return immediately. If there is no available message, the optional will be empty.
+    /// The caller is responsible for managing the spinning and retrying for new messages.
+    ///
+    /// If the consumer is overrun by the producer, a std::runtime_error will be thrown
+    ///
+    /// @return An optional span containing the next message data
+    auto read() -> std::optional<std::span<std::byte const>>
+    {
+      if (m_readIndex < m_cachedReadIndex) [[likely]] {
+        return decode_message();
+      }
+
+      update_cached_indices();
+
+      if (m_readIndex < m_cachedReadIndex) [[likely]] {
+        return decode_message();
+      }
+
+      // no waiting message
+      return std::nullopt;
+    }
+
+    /// The size of the queue data in bytes. Only valid once attached.
+    [[nodiscard]] auto queue_size() const noexcept -> std::uint64_t { return m_bufferSize.bytes(); }
+
+    /// Call callback for every message that is available now, up to maxMessages.
+    ///
+    /// The shared indices are loaded, and the consumer checked for overrun, once for the whole batch rather
+    /// than once per message. This will not block, if there is no available message the callback is not called.
+    /// The spans passed to the callback are the same as those returned by read().
+    ///
+    /// If the consumer is overrun by the producer, a std::runtime_error will be thrown
+    ///
+    /// @param callback Called with a std::span<std::byte const> of each message in turn
+    /// @param maxMessages The most messages to process in this batch
+    /// @return The number of messages processed
+    template<std::invocable<std::span<std::byte const>> Callback>
+    auto for_each_available(Callback &&callback, std::size_t maxMessages = std::numeric_limits<std::size_t>::max())
+      -> std::size_t
+    {
+      update_cached_indices();
+
+      // a local copy of the limit, so the callback can not force it to be reloaded every message
+      auto const readIndex = m_cachedReadIndex;
+      std::size_t count = 0;
+      for (; m_readIndex < readIndex and count < maxMessages; ++count) {
+        callback(decode_message());
+      }
+      return count;
+    }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
+  private:
+    impl::shared_memory_user<QueueLayout> m_queueUser;
+    QueueLayout *m_queue{ nullptr };
+    // local copies of the size and data region, so the hot path does not touch the header
+    impl::runtime_buffer_size m_bufferSize;
+    std::byte const *m_data{ nullptr };
+    std::uint64_t m_cachedWriteIndex{ 0 };
+    std::uint64_t m_cachedReadIndex{ 0 };
+    std::uint64_t m_readIndex{ 0 };
+
+    // Decode a message waiting in the queue, see spsc::var_msg::consumer
+    auto decode_message() noexcept -> std::span<std::byte const>
+    {
+      // read the length
+      MessageSize messageSize{ 0 };
+      auto const *pBuffer = &m_data[m_bufferSize.to_offset(m_readIndex)];  // NOLINT(*-pointer-arithmetic)
+      std::memcpy(&messageSize, pBuffer, sizeof(MessageSize));
+
+      if (messageSize == 0) [[unlikely]] {
+        // the producer has moved the next message to the beginning of the buffer
+        m_readIndex += m_bufferSize.distance_to_buffer_start(m_readIndex);
+
+        pBuffer = m_data;
+        std::memcpy(&messageSize, pBuffer, sizeof(MessageSize));
+      }
+
+      // update our cached read index (including the size data)
+      m_readIndex += messageSize + sizeof(MessageSize);
+
+      return { pBuffer + sizeof(MessageSize), messageSize };  // NOLINT(*-pointer-arithmetic)
+    }
+
+    void update_cached_indices()
+    {
+      m_cachedWriteIndex = m_queue->write_index.load(std::memory_order_acquire);
+
+      // check for overrun
+      // Without a power of two size there is no cheap generation to compare, but the indices are absolute
+      // so the producer has overwritten our next message once it has reserved more than a whole queue
+      // ahead of it.
+      if (m_cachedWriteIndex - m_readIndex > m_bufferSize.bytes()) [[unlikely]] {
+        throw std::runtime_error("Queue Overrun detected");
+      }
+
+      m_cachedReadIndex = m_queue->read_index.load(std::memory_order_acquire);
+    }
+  };
+
+}  // namespace arquebus::spsc::runtime_msg
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "arquebus/impl/host_tags.hpp"
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/impl/spsc/runtime_sized_header.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace arquebus::spsc::runtime_msg {
+
+  using arquebus::danger_delete_existing_shared_memory_segment_tag;
+
+  /// Single Producer Single Consumer Runtime Sized Queue Host interface
+  ///
+  /// The size of the queue is chosen when the host is constructed, the producer and consumer read it from
+  /// the queue when they attach. A power of two size uses a mask to wrap the indices, any other size uses a
+  /// slightly more expensive multiply based reduction.
+  ///
+  /// @tparam TMessageSize Type for indicating size of message.
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  template<
+    std::unsigned_integral TMessageSize = std::uint32_t,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class host
+  {
+    using QueueLayout = impl::spsc::runtime_sized_header<TMessageSize, CacheLineSize>;
+
+  public:
+    /// Create a host for the given queue name. The name must match that used by the producer and consumer.
+    ///
+    /// @param name The unique name of the queue to create
+    /// @param queueSize The size of the queue data in bytes
+    /// @param options How to map the shared memory segment
+    host(std::string_view name, std::uint64_t queueSize, mapping_options const &options = {})
+      : m_queueOwner(name, options, 0, checked_queue_size(queueSize))
+      , m_queueSize{ queueSize }
+    {}
+
+    /// Open and create the shared memory queue.
+    ///
+    /// This must occur before the producer or consumer can attempt to connect.
+    void create()
+    {
+      m_queueOwner.create();
+
+      m_queue = m_queueOwner.mapping();
+      m_queue->header.numa_node = m_queueOwner.numa_node();
+      m_queue->initialise(m_queueSize);
+    }
+
+    /// If the shared memory segment already exists, delete it before creating a new one
+    ///
+    /// WARNING: existing open mapping will still see old segment, new mappings will see
+    ///          new file. Be VERY sure you want to do this!
+    void create(danger_delete_existing_shared_memory_segment_tag /*unused*/)
+    {
+      m_queueOwner.delete_existing();
+      create();
+    }
+
+    /// The size of the queue data in bytes
+    [[nodiscard]] auto queue_size() const noexcept -> std::uint64_t { return m_queueSize; }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueOwner.page_size(); }
+
+    /// If huge pages were requested and could not be used, the reason why. Empty otherwise.
+    [[nodiscard]] auto fallback_reason() const -> std::string_view { return m_queueOwner.fallback_reason(); }
+
+  private:
+    impl::shared_memory_owner<QueueLayout> m_queueOwner;
+    std::uint64_t m_queueSize;
+    QueueLayout *m_queue{ nullptr };
+
+    static auto checked_queue_size(std::uint64_t queueSize) -> std::uint64_t
+    {
+      // there must be room for at least one size prefix and a byte of message
+      if (queueSize <= sizeof(TMessageSize)) {
+        throw std::invalid_argument("queue size is too small");
+      }
+      return queueSize;
+    }
+  };
+
+}  // namespace arquebus::spsc::runtime_msg
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "arquebus/impl/runtime_buffer_size.hpp"
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/impl/spsc/runtime_sized_header.hpp"
+#include "arquebus/mapping_options.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+namespace arquebus::spsc::runtime_msg {
+
+  /// Single Producer Single Consumer Runtime Sized Queue Producer interface
+  ///
+  /// The queue size is read from the queue when attaching, see host.
+  ///
+  /// @tparam NBytesBatchMessageReserve Number of bytes to allocate from queue as a chunk to prevent constant
+  /// write index updates.
+  /// @tparam TMessageSize Type for indicating size of message.
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  ///
+  template<
+    std::size_t NBytesBatchMessageReserve,
+    std::unsigned_integral TMessageSize = std::uint32_t,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+  class producer
+  {
+  public:
+    using QueueLayout = impl::spsc::runtime_sized_header<TMessageSize, CacheLineSize>;
+    using MessageSize = TMessageSize;
+    static constexpr auto BatchMessageReserve = std::uint64_t{ NBytesBatchMessageReserve };
+
+    /// Create a producer for the given queue name. The name must match that created by the host
+    /// and used by the consumer.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    explicit producer(std::string_view name, mapping_options const &options = {})
+      : m_queueUser(name, options)
+    {}
+
+    /// Attach the producer to the queue that has been created by a host.
+    ///
+    /// Throws std::logic_error if the queue is too small for BatchMessageReserve, or for any message.
+    void attach()
+    {
+      m_queueUser.attach();
+
+      m_queue = m_queueUser.mapping();
+      m_queue->wait_and_validate(m_queueUser.mapped_size());
+
+      if (BatchMessageReserve >= m_queue->header.size_of_queue - sizeof(MessageSize)) {
+        throw std::logic_error("Can not reserve more than the queue size");
+      }
+      m_bufferSize = impl::runtime_buffer_size{ m_queue->header.size_of_queue };
+      m_data = m_queue->data();
+
+      // half a lap after the first size, see spsc::var_msg::producer::MaxMessageSize
+      auto const lap = m_queue->header.size_of_queue - sizeof(MessageSize);
+      m_maxFrameSize = lap > sizeof(MessageSize) ? (lap - sizeof(MessageSize)) / 2 : 0;
+      if (m_maxFrameSize <= sizeof(MessageSize)) {
+        throw std::logic_error("The queue is too small for a message");
+      }
+      m_maxMessageSize = std::min<std::uint64_t>(
+        m_maxFrameSize - sizeof(MessageSize), std::numeric_limits<MessageSize>::max()
+      );
+
+      // establish the initial write offset
+      m_queue->write_index.store(m_cachedWriteIndex, std::memory_order_release);
+    }
+
+    /// Allocate a write buffer for a message of numberBytes in length.
+    ///
+    /// A messageSizeBytes of zero is not supported and will cause incorrect behaviour. A message larger than
+    /// BatchMessageReserve is given a reservation of its own, up to max_message_size(). A larger message throws
+    /// std::length_error and leaves the queue unchanged.
+    ///
+    /// @param messageSizeBytes Message Length
+    /// @return a span<> for the caller to fill with message data
+    [[nodiscard]] auto allocate_write(MessageSize messageSizeBytes) -> std::span<std::byte>
+    {
+      // message + the next size / skip block ready for next message
+      auto const allocationSize = messageSizeBytes + sizeof(MessageSize);
+
+      // see spsc::var_msg::producer, the size / skip protocol is the same
+      if (m_cachedWriteIndex - m_allocatedIndex < allocationSize) [[unlikely]] {
+        // a reservation is never larger than the largest frame, so only a message that needs one can be too large
+        check_message_size(messageSizeBytes);
+        // allocate more storage. Skipping over index wrap if required
+        reserve(allocationSize);
+      }
+
+      // we have ensured that our allocation will not wrap so safe to index in
+      auto *pBuffer = &m_data[m_bufferSize.to_offset(m_allocatedIndex)];  // NOLINT(*-pointer-arithmetic)
+
+      // write the message size into the buffer, note that this is actually already reserved
+      // and know safe place to write "before" the current allocation index
+      std::memcpy(pBuffer - sizeof(MessageSize), &messageSizeBytes, sizeof(MessageSize));  // NOLINT(*-pointer-arithmetic)
+      m_allocatedIndex += allocationSize;
+      return { pBuffer, messageSizeBytes };
+    }
+
+    /// Flush any allocated writes.
+    ///
+    /// It is the caller's responsibility to ensure that all
+    /// allocated message buffer spans have been filled before calling flush().
+    void flush() noexcept
+    {
+      // We are pre-allocating the next size/skip indicator, so we have to release to just before that
+      // as it is not yet valid
+      m_queue->read_index.store(m_allocatedIndex - sizeof(MessageSize), std::memory_order_release);
+    }
+
+    /// The size of the queue data in bytes. Only valid once attached.
+    [[nodiscard]] auto queue_size() const noexcept -> std::uint64_t { return m_bufferSize.bytes(); }
+
+    /// The largest message that can be written, a little under half the queue. Only valid once attached.
+    [[nodiscard]] auto max_message_size() const noexcept -> std::uint64_t { return m_maxMessageSize; }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
+  private:
+    impl::shared_memory_user<QueueLayout> m_queueUser;
+    QueueLayout *m_queue{ nullptr };
+    // local copies of the size and data region, so the hot path does not touch the header
+    impl::runtime_buffer_size m_bufferSize;
+    std::byte *m_data{ nullptr };
+    // the largest frame, and message, that fits in half the queue
+    std::uint64_t m_maxFrameSize{ 0 };
+    std::uint64_t m_maxMessageSize{ 0 };
+    // a local copy of the write index, we take chunks of data at a time
+    // any only update the atomic write index when we need more
+    std::uint64_t m_cachedWriteIndex{ sizeof(MessageSize) };
+
+    // a local read index of allocated, but not committed/flushed message data
+    // once the caller calls flush(), we release this to the consumer
+    std::uint64_t m_allocatedIndex{ sizeof(MessageSize) };
+
+    void check_message_size(MessageSize messageSizeBytes) const
+    {
+      if (messageSizeBytes > m_maxMessageSize) [[unlikely]] {
+        throw std::length_error("Message is larger than the queue can take");
+      }
+    }
+
+    void reserve(std::size_t minimumRequired) noexcept
+    {
+      // the batch, or enough for this message if it is larger
+      m_cachedWriteIndex =
+        std::max(m_cachedWriteIndex + BatchMessageReserve + sizeof(MessageSize), m_allocatedIndex + minimumRequired);
+
+      // The current allocation and minRequired already contains the size bytes
+      auto const offsetOfAllocatedIndex = m_bufferSize.to_offset(m_allocatedIndex - sizeof(MessageSize));
+      auto const offsetOfNextAllocationIndex = m_bufferSize.to_offset(m_allocatedIndex + minimumRequired);
+      // have we wrapped?
+      if (offsetOfNextAllocationIndex < offsetOfAllocatedIndex) [[unlikely]] {
+        // mark the rest of the buffer as skipped, the reserved size slot is always safe to write
+        MessageSize zero{ 0u };
+        std::memcpy(&m_data[offsetOfAllocatedIndex], &zero, sizeof(MessageSize));  // NOLINT(*-pointer-arithmetic)
+
+        // move our allocation to the beginning of the buffer, including the reserved "next" size
+        auto wrapCount = m_bufferSize.distance_to_buffer_start(m_allocatedIndex - sizeof(MessageSize));
+        m_allocatedIndex += wrapCount;
+        m_cachedWriteIndex += wrapCount;
+      }
+
+      // Never reserve past the end of the buffer. The allocations from this reservation are only checked
+      // against the write index, so one that ran past the end would straddle the wrap.
+      auto const sizeIndex = m_allocatedIndex - sizeof(MessageSize);
+      m_cachedWriteIndex = std::min(m_cachedWriteIndex, sizeIndex + m_bufferSize.distance_to_buffer_start(sizeIndex));
+      // nor more than the largest frame, so a message that fits in the reservation is never too large
+      m_cachedWriteIndex = std::min(m_cachedWriteIndex, m_allocatedIndex + m_maxFrameSize);
+
+      // inform consumer of updated allocation
+      m_queue->write_index.store(m_cachedWriteIndex, std::memory_order_release);
+    }
+  };
+
+}  // namespace arquebus::spsc::runtime_msg
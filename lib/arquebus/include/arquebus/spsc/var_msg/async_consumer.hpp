@@ -0,0 +1,196 @@
+#pragma once
+
+#include "arquebus/flow_control.hpp"
+#include "arquebus/impl/cpu_relax.hpp"
+#include "arquebus/mapping_options.hpp"
+#include "arquebus/spsc/var_msg/consumer.hpp"
+#include "arquebus/wait_strategy.hpp"
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <semaphore>
+#include <span>
+#include <stop_token>
+#include <string_view>
+#include <thread>
+
+namespace arquebus::spsc::var_msg {
+
+  /// An executor that an async_consumer resumes coroutines on. post() must be safe to call from any thread and
+  /// resume the coroutine on one of the executor's threads.
+  template<typename T>
+  concept executor = requires(T executor, std::coroutine_handle<> handle) {
+    { executor.post(handle) };
+  };
+
+  /// Single Producer Single Consumer Queue Consumer for coroutines
+  ///
+  /// co_await next() gives the next message. If one arrives within a short spin the coroutine carries on without
+  /// suspending. Otherwise it is suspended, and a waiter thread owned by the async_consumer parks on the queue's
+  /// futex (see wait::spin_then_park) until the producer flushes. The coroutine is then resumed by posting it to
+  /// the executor. The waiter thread uses no CPU while it is parked.
+  ///
+  /// Only one next() may be outstanding at a time. The messages are spans into the queue, exactly as from
+  /// consumer::read(), and are valid until the next call to next().
+  ///
+  /// @tparam Executor Where to resume suspended coroutines
+  /// @tparam Size2NBits Queue Size in exponent for 2^N
+  /// @tparam TMessageSize Type for indicating size of message.
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  /// @tparam PayloadAlignment Every message payload starts on a multiple of this many bytes, see producer.
+  template<
+    executor Executor,
+    std::uint8_t Size2NBits,
+    std::unsigned_integral TMessageSize = std::uint32_t,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size,
+    std::size_t PayloadAlignment = 1>
+  class async_consumer
+  {
+    using Consumer = consumer<Size2NBits, TMessageSize, CacheLineSize, PayloadAlignment>;
+    using Message = std::span<std::byte const>;
+
+  public:
+    /// Create a consumer for the given queue name. The name must match that created by the host
+    /// and used by the producer.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param executor Where to resume coroutines that had to wait for a message. Must outlive the consumer.
+    /// @param options How to map the shared memory segment
+    /// @param overrun What to do if the producer overwrites messages before they are read
+    /// @param spinCount How many times next() checks for a message before it suspends
+    async_consumer(
+      std::string_view name,
+      Executor &executor,
+      mapping_options const &options = {},
+      overrun_policy overrun = overrun_policy::Throw,
+      std::uint32_t spinCount = 1'000
+    )
+      : m_consumer(name, options, overrun)
+      , m_executor{ &executor }
+      , m_spinCount{ spinCount }
+    {}
+
+    // no move or copy, the waiter thread refers to us
+    async_consumer(async_consumer &&) = delete;
+    auto operator=(async_consumer &&) -> async_consumer & = delete;
+    async_consumer(async_consumer const &) = delete;
+    auto operator=(async_consumer const &) -> async_consumer & = delete;
+
+    /// Stops the waiter thread. A coroutine that is suspended in next() will not be resumed.
+    ~async_consumer()
+    {
+      if (m_waiter.joinable()) {
+        m_waiter.request_stop();
+        m_stop.request_stop();
+        m_request.release();
+      }
+    }
+
+    /// Attach the consumer to the queue that has been created by a host, and start the waiter thread.
+    void attach()
+    {
+      m_consumer.attach();
+      m_waiter = std::jthread{ [this](std::stop_token const &stop) { wait_for_messages(stop); } };
+    }
+
+    class next_awaitable
+    {
+    public:
+      [[nodiscard]] auto await_ready() -> bool
+      {
+        for (std::uint32_t i = 0; i < m_owner->m_spinCount; ++i) {
+          m_message = m_owner->m_consumer.read();
+          if (m_message.has_value()) {
+            return true;
+          }
+          impl::cpu_relax();
+        }
+        return false;
+      }
+
+      void await_suspend(std::coroutine_handle<> handle) noexcept
+      {
+        m_handle = handle;
+        m_owner->m_waiting = this;
+        m_owner->m_request.release();
+      }
+
+      /// @return The next message, or empty if stop() was called while waiting
+      auto await_resume() -> std::optional<Message>
+      {
+        if (m_error) {
+          std::rethrow_exception(m_error);
+        }
+        return m_message;
+      }
+
+    private:
+      friend class async_consumer;
+
+      explicit next_awaitable(async_consumer *owner) noexcept
+        : m_owner{ owner }
+      {}
+
+      async_consumer *m_owner;
+      std::coroutine_handle<> m_handle{};
+      std::optional<Message> m_message{};
+      std::exception_ptr m_error{};
+    };
+
+    /// Await the next message.
+    ///
+    /// If the consumer is overrun by the producer, a std::runtime_error will be thrown from the co_await, or with
+    /// overrun_policy::Resync it skips ahead, see consumer::read().
+    ///
+    /// @return An awaitable giving an optional span containing the next message data, empty only after stop()
+    [[nodiscard]] auto next() noexcept -> next_awaitable { return next_awaitable{ this }; }
+
+    /// Stop waiting. A coroutine suspended in next() is resumed with an empty message, and any later next()
+    /// that has to wait is resumed at once with an empty message.
+    void stop() noexcept { m_stop.request_stop(); }
+
+    /// What has been skipped because the producer overran the consumer, with overrun_policy::Resync
+    [[nodiscard]] auto losses() const noexcept -> overrun_losses const & { return m_consumer.losses(); }
+
+  private:
+    Consumer m_consumer;
+    Executor *m_executor;
+    std::uint32_t m_spinCount;
+    // the suspended next(), handed from the coroutine to the waiter thread by releasing m_request
+    next_awaitable *m_waiting{ nullptr };
+    std::binary_semaphore m_request{ 0 };
+    // stops the wait for a message, either from stop() or when we are destroyed
+    std::stop_source m_stop;
+    std::jthread m_waiter;
+
+    void wait_for_messages(std::stop_token const &threadStop)
+    {
+      // no spinning, next() has already done that
+      wait::spin_then_park strategy{ 0, std::chrono::milliseconds{ 10 } };
+
+      while (true) {
+        m_request.acquire();
+        if (threadStop.stop_requested()) {
+          return;
+        }
+        auto *awaiting = m_waiting;
+
+        // The coroutine is suspended, so we are the only user of the consumer until it is resumed
+        try {
+          awaiting->m_message = m_consumer.read_wait(strategy, m_stop.get_token());
+        } catch (...) {
+          awaiting->m_error = std::current_exception();
+        }
+        if (threadStop.stop_requested()) {
+          return;
+        }
+        m_executor->post(awaiting->m_handle);
+      }
+    }
+  };
+
+}  // namespace arquebus::spsc::var_msg
@@ -1,12 +1,26 @@
 #pragma once
 
+#include "arquebus/flow_control.hpp"
+#include "arquebus/impl/event_notification.hpp"
+#include "arquebus/impl/fd_handle.hpp"
 #include "arquebus/impl/shared_memory_helper.hpp"
 #include "arquebus/impl/spsc/variable_message_length_header.hpp"
+#include "arquebus/mapping_options.hpp"
+#include "arquebus/wait_strategy.hpp"
 
+#include <chrono>
+#include <concepts>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <limits>
+#include <new>
 #include <optional>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
 #include <string_view>
+#include <type_traits>
 
 namespace arquebus::spsc::var_msg {
 
@@ -15,13 +29,16 @@ namespace arquebus::spsc::var_msg {
   /// @tparam Size2NBits Queue Size in exponent for 2^N
   /// @tparam TMessageSize Type for indicating size of message.
   /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  /// @tparam PayloadAlignment Every message payload starts on a multiple of this many bytes, see producer.
   template<
     std::uint8_t Size2NBits,
     std::unsigned_integral TMessageSize = std::uint32_t,
-    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size,
+    std::size_t PayloadAlignment = 1>
   class consumer
   {
-    using QueueLayout = impl::spsc::variable_message_length_header<Size2NBits, TMessageSize, CacheLineSize>;
+    using QueueLayout =
+      impl::spsc::variable_message_length_header<Size2NBits, TMessageSize, CacheLineSize, PayloadAlignment>;
     using MessageSize = TMessageSize;
 
   public:
@@ -29,8 +46,15 @@ namespace arquebus::spsc::var_msg {
     /// and used by the producer.
     ///
     /// @param name The unique name of the queue to attach to
-    explicit consumer(std::string_view name)
-      : m_queueUser(name)
+    /// @param options How to map the shared memory segment
+    /// @param overrun What to do if the producer overwrites messages before they are read
+    explicit consumer(
+      std::string_view name,
+      mapping_options const &options = {},
+      overrun_policy overrun = overrun_policy::Throw
+    )
+      : m_queueUser(name, options)
+      , m_overrunPolicy{ overrun }
     {}
 
     /// Attach the consumer to the queue that has been created by a host.
@@ -40,6 +64,9 @@ namespace arquebus::spsc::var_msg {
 
       m_queue = m_queueUser.mapping();
       m_queue->wait_and_validate();
+      if (m_queue->notify == notification::EventFd) {
+        m_eventFd = impl::request_eventfd(m_queueUser.name());
+      }
     }
 
     /// Read the next message from the queue.
@@ -47,7 +74,8 @@ namespace arquebus::spsc::var_msg {
     /// This will not block and return immediately. If there is no available message, the optional will be empty.
     /// The caller is responsible for managing the spinning and retrying for new messages.
     ///
-    /// If the consumer is overrun by the producer, a std::runtime_error will be thrown
+    /// If the consumer is overrun by the producer, a std::runtime_error will be thrown, or with
+    /// overrun_policy::Resync it skips ahead to a recent message and the loss is added to losses().
     ///
     /// @return An optional span containing the next message data
     auto read() -> std::optional<std::span<std::byte const>>
@@ -66,12 +94,140 @@ namespace arquebus::spsc::var_msg {
       return std::nullopt;
     }
 
+    /// Read the next message from the queue, waiting for one if none is available.
+    ///
+    /// Each time the queue is found empty strategy decides how to wait, by spinning, yielding or parking until
+    /// the producer flushes. See arquebus::wait.
+    ///
+    /// If the consumer is overrun by the producer, a std::runtime_error will be thrown, see read()
+    ///
+    /// @param strategy How to wait for a message
+    /// @param stop Stop waiting once a stop is requested. A parked consumer notices within the park timeout.
+    /// @return An optional span containing the next message data, empty only if a stop was requested
+    template<wait::strategy Strategy>
+    auto read_wait(Strategy &strategy, std::stop_token const &stop = {}) -> std::optional<std::span<std::byte const>>
+    {
+      strategy.reset();
+      while (true) {
+        if (auto message = read(); message.has_value()) {
+          return message;
+        }
+        if (stop.stop_requested()) {
+          return std::nullopt;
+        }
+        strategy.idle([this](std::chrono::nanoseconds timeout) {
+          m_queue->wakeup.park(timeout, [this] {
+            return m_readIndex < m_queue->read_index.load(std::memory_order_relaxed);
+          });
+        });
+      }
+    }
+
+    /// Read the next message from the queue as a T, in place and without a copy.
+    ///
+    /// The producer must have written the message with allocate_write<T>(), or an allocate_write() of
+    /// sizeof(T) that it filled with a T. If the message is a different size a std::runtime_error is thrown,
+    /// the message is still consumed.
+    ///
+    /// @return A pointer to the next message, or nullptr if there is no available message
+    template<typename T>
+      requires std::is_trivially_copyable_v<T>
+    auto read_as() -> T const *
+    {
+      static_assert(alignof(T) <= PayloadAlignment, "PayloadAlignment is too small for T");
+
+      auto message = read();
+      if (not message.has_value()) {
+        return nullptr;
+      }
+      if (message->size() != sizeof(T)) {
+        throw std::runtime_error("message size does not match type");
+      }
+      // NOLINTNEXTLINE(*-reinterpret-cast)
+      return std::launder(reinterpret_cast<T const *>(message->data()));
+    }
+
+    /// Call callback for every message that is available now, up to maxMessages.
+    ///
+    /// The shared indices are loaded, and the consumer checked for overrun, once for the whole batch rather
+    /// than once per message. This will not block, if there is no available message the callback is not called.
+    /// The spans passed to the callback are the same as those returned by read().
+    ///
+    /// If the consumer is overrun by the producer, a std::runtime_error will be thrown, see read()
+    ///
+    /// @param callback Called with a std::span<std::byte const> of each message in turn
+    /// @param maxMessages The most messages to process in this batch
+    /// @return The number of messages processed
+    template<std::invocable<std::span<std::byte const>> Callback>
+    auto for_each_available(Callback &&callback, std::size_t maxMessages = std::numeric_limits<std::size_t>::max())
+      -> std::size_t
+    {
+      update_cached_indices();
+
+      // a local copy of the limit, so the callback can not force it to be reloaded every message
+      auto const readIndex = m_cachedReadIndex;
+      std::size_t count = 0;
+      for (; m_readIndex < readIndex and count < maxMessages; ++count) {
+        callback(decode_message());
+      }
+      return count;
+    }
+
+    /// The eventfd to wait on in an epoll (or poll, select) set, if the host chose notification::EventFd,
+    /// otherwise -1. It becomes readable when the producer flushes after arm_notification().
+    [[nodiscard]] auto native_handle() const noexcept -> int { return m_eventFd; }
+
+    /// Ask the producer to make native_handle() readable when it next flushes. Call this once read() finds no
+    /// more messages, before waiting on native_handle(). It is cleared until then.
+    ///
+    /// This is a full fence, the producer only pays for a write() to the eventfd when it is armed.
+    ///
+    /// @return false if messages arrived in the meantime, it is not armed and they should be read instead. Also
+    /// false, and never armed, if the host did not choose notification::EventFd, as there is nothing to wait on.
+    auto arm_notification() noexcept -> bool
+    {
+      if (m_eventFd < 0) [[unlikely]] {
+        return false;
+      }
+      impl::drain_eventfd(m_eventFd);
+      return m_queue->wakeup.arm([this] { return m_readIndex < m_queue->read_index.load(std::memory_order_relaxed); });
+    }
+
+    /// What has been skipped because the producer overran the consumer, with overrun_policy::Resync
+    [[nodiscard]] auto losses() const noexcept -> overrun_losses const & { return m_losses; }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Identifies the message types of a typed queue, see typed_host, or zero for an untyped queue.
+    /// Only valid once attached.
+    [[nodiscard]] auto catalog_hash() const noexcept -> std::uint64_t { return m_queue->header.catalog_hash; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
+    }
+
   private:
     impl::shared_memory_user<QueueLayout> m_queueUser;
     QueueLayout *m_queue{ nullptr };
     std::uint64_t m_cachedWriteIndex{ 0 };
     std::uint64_t m_cachedReadIndex{ 0 };
-    std::uint64_t m_readIndex{ 0 };
+    // the first size is after any frame padding
+    std::uint64_t m_readIndex{ QueueLayout::FramePadding };
+    // only with notification::EventFd
+    impl::fd_handle m_eventFd;
+    // how far we have read, last time we told the producer
+    std::uint64_t m_publishedIndex{ 0 };
+    overrun_policy m_overrunPolicy;
+    // the messages read, to work out how many were lost when we resync
+    std::uint64_t m_messagesRead{ 0 };
+    overrun_losses m_losses{};
 
     // Decode a message waiting in the queue.
     // We can assume that the message will never wrap around the queue buffer as the writer
@@ -91,15 +247,16 @@ namespace arquebus::spsc::var_msg {
         // if we have read the zero, we know the producer has already moved the read and write indices
         // beyond the wrap and past the next message. This means that we have also, already received those
         // updated indices so at least the next message is within our read range.
-        m_readIndex += QueueLayout::BufferSize::distance_to_buffer_start(m_readIndex);
+        m_readIndex += QueueLayout::BufferSize::distance_to_buffer_start(m_readIndex) + QueueLayout::FramePadding;
 
         // we have wrapped to the beginning
-        pBuffer = &m_queue->data[0];
+        pBuffer = &m_queue->data[QueueLayout::FramePadding];
         std::memcpy(&messageSize, pBuffer, sizeof(MessageSize));
       }
 
-      // update our cached read index (including the size data)
-      m_readIndex += messageSize + sizeof(MessageSize);
+      // update our cached read index (including the size data and any padding)
+      m_readIndex += QueueLayout::frame_size(messageSize);
+      ++m_messagesRead;
 
       // return the span
       return { pBuffer + sizeof(MessageSize), messageSize };
@@ -107,35 +264,45 @@ namespace arquebus::spsc::var_msg {
 
     void update_cached_indices()
     {
+      // The caller is asking for more, so every span we have returned is done with. The producer uses this for
+      // flow_control::Backpressure and flush_policy::adaptive(). Only store when it has changed, so an idle
+      // consumer does not keep taking the line from the producer.
+      if (m_publishedIndex != m_readIndex) {
+        m_publishedIndex = m_readIndex;
+        m_queue->consumer_index.store(m_publishedIndex, std::memory_order_release);
+      }
+
       // currently we have no new data in our cached counters, so we update them
       // from the shared atomics in the queue and try again.
       m_cachedWriteIndex = m_queue->write_index.load(std::memory_order_acquire);
 
       // check for overrun
-      // This will occur if our current read index (as a physical buffer offset) has been
-      // overrun by the new write index.
-      //
-      // The non-offset bits of the index should be considered a "generation" and the offset (Mask) bits
-      // are the actual location in the buffer.
-      //
-      // An overlap occurs when the read offset < write offset AND read generation < write generation
-      //
-      // Note that we check the generation first before computing and checking the offset because
-      // it only when the buffer initially wraps that they will be different as the write index advances
-      // by a batch size that is less than the overall length.
-      auto readGeneration = QueueLayout::BufferSize::to_generation(m_readIndex) ;
-      auto writeGeneration = QueueLayout::BufferSize::to_generation(m_cachedWriteIndex);
-
-      if(readGeneration < writeGeneration) [[ unlikely]] {
-        auto readOffset = QueueLayout::BufferSize::to_offset(m_readIndex) ;
-        auto writeOffset = QueueLayout::BufferSize::to_offset(m_cachedWriteIndex);
-        if(readOffset < writeOffset) [[unlikely]] {
+      // This will occur if the producer has reserved more than a full queue beyond our current read index,
+      // and so may have written over the message there.
+      while (m_cachedWriteIndex > m_readIndex + QueueLayout::BufferSize::Bytes) [[unlikely]] {
+        if (m_overrunPolicy == overrun_policy::Throw) {
           throw std::runtime_error("Queue Overrun detected");
         }
+        resync();
       }
 
       m_cachedReadIndex = m_queue->read_index.load(std::memory_order_acquire);
     }
+
+    // Skip ahead to the latest sync point published by the producer, it is within a reservation of the write
+    // index. The producer may have overrun that too by the time we look, so the caller checks again.
+    void resync() noexcept
+    {
+      auto const point = m_queue->load_sync_point();
+
+      ++m_losses.overruns;
+      m_losses.messages += point.messages - m_messagesRead;
+      m_losses.bytes += point.index - m_readIndex;
+
+      m_readIndex = point.index;
+      m_messagesRead = point.messages;
+      m_cachedWriteIndex = m_queue->write_index.load(std::memory_order_acquire);
+    }
   };
 
 }  // namespace arquebus::spsc::var_msg
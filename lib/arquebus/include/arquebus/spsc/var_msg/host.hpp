@@ -1,36 +1,58 @@
 #pragma once
 
+#include "arquebus/flow_control.hpp"
+#include "arquebus/impl/event_notification.hpp"
+#include "arquebus/impl/host_tags.hpp"
 #include "arquebus/impl/shared_memory_helper.hpp"
 #include "arquebus/impl/spsc/variable_message_length_header.hpp"
+#include "arquebus/mapping_options.hpp"
+#include "arquebus/notification.hpp"
 
+#include <cstdint>
+#include <memory>
 #include <stdexcept>
 #include <string_view>
 
 namespace arquebus::spsc::var_msg {
 
-  struct danger_delete_existing_shared_memory_segment_tag
-  {
-  };
+  using arquebus::danger_delete_existing_shared_memory_segment_tag;
 
   /// Single Producer Single Consumer Queue Host interface
   ///
   /// @tparam Size2NBits Queue Size in exponent for 2^N
   /// @tparam TMessageSize Type for indicating size of message.
   /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  /// @tparam PayloadAlignment Every message payload starts on a multiple of this many bytes, see producer.
   template<
     std::uint8_t Size2NBits,
     std::unsigned_integral TMessageSize = std::uint32_t,
-    std::size_t CacheLineSize = std::hardware_destructive_interference_size>
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size,
+    std::size_t PayloadAlignment = 1>
   class host
   {
-    using QueueLayout = impl::spsc::variable_message_length_header<Size2NBits, TMessageSize, CacheLineSize>;
+    using QueueLayout =
+      impl::spsc::variable_message_length_header<Size2NBits, TMessageSize, CacheLineSize, PayloadAlignment>;
 
   public:
     /// Create a host for the given queue name. The name must match that used by the producer and consumer.
     ///
     /// @param name The unique name of the queue to create
-    explicit host(std::string_view name)
-      : m_queueOwner(name)
+    /// @param options How to map the shared memory segment
+    /// @param flowControl Whether the producer may overwrite messages the consumer has not read
+    /// @param notifyBy How the consumer can be notified of new messages. An eventfd is handed to the producer and
+    /// consumer over a socket by the host, so the host must be running when they attach.
+    /// @param catalogHash Identifies the message types of a typed queue, see typed_host. Zero for an untyped queue.
+    explicit host(
+      std::string_view name,
+      mapping_options const &options = {},
+      flow_control flowControl = flow_control::Overwrite,
+      notification notifyBy = notification::None,
+      std::uint64_t catalogHash = 0
+    )
+      : m_queueOwner(name, options)
+      , m_flowControl{ flowControl }
+      , m_notification{ notifyBy }
+      , m_catalogHash{ catalogHash }
     {}
 
     /// Open and create the shared memory queue.
@@ -41,7 +63,11 @@ namespace arquebus::spsc::var_msg {
       m_queueOwner.create();
 
       m_queue = m_queueOwner.mapping();
-      m_queue->initialise();
+      m_queue->header.numa_node = m_queueOwner.numa_node();
+      if (m_notification == notification::EventFd) {
+        m_eventFd = std::make_unique<impl::eventfd_host>(m_queueOwner.name());
+      }
+      m_queue->initialise(m_flowControl, m_notification, m_catalogHash);
     }
 
     /// If the shared memory segment already exists, delete it before creating a new one
@@ -54,8 +80,18 @@ namespace arquebus::spsc::var_msg {
       create();
     }
 
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueOwner.page_size(); }
+
+    /// If huge pages were requested and could not be used, the reason why. Empty otherwise.
+    [[nodiscard]] auto fallback_reason() const -> std::string_view { return m_queueOwner.fallback_reason(); }
+
   private:
     impl::shared_memory_owner<QueueLayout> m_queueOwner;
+    flow_control m_flowControl;
+    notification m_notification;
+    std::uint64_t m_catalogHash;
+    std::unique_ptr<impl::eventfd_host> m_eventFd;
     QueueLayout *m_queue{ nullptr };
   };
 
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "arquebus/fairness.hpp"
+#include "arquebus/flow_control.hpp"
+#include "arquebus/mapping_options.hpp"
+#include "arquebus/ready_set.hpp"
+#include "arquebus/spsc/var_msg/consumer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace arquebus::spsc::var_msg {
+
+  /// Drains many Single Producer Single Consumer queues from one thread
+  ///
+  /// Each poll() is one sweep over the queues that may have messages, sharing it between them by the fairness
+  /// policy. A queue found empty is not read again until it may have more messages.
+  ///
+  /// Without a ready set every queue may have messages at the start of each sweep, so a sweep loads the index
+  /// cache lines of every queue even if only one of them is active. With a ready set, whose producers call
+  /// producer::signal_ready() with the queue's slot, a sweep loads the ready set's cache line and then only the
+  /// queues marked in it, and those that had more to read at the end of the last sweep.
+  ///
+  /// Every queue must be of the same type.
+  ///
+  /// @tparam Size2NBits Queue Size in exponent for 2^N
+  /// @tparam TMessageSize Type for indicating size of message.
+  /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  /// @tparam PayloadAlignment Every message payload starts on a multiple of this many bytes, see producer.
+  template<
+    std::uint8_t Size2NBits,
+    std::unsigned_integral TMessageSize = std::uint32_t,
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size,
+    std::size_t PayloadAlignment = 1>
+  class poller
+  {
+  public:
+    using Consumer = consumer<Size2NBits, TMessageSize, CacheLineSize, PayloadAlignment>;
+
+    /// The most queues a poller can drain
+    static constexpr std::size_t MaxQueues = ready_set<CacheLineSize>::MaxQueues;
+
+    /// Create a poller that checks every queue in each sweep
+    ///
+    /// @param policy How to share a sweep between the queues
+    explicit poller(fairness policy = fairness::RoundRobin) noexcept
+      : m_fairness{ policy }
+    {}
+
+    /// Create a poller that only checks the queues marked in readySet
+    ///
+    /// @param readySet An attached ready set, it must outlive the poller
+    /// @param policy How to share a sweep between the queues
+    explicit poller(ready_set<CacheLineSize> &readySet, fairness policy = fairness::RoundRobin) noexcept
+      : m_readySet{ &readySet }
+      , m_fairness{ policy }
+    {}
+
+    /// Attach a consumer to the queue that has been created by a host, and add it to the poller.
+    ///
+    /// With fairness::Priority the queues added first are read first.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    /// @param overrun What to do if the producer overwrites messages before they are read
+    /// @param weight The most messages read from the queue in a sweep, with fairness::Weighted
+    /// @return The queue's slot, given to poll() callbacks and to be given to the producer's signal_ready()
+    auto add(
+      std::string_view name,
+      mapping_options const &options = {},
+      overrun_policy overrun = overrun_policy::Throw,
+      std::uint32_t weight = 1
+    ) -> std::size_t
+    {
+      if (m_consumers.size() == MaxQueues) {
+        throw std::logic_error("poller already has the most queues");
+      }
+      if (weight == 0) {
+        throw std::logic_error("queue weight must be at least one");
+      }
+
+      auto queue = std::make_unique<Consumer>(name, options, overrun);
+      queue->attach();
+
+      auto const slot = m_consumers.size();
+      m_consumers.push_back(std::move(queue));
+      m_weights.at(slot) = weight;
+      // it may have messages already
+      m_all |= slot_bit(slot);
+      m_active |= slot_bit(slot);
+      return slot;
+    }
+
+    /// Sweep the queues, reading the messages the fairness policy allows.
+    ///
+    /// The messages are only valid until the next read of the same queue.
+    ///
+    /// @param callback Called with the queue's slot and a std::span<std::byte const> of each message in turn
+    /// @param maxMessages The most messages to read in this sweep
+    /// @return The number of messages read
+    template<std::invocable<std::size_t, std::span<std::byte const>> Callback>
+    auto poll(Callback &&callback, std::size_t maxMessages = std::numeric_limits<std::size_t>::max()) -> std::size_t
+    {
+      if (m_readySet != nullptr) {
+        m_active |= m_readySet->take();
+      } else {
+        m_active = m_all;
+      }
+
+      // the queues to visit in this sweep
+      auto remaining = m_active;
+      std::size_t count = 0;
+      while (remaining != 0 and count < maxMessages) {
+        auto const slot = next_slot(remaining);
+        remaining &= ~slot_bit(slot);
+
+        auto const limit = std::min<std::size_t>(quota(slot), maxMessages - count);
+        auto const read = m_consumers[slot]->for_each_available(
+          [&callback, slot](std::span<std::byte const> message) { callback(slot, message); }, limit
+        );
+        count += read;
+        if (read < limit) {
+          // drained, it will be marked again when it has more
+          m_active &= ~slot_bit(slot);
+        }
+        m_next = (slot + 1) % MaxQueues;
+      }
+      return count;
+    }
+
+    /// The consumer in slot, for example for its losses()
+    [[nodiscard]] auto at(std::size_t slot) -> Consumer & { return *m_consumers.at(slot); }
+
+    /// The number of queues added
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return m_consumers.size(); }
+
+  private:
+    std::vector<std::unique_ptr<Consumer>> m_consumers;
+    std::array<std::uint32_t, MaxQueues> m_weights{};
+    ready_set<CacheLineSize> *m_readySet{ nullptr };
+    fairness m_fairness;
+    // a bit for every queue, and for those that may have messages
+    std::uint64_t m_all{ 0 };
+    std::uint64_t m_active{ 0 };
+    // where the next round robin sweep starts
+    std::size_t m_next{ 0 };
+
+    static constexpr auto slot_bit(std::size_t slot) noexcept -> std::uint64_t { return std::uint64_t{ 1 } << slot; }
+
+    // the next queue to visit, the first added for fairness::Priority, otherwise the next at or after m_next
+    [[nodiscard]] auto next_slot(std::uint64_t remaining) const noexcept -> std::size_t
+    {
+      if (m_fairness != fairness::Priority) {
+        auto const after = remaining & (~std::uint64_t{ 0 } << m_next);
+        if (after != 0) {
+          return static_cast<std::size_t>(std::countr_zero(after));
+        }
+      }
+      return static_cast<std::size_t>(std::countr_zero(remaining));
+    }
+
+    // the most messages to read from slot in one visit
+    [[nodiscard]] auto quota(std::size_t slot) const noexcept -> std::size_t
+    {
+      switch (m_fairness) {
+      case fairness::RoundRobin:
+        return 1;
+      case fairness::Weighted:
+        return m_weights[slot];
+      case fairness::Priority:
+        return std::numeric_limits<std::size_t>::max();
+      }
+      return 1;
+    }
+  };
+
+}  // namespace arquebus::spsc::var_msg
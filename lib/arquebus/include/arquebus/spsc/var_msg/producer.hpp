@@ -1,13 +1,24 @@
 #pragma once
 
+#include "arquebus/flush_policy.hpp"
+#include "arquebus/impl/cpu_relax.hpp"
+#include "arquebus/impl/cycle_counter.hpp"
+#include "arquebus/impl/event_notification.hpp"
+#include "arquebus/impl/fd_handle.hpp"
 #include "arquebus/impl/shared_memory_helper.hpp"
 #include "arquebus/impl/spsc/variable_message_length_header.hpp"
+#include "arquebus/mapping_options.hpp"
+#include "arquebus/ready_set.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <limits>
+#include <new>
 #include <span>
 #include <stdexcept>
 #include <string_view>
+#include <type_traits>
 
 namespace arquebus::spsc::var_msg {
 
@@ -18,30 +29,47 @@ namespace arquebus::spsc::var_msg {
   /// write index updates.
   /// @tparam TMessageSize Type for indicating size of message.
   /// @tparam CacheLineSize The CPU cache line size. Defaults to std::hardware_destructive_interference_size
+  /// @tparam PayloadAlignment Every message payload starts on a multiple of this many bytes, so it can be
+  /// accessed in place as any type with that alignment or less. Each message is padded to keep the next one
+  /// aligned. The default of 1 adds no padding.
   ///
   template<
     std::uint8_t Size2NBits,
     std::size_t NBytesBatchMessageReserve,
     std::unsigned_integral TMessageSize = std::uint32_t,
-    std::size_t CacheLineSize = std::hardware_destructive_interference_size >
+    std::size_t CacheLineSize = std::hardware_destructive_interference_size,
+    std::size_t PayloadAlignment = 1>
   class producer
   {
   public:
-    using QueueLayout = impl::spsc::variable_message_length_header<Size2NBits, TMessageSize, CacheLineSize>;
+    using QueueLayout =
+      impl::spsc::variable_message_length_header<Size2NBits, TMessageSize, CacheLineSize, PayloadAlignment>;
     using MessageSize = TMessageSize;
     static constexpr auto BatchMessageReserve = std::uint64_t{ NBytesBatchMessageReserve };
 
     static_assert(
-      BatchMessageReserve < (QueueLayout::BufferSize::Bytes - sizeof(MessageSize)),
+      BatchMessageReserve < (QueueLayout::BufferSize::Bytes - QueueLayout::FirstPayload),
       "Can not reserve more than the queue size"
     );
+    static_assert(QueueLayout::MaxFrameSize > sizeof(MessageSize), "The queue is too small for a message");
+
+    /// The largest message the queue can take, a little under half the queue. A message that has to skip to the
+    /// start of the queue can then never cover messages that have not been read.
+    static constexpr std::uint64_t MaxMessageSize = QueueLayout::MaxMessageSize;
 
     /// Create a producer for the given queue name. The name must match that created by the host
     /// and used by the consumer.
     ///
     /// @param name The unique name of the queue to attach to
-    explicit producer(std::string_view name)
-      : m_queueUser(name)
+    /// @param options How to map the shared memory segment
+    /// @param flushPolicy When flush() publishes messages to the consumer
+    explicit producer(
+      std::string_view name,
+      mapping_options const &options = {},
+      flush_policy flushPolicy = flush_policy::every_flush()
+    )
+      : m_queueUser(name, options)
+      , m_flushPolicy{ flushPolicy }
     {}
 
     /// Attach the producer to the queue that has been created by a host.
@@ -51,21 +79,44 @@ namespace arquebus::spsc::var_msg {
 
       m_queue = m_queueUser.mapping();
       m_queue->wait_and_validate();
+      m_backpressure = m_queue->flow == flow_control::Backpressure;
+      if (m_queue->notify == notification::EventFd) {
+        m_eventFd = impl::request_eventfd(m_queueUser.name());
+      }
       // establish the initial write offset
       m_queue->write_index.store(m_cachedWriteIndex, std::memory_order_release);
     }
 
+    /// Mark slot in readySet each time messages are published, so a poller using the ready set knows to read
+    /// this queue. The slot is the one the poller gave the queue. Costs a fence and a load of the ready set's
+    /// cache line per publish, and a write only when the poller has taken the mark since the last one.
+    ///
+    /// @param readySet An attached ready set, it must outlive the producer
+    /// @param slot The queue's slot in the ready set
+    void signal_ready(ready_set<CacheLineSize> &readySet, std::size_t slot)
+    {
+      if (slot >= ready_set<CacheLineSize>::MaxQueues) {
+        throw std::logic_error("ready set slot out of range");
+      }
+      m_readySet = &readySet;
+      m_readySlot = slot;
+    }
+
     /// Allocate a write buffer for a message of numberBytes in length.
     ///
-    /// A messageSizeBytes of zero or greater or equal to BatchMessageReserve is not supported and
-    /// will cause incorrect behaviour.
+    /// A messageSizeBytes of zero is not supported and will cause incorrect behaviour. A message larger than
+    /// BatchMessageReserve is given a reservation of its own, up to MaxMessageSize. A larger message throws
+    /// std::length_error and leaves the queue unchanged.
+    ///
+    /// If the host chose flow_control::Backpressure this spins until the consumer has read enough to make space.
+    /// The consumer can only read flushed messages, so more than a queue of unflushed messages will never finish.
     ///
     /// @param messageSizeBytes Message Length
     /// @return a span<> for the caller to fill with message data
-    [[nodiscard]] auto allocate_write(MessageSize messageSizeBytes) noexcept -> std::span<std::byte>
+    [[nodiscard]] auto allocate_write(MessageSize messageSizeBytes) -> std::span<std::byte>
     {
-      // message + the next size / skip block ready for next message
-      auto const allocationSize = messageSizeBytes + sizeof(MessageSize);
+      // message + any padding + the next size / skip block ready for next message
+      auto const allocationSize = QueueLayout::frame_size(messageSizeBytes);
 
       // We have to be careful of wrapping around the data index as a std::span<>
       // can not cope with that. Therefore, we have to maintain the following:
@@ -76,30 +127,101 @@ namespace arquebus::spsc::var_msg {
 
 
       if (m_cachedWriteIndex - m_allocatedIndex < allocationSize) [[unlikely]] {
+        // a reservation is never larger than the largest frame, so only a message that needs one can be too large
+        check_message_size(messageSizeBytes);
         // allocate more storage. Skipping over index wrap if required
-        reserve(allocationSize);
+        while (not reserve(allocationSize)) {
+          // the consumer can not make space if we are holding back messages from it
+          publish_held();
+          impl::cpu_relax();
+        }
       }
 
-      // we have ensured that our allocation will not wrap so safe to index in
-      auto *pBuffer = &m_queue->data[QueueLayout::BufferSize::to_offset(m_allocatedIndex)];
+      return allocate(messageSizeBytes, allocationSize);
+    }
 
-      // write the message size into the buffer, note that this is actually already reserved
-      // and know safe place to write "before" the current allocation index
-      std::memcpy(pBuffer - sizeof(MessageSize), &messageSizeBytes, sizeof(MessageSize));
-      m_allocatedIndex += allocationSize;
-      return { pBuffer, messageSizeBytes };
+    /// Allocate a write buffer for a message of numberBytes in length, if there is space.
+    ///
+    /// The same as allocate_write(), except with flow_control::Backpressure it fails rather than waiting when the
+    /// consumer has not read enough to make space. With flow_control::Overwrite it never fails. A message larger
+    /// than MaxMessageSize throws std::length_error.
+    ///
+    /// @param messageSizeBytes Message Length
+    /// @return a span<> for the caller to fill with message data, or an empty span if the queue is full
+    [[nodiscard]] auto try_allocate_write(MessageSize messageSizeBytes) -> std::span<std::byte>
+    {
+      auto const allocationSize = QueueLayout::frame_size(messageSizeBytes);
+
+      if (m_cachedWriteIndex - m_allocatedIndex < allocationSize) [[unlikely]] {
+        check_message_size(messageSizeBytes);
+        if (not reserve(allocationSize)) {
+          publish_held();
+          return {};
+        }
+      }
+
+      return allocate(messageSizeBytes, allocationSize);
+    }
+
+    /// Allocate a message for a T and default initialise it in place, aligned for T.
+    ///
+    /// The consumer can access it in place with read_as<T>().
+    ///
+    /// @return a reference to the message in the queue
+    template<typename T>
+      requires std::is_trivially_copyable_v<T>
+    [[nodiscard]] auto allocate_write() -> T &
+    {
+      static_assert(alignof(T) <= PayloadAlignment, "PayloadAlignment is too small for T");
+      static_assert(sizeof(T) <= MaxMessageSize, "T is too large for the queue");
+
+      return *::new (allocate_write(static_cast<MessageSize>(sizeof(T))).data()) T;
     }
 
     /// Flush any allocated writes.
     ///
     /// It is the caller's responsibility to ensure that all
     /// allocated message buffer spans have been filled before calling flush().
+    ///
+    /// The flushed messages are published to the consumer when the flush_policy says so, see flush_now().
     void flush() noexcept
     {
-      // update the shared read index to release all pending messages
-      // We are pre-allocating the next size/skip indicator, so we have to release to just before that
+      // We are pre-allocating the next size/skip indicator, so we can only release to just before that
       // as it is not yet valid
-      m_queue->read_index.store(m_allocatedIndex - sizeof(MessageSize), std::memory_order_release);
+      m_flushedIndex = m_allocatedIndex - sizeof(MessageSize);
+      m_flushedMessages = m_allocatedMessages;
+
+      if (should_publish()) {
+        publish();
+      }
+    }
+
+    /// Flush any allocated writes, and publish them and any held back by the flush_policy to the consumer.
+    void flush_now() noexcept
+    {
+      m_flushedIndex = m_allocatedIndex - sizeof(MessageSize);
+      m_flushedMessages = m_allocatedMessages;
+      publish();
+    }
+
+    /// The largest message that can be written, MaxMessageSize whatever the flow control
+    [[nodiscard]] static constexpr auto max_message_size() noexcept -> std::uint64_t { return MaxMessageSize; }
+
+    /// The page size backing the shared memory segment
+    [[nodiscard]] auto page_size() const -> std::size_t { return m_queueUser.page_size(); }
+
+    /// The NUMA node the host bound the queue to, or -1 if it is not bound to a single node.
+    /// Only valid once attached.
+    [[nodiscard]] auto numa_node() const noexcept -> std::int32_t { return m_queue->header.numa_node; }
+
+    /// Identifies the message types of a typed queue, see typed_host, or zero for an untyped queue.
+    /// Only valid once attached.
+    [[nodiscard]] auto catalog_hash() const noexcept -> std::uint64_t { return m_queue->header.catalog_hash; }
+
+    /// Is the queue bound to a NUMA node other than the calling thread's, see numa_placement. Only valid once attached.
+    [[nodiscard]] auto is_remote_numa_node() const noexcept -> bool
+    {
+      return impl::is_remote_numa_node(m_queue->header.numa_node);
     }
 
   private:
@@ -107,26 +229,151 @@ namespace arquebus::spsc::var_msg {
     QueueLayout *m_queue{ nullptr };
     // a local copy of the write index, we take chunks of data at a time
     // any only update the atomic write index when we need more
-    std::uint64_t m_cachedWriteIndex{ sizeof(MessageSize) };
+    std::uint64_t m_cachedWriteIndex{ QueueLayout::FirstPayload };
 
     // a local read index of allocated, but not committed/flushed message data
     // once the caller calls flush(), we release this to the consumer
     //
     // This actually maintains a "reserved" size area so that we know that we will always have a
     // continuous sequence of bytes to write the next size or skip into.
-    std::uint64_t m_allocatedIndex{ sizeof(MessageSize) };
+    std::uint64_t m_allocatedIndex{ QueueLayout::FirstPayload };
+
+    flush_policy m_flushPolicy;
+    // only with notification::EventFd
+    impl::fd_handle m_eventFd;
+    // where to mark that there is something to read, see signal_ready()
+    ready_set<CacheLineSize> *m_readySet{ nullptr };
+    std::size_t m_readySlot{ 0 };
+    // the end of the messages flushed by the caller, and the end of those published to the consumer
+    std::uint64_t m_flushedIndex{ 0 };
+    std::uint64_t m_flushedMessages{ 0 };
+    std::uint64_t m_publishedIndex{ 0 };
+    std::uint64_t m_publishedMessages{ 0 };
+    // the cycle counter at the first flush held back by flush_policy::cycle_budget(), zero if there is none
+    std::uint64_t m_heldSince{ 0 };
+
+    // with flow_control::Backpressure, never reserve past a full queue beyond where the consumer has read to
+    bool m_backpressure{ false };
+    // the consumer index when we last looked, only used with flow_control::Backpressure
+    std::uint64_t m_cachedConsumerIndex{ 0 };
+    // the number of messages allocated, published with each sync point
+    std::uint64_t m_allocatedMessages{ 0 };
+
+    // Does the flush policy say that it is time to publish the flushed messages
+    auto should_publish() noexcept -> bool
+    {
+      switch (m_flushPolicy.type()) {
+      case flush_policy::kind::EveryFlush:
+        return true;
+      case flush_policy::kind::Messages:
+        return m_flushedMessages - m_publishedMessages >= m_flushPolicy.limit();
+      case flush_policy::kind::Bytes:
+        return m_flushedIndex - m_publishedIndex >= m_flushPolicy.limit();
+      case flush_policy::kind::Cycles: {
+        if (m_flushedIndex == m_publishedIndex) {
+          return false;
+        }
+        auto const now = impl::read_cycle_counter();
+        if (m_heldSince == 0) {
+          m_heldSince = now;
+        }
+        return now - m_heldSince >= m_flushPolicy.limit();
+      }
+      case flush_policy::kind::Adaptive:
+        // the consumer publishes where it has read to each time it asks for more, if that is everything we
+        // published it is waiting on us
+        return m_queue->consumer_index.load(std::memory_order_relaxed) >= m_publishedIndex
+               or m_flushedMessages - m_publishedMessages >= m_flushPolicy.limit();
+      }
+      return true;
+    }
+
+    // Release all flushed messages to the consumer
+    void publish() noexcept
+    {
+      m_publishedIndex = m_flushedIndex;
+      m_publishedMessages = m_flushedMessages;
+      m_heldSince = 0;
+
+      m_queue->read_index.store(m_publishedIndex, std::memory_order_release);
+      // wake the consumer if it has parked, or armed its eventfd, waiting for this
+      m_queue->wakeup.notify(m_eventFd);
+      if (m_readySet != nullptr) {
+        m_readySet->mark(m_readySlot);
+      }
+    }
+
+    static void check_message_size(MessageSize messageSizeBytes)
+    {
+      if (messageSizeBytes > MaxMessageSize) [[unlikely]] {
+        throw std::length_error("Message is larger than the queue can take");
+      }
+    }
+
+    // Release any flushed messages that the flush policy is holding back
+    void publish_held() noexcept
+    {
+      if (m_publishedIndex != m_flushedIndex) {
+        publish();
+      }
+    }
+
+    // Take the allocation, once reserve() has ensured that there is space for it
+    auto allocate(MessageSize messageSizeBytes, std::uint64_t allocationSize) noexcept -> std::span<std::byte>
+    {
+      // we have ensured that our allocation will not wrap so safe to index in
+      auto *pBuffer = &m_queue->data[QueueLayout::BufferSize::to_offset(m_allocatedIndex)];
+
+      // write the message size into the buffer, note that this is actually already reserved
+      // and know safe place to write "before" the current allocation index
+      std::memcpy(pBuffer - sizeof(MessageSize), &messageSizeBytes, sizeof(MessageSize));
+      m_allocatedIndex += allocationSize;
+      ++m_allocatedMessages;
+      return { pBuffer, messageSizeBytes };
+    }
 
-    void reserve(std::size_t minimumRequired) noexcept
+    // Reserve space for at least minimumRequired more bytes. This can only fail with flow_control::Backpressure,
+    // when the consumer has not read far enough, and then nothing is changed.
+    auto reserve(std::size_t minimumRequired) noexcept -> bool
     {
-      // increase the write index by the BatchMessageReserve and this message size to ensure enough space
-      // and then determine if we need to skip the allocation forward to the next index wrap.
-      m_cachedWriteIndex += BatchMessageReserve + sizeof(MessageSize);
+      // increase the write index by the BatchMessageReserve, or to fit this message if it is larger, to ensure
+      // enough space and then determine if we need to skip the allocation forward to the next index wrap.
+      // padding can make an allocation larger than the batch
+      auto writeIndex =
+        std::max(m_cachedWriteIndex + BatchMessageReserve + sizeof(MessageSize), m_allocatedIndex + minimumRequired);
 
       // The current allocation and minRequired already contains the size bytes
       auto const offsetOfAllocatedIndex = QueueLayout::BufferSize::to_offset(m_allocatedIndex - sizeof(MessageSize));
-			auto const offsetOfNextAllocationIndex = QueueLayout::BufferSize::to_offset(m_allocatedIndex + minimumRequired);
-      // have we wrapped?
-      if (offsetOfNextAllocationIndex< offsetOfAllocatedIndex) [[unlikely]] {
+      auto const offsetOfNextAllocationIndex = QueueLayout::BufferSize::to_offset(m_allocatedIndex + minimumRequired);
+      // have we wrapped? if so we skip the allocation along to the beginning of the queue buffer, and include the
+      // reserved "next" size. this will effectively place the next size at index 0, after any frame padding
+      std::uint64_t wrapCount = 0;
+      if (offsetOfNextAllocationIndex < offsetOfAllocatedIndex) [[unlikely]] {
+        wrapCount = QueueLayout::BufferSize::distance_to_buffer_start(m_allocatedIndex - sizeof(MessageSize))
+                    + QueueLayout::FramePadding;
+        writeIndex += wrapCount;
+      }
+
+      // Never reserve past the end of the buffer. The allocations from this reservation are only checked
+      // against the write index, so one that ran past the end would straddle the wrap.
+      auto const sizeIndex = m_allocatedIndex + wrapCount - sizeof(MessageSize);
+      writeIndex = std::min(writeIndex, sizeIndex + QueueLayout::BufferSize::distance_to_buffer_start(sizeIndex));
+      // nor more than the largest frame, so a message that fits in the reservation is never too large
+      writeIndex = std::min(writeIndex, m_allocatedIndex + wrapCount + QueueLayout::MaxFrameSize);
+
+      if (m_backpressure) {
+        // only reserve what the consumer has freed, only looking at where it is when our copy is not enough
+        auto const required = m_allocatedIndex + wrapCount + minimumRequired;
+        if (m_cachedConsumerIndex + QueueLayout::BufferSize::Bytes < required) {
+          m_cachedConsumerIndex = m_queue->consumer_index.load(std::memory_order_acquire);
+          if (m_cachedConsumerIndex + QueueLayout::BufferSize::Bytes < required) {
+            return false;
+          }
+        }
+        writeIndex = std::min(writeIndex, m_cachedConsumerIndex + QueueLayout::BufferSize::Bytes);
+      }
+
+      if (wrapCount != 0) [[unlikely]] {
         // We know we have a safe allocation to store MessageSize, so we need to indicate that the
         // remaining block is no longer valid and the consumer should skip back to the beginning of the
         // queue buffer.
@@ -135,16 +382,16 @@ namespace arquebus::spsc::var_msg {
         // write the message size into the buffer, note that this is actually already reserved
         // and know safe place to write "before" the current allocation index
         std::memcpy(pBuffer, &zero, sizeof(MessageSize));
-
-        // increment our allocation along to the beginning of the queue buffer, and include the
-        // reserved "next" size. this will effectively place the next size at index 0
-        auto wrapCount = QueueLayout::BufferSize::distance_to_buffer_start(m_allocatedIndex) + sizeof(MessageSize);
         m_allocatedIndex += wrapCount;
-        m_cachedWriteIndex += wrapCount;
       }
+      m_cachedWriteIndex = writeIndex;
+
+      // the next message starts here, somewhere an overrun consumer can safely skip ahead to
+      m_queue->publish_sync_point(m_allocatedIndex - sizeof(MessageSize), m_allocatedMessages);
 
       // inform consumer of updated allocation
       m_queue->write_index.store(m_cachedWriteIndex, std::memory_order_release);
+      return true;
     }
   };
 
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "arquebus/flow_control.hpp"
+#include "arquebus/impl/message_catalog.hpp"
+#include "arquebus/mapping_options.hpp"
+#include "arquebus/spsc/var_msg/consumer.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+namespace arquebus {
+
+  /// Combine lambdas into a single visitor for a typed_consumer, with one overload per message type
+  template<typename... Fs>
+  struct overloaded : Fs...
+  {
+    using Fs::operator()...;
+  };
+
+}  // namespace arquebus
+
+namespace arquebus::spsc::var_msg {
+
+  /// Single Producer Single Consumer Typed Queue Consumer interface
+  ///
+  /// Reads the messages written by a typed_producer with the same types, and calls a visitor with each as its
+  /// own type, in place in the queue. The queue must have been created by a typed_host with the same types.
+  ///
+  /// @tparam Size2NBits Queue Size in exponent for 2^N
+  /// @tparam Msgs The message types, each must be trivially copyable
+  template<std::uint8_t Size2NBits, typename... Msgs>
+  class typed_consumer
+  {
+    using Catalog = impl::message_catalog<Msgs...>;
+
+  public:
+    /// Create a consumer for the given queue name. The name must match that created by the host
+    /// and used by the producer.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    /// @param overrun What to do if the producer overwrites messages before they are read
+    explicit typed_consumer(
+      std::string_view name,
+      mapping_options const &options = {},
+      overrun_policy overrun = overrun_policy::Throw
+    )
+      : m_consumer(name, options, overrun)
+    {}
+
+    /// Attach the consumer to the queue that has been created by a typed_host.
+    ///
+    /// Throws std::logic_error if the queue was created for other message types.
+    void attach()
+    {
+      m_consumer.attach();
+      if (m_consumer.catalog_hash() != Catalog::Hash) {
+        throw std::logic_error("incorrect message catalog");
+      }
+    }
+
+    /// Read the next message from the queue, if there is one, and call visitor with it as a T const &.
+    ///
+    /// The visitor must accept every message type, see overloaded. The message is only valid during the call.
+    /// If the consumer is overrun by the producer, a std::runtime_error will be thrown, see consumer::read().
+    ///
+    /// @return true if a message was read
+    template<typename Visitor>
+      requires(std::invocable<Visitor &, Msgs const &> and ...)
+    auto read(Visitor &&visitor) -> bool
+    {
+      auto message = m_consumer.read();
+      if (not message.has_value()) {
+        return false;
+      }
+      Catalog::visit(*message, visitor);
+      return true;
+    }
+
+    /// Call visitor for every message that is available now, up to maxMessages, see consumer::for_each_available()
+    ///
+    /// @return The number of messages read
+    template<typename Visitor>
+      requires(std::invocable<Visitor &, Msgs const &> and ...)
+    auto for_each_available(Visitor &&visitor, std::size_t maxMessages = std::numeric_limits<std::size_t>::max())
+      -> std::size_t
+    {
+      return m_consumer.for_each_available(
+        [&visitor](std::span<std::byte const> message) { Catalog::visit(message, visitor); }, maxMessages
+      );
+    }
+
+    /// What has been skipped because the producer overran the consumer, with overrun_policy::Resync
+    [[nodiscard]] auto losses() const noexcept -> overrun_losses const & { return m_consumer.losses(); }
+
+  private:
+    consumer<Size2NBits, std::uint32_t, std::hardware_destructive_interference_size, Catalog::Alignment> m_consumer;
+  };
+
+}  // namespace arquebus::spsc::var_msg
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "arquebus/flow_control.hpp"
+#include "arquebus/impl/host_tags.hpp"
+#include "arquebus/impl/message_catalog.hpp"
+#include "arquebus/mapping_options.hpp"
+#include "arquebus/notification.hpp"
+#include "arquebus/spsc/var_msg/host.hpp"
+
+#include <cstdint>
+#include <new>
+#include <string_view>
+
+namespace arquebus::spsc::var_msg {
+
+  /// Single Producer Single Consumer Typed Queue Host interface
+  ///
+  /// Creates a queue for a typed_producer and typed_consumer with the same message types, in the same order.
+  /// The queue records a hash of the message types, a typed producer or consumer built with any other fails
+  /// to attach. The hash uses the type names as the compiler spells them and can not see field order, a message
+  /// type can declare a stable static constexpr std::string_view catalog_name to be hashed under instead.
+  ///
+  /// @tparam Size2NBits Queue Size in exponent for 2^N
+  /// @tparam Msgs The message types, each must be trivially copyable
+  template<std::uint8_t Size2NBits, typename... Msgs>
+  class typed_host
+  {
+    using Catalog = impl::message_catalog<Msgs...>;
+
+  public:
+    /// Create a host for the given queue name. The name must match that used by the producer and consumer.
+    ///
+    /// @param name The unique name of the queue to create
+    /// @param options How to map the shared memory segment
+    /// @param flowControl Whether the producer may overwrite messages the consumer has not read
+    /// @param notifyBy How the consumer can be notified of new messages, see host
+    explicit typed_host(
+      std::string_view name,
+      mapping_options const &options = {},
+      flow_control flowControl = flow_control::Overwrite,
+      notification notifyBy = notification::None
+    )
+      : m_host(name, options, flowControl, notifyBy, Catalog::Hash)
+    {}
+
+    /// Open and create the shared memory queue.
+    ///
+    /// This must occur before the producer or consumer can attempt to connect.
+    void create() { m_host.create(); }
+
+    /// If the shared memory segment already exists, delete it before creating a new one
+    ///
+    /// WARNING: existing open mapping will still see old segment, new mappings will see
+    ///          new file. Be VERY sure you want to do this!
+    void create(danger_delete_existing_shared_memory_segment_tag tag) { m_host.create(tag); }
+
+  private:
+    host<Size2NBits, std::uint32_t, std::hardware_destructive_interference_size, Catalog::Alignment> m_host;
+  };
+
+}  // namespace arquebus::spsc::var_msg
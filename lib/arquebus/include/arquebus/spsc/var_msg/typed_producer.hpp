@@ -0,0 +1,105 @@
+#pragma once
+
+#include "arquebus/flush_policy.hpp"
+#include "arquebus/impl/message_catalog.hpp"
+#include "arquebus/mapping_options.hpp"
+#include "arquebus/spsc/var_msg/producer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+
+namespace arquebus::spsc::var_msg {
+
+  /// Single Producer Single Consumer Typed Queue Producer interface
+  ///
+  /// Writes messages of the types in Msgs, each tagged with its index in Msgs, for a typed_consumer with the
+  /// same types to visit. The queue must have been created by a typed_host with the same types.
+  ///
+  /// @tparam Size2NBits Queue Size in exponent for 2^N
+  /// @tparam NBytesBatchMessageReserve Number of bytes to allocate from queue as a chunk, see producer
+  /// @tparam Msgs The message types, each must be trivially copyable
+  template<std::uint8_t Size2NBits, std::size_t NBytesBatchMessageReserve, typename... Msgs>
+  class typed_producer
+  {
+    using Catalog = impl::message_catalog<Msgs...>;
+    using Producer = producer<
+      Size2NBits,
+      NBytesBatchMessageReserve,
+      std::uint32_t,
+      std::hardware_destructive_interference_size,
+      Catalog::Alignment>;
+
+    static_assert(Catalog::MaxPayload <= Producer::MaxMessageSize, "every message type must fit in the queue");
+
+  public:
+    /// Create a producer for the given queue name. The name must match that created by the host
+    /// and used by the consumer.
+    ///
+    /// @param name The unique name of the queue to attach to
+    /// @param options How to map the shared memory segment
+    /// @param flushPolicy When flush() publishes messages to the consumer
+    explicit typed_producer(
+      std::string_view name,
+      mapping_options const &options = {},
+      flush_policy flushPolicy = flush_policy::every_flush()
+    )
+      : m_producer(name, options, flushPolicy)
+    {}
+
+    /// Attach the producer to the queue that has been created by a typed_host.
+    ///
+    /// Throws std::logic_error if the queue was created for other message types.
+    void attach()
+    {
+      m_producer.attach();
+      if (m_producer.catalog_hash() != Catalog::Hash) {
+        throw std::logic_error("incorrect message catalog");
+      }
+    }
+
+    /// Allocate a T in the queue, default initialised, for the caller to fill before calling flush().
+    ///
+    /// Every type in the catalog is checked against producer::MaxMessageSize at compile time, so this never throws
+    /// std::length_error.
+    ///
+    /// @return a reference to the message in the queue
+    template<typename T>
+      requires(Catalog::template Occurrences<T> == 1)
+    [[nodiscard]] auto allocate_write() -> T &
+    {
+      return *::new (allocate_message<T>()) T;
+    }
+
+    /// Copy message into the queue, it is published by the next flush().
+    template<typename T>
+      requires(Catalog::template Occurrences<T> == 1)
+    void write(T const &message)
+    {
+      std::memcpy(allocate_message<T>(), &message, sizeof(T));
+    }
+
+    /// Flush any allocated writes, see producer::flush()
+    void flush() noexcept { m_producer.flush(); }
+
+    /// Flush any allocated writes, and publish any held back by the flush_policy, see producer::flush_now()
+    void flush_now() noexcept { m_producer.flush_now(); }
+
+  private:
+    Producer m_producer;
+
+    // allocate a tagged message for a T, returning where the T goes
+    template<typename T>
+    auto allocate_message() -> std::byte *
+    {
+      constexpr auto Id = Catalog::template IdOf<T>;
+      auto buffer = m_producer.allocate_write(static_cast<std::uint32_t>(Catalog::MessageOffset + sizeof(T)));
+      std::memcpy(buffer.data(), &Id, sizeof(Id));
+      return buffer.data() + Catalog::MessageOffset;
+    }
+  };
+
+}  // namespace arquebus::spsc::var_msg
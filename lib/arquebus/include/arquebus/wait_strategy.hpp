@@ -0,0 +1,107 @@
+#pragma once
+
+#include "arquebus/impl/cpu_relax.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <thread>
+
+namespace arquebus::wait {
+
+  /// A wait strategy decides what a consumer does each time it finds no message to read.
+  ///
+  /// reset() is called when a wait starts. idle() is called each time the queue is found empty, it is given a
+  /// park callable that sleeps for up to the given duration, or until the producer flushes. A strategy only needs
+  /// to call park if it wants to sleep.
+  template<typename T>
+  concept strategy = requires(T strategy, void (*park)(std::chrono::nanoseconds)) {
+    { strategy.reset() } noexcept;
+    { strategy.idle(park) };
+  };
+
+  /// Re-check the queue as fast as possible. The lowest latency, but it keeps a core at 100%.
+  struct busy_spin
+  {
+    void reset() noexcept {}
+
+    template<std::invocable<std::chrono::nanoseconds> Park>
+    void idle(Park && /*park*/) noexcept
+    {}
+  };
+
+  /// Spin with a CPU pause between checks, doubling the number of pauses each time up to maxPauses. Still keeps
+  /// the core, but frees execution resources for a sibling hyper-thread and uses less power.
+  class backoff_spin
+  {
+  public:
+    explicit backoff_spin(std::uint32_t maxPauses = 64) noexcept
+      : m_maxPauses{ maxPauses }
+    {}
+
+    void reset() noexcept { m_pauses = 1; }
+
+    template<std::invocable<std::chrono::nanoseconds> Park>
+    void idle(Park && /*park*/) noexcept
+    {
+      for (std::uint32_t i = 0; i < m_pauses; ++i) {
+        impl::cpu_relax();
+      }
+      m_pauses = std::min(m_pauses * 2, m_maxPauses);
+    }
+
+  private:
+    std::uint32_t m_maxPauses;
+    std::uint32_t m_pauses{ 1 };
+  };
+
+  /// Give up the rest of the time slice between checks. Lets other threads run on the core, at the cost of
+  /// latency when the scheduler has something else to run.
+  struct yield
+  {
+    void reset() noexcept {}
+
+    template<std::invocable<std::chrono::nanoseconds> Park>
+    void idle(Park && /*park*/) noexcept
+    {
+      std::this_thread::yield();
+    }
+  };
+
+  /// Spin with a CPU pause for spinCount checks, then park on a futex in the queue until the producer flushes.
+  /// An idle consumer uses no CPU, and a busy one never parks. The first message after parking pays for a wake
+  /// up, and every flush on the producer pays for a fence once the consumer has parked.
+  ///
+  /// Each park is bounded by parkTimeout, after which the consumer checks again.
+  class spin_then_park
+  {
+  public:
+    explicit spin_then_park(
+      std::uint32_t spinCount = 10'000,
+      std::chrono::nanoseconds parkTimeout = std::chrono::milliseconds{ 10 }
+    ) noexcept
+      : m_spinCount{ spinCount }
+      , m_parkTimeout{ parkTimeout }
+    {}
+
+    void reset() noexcept { m_spins = 0; }
+
+    template<std::invocable<std::chrono::nanoseconds> Park>
+    void idle(Park &&park) noexcept
+    {
+      if (m_spins < m_spinCount) {
+        ++m_spins;
+        impl::cpu_relax();
+        return;
+      }
+      park(m_parkTimeout);
+    }
+
+  private:
+    std::uint32_t m_spinCount;
+    std::chrono::nanoseconds m_parkTimeout;
+    std::uint32_t m_spins{ 0 };
+  };
+
+}  // namespace arquebus::wait
@@ -1,11 +1,9 @@
-#include <arquebus/spsc/var_msg/consumer.hpp>
+#include <arquebus/spsc/runtime_msg/consumer.hpp>
 #include <arquebus/version.hpp>
 
 #include <exception>
 #include <fmt/core.h>
 
-static constexpr auto QueueSizeBits = 23u;
-
 auto main(int /*argc*/, char const * /*argv*/[]) -> int
 {
   try {
@@ -15,11 +13,14 @@ auto main(int /*argc*/, char const * /*argv*/[]) -> int
     fmt::println("arquebus version: {} #{}", ver.version_string, ver.commit_short_hash);
 
     fmt::println("creating queue...");
-    arquebus::spsc::var_msg::consumer<QueueSizeBits> queue{ "spsc1" };
+    arquebus::spsc::runtime_msg::consumer<> queue{ "spsc1", { .prefault = true } };
     fmt::println("attaching queue...");
     queue.attach();
+    if (queue.is_remote_numa_node()) {
+      fmt::println("warning: queue is bound to NUMA node {}, which is remote from this process", queue.numa_node());
+    }
 
-    fmt::println("..done");
+    fmt::println("..done, queue is {} bytes", queue.queue_size());
     fmt::println("Press Enter to quit");
 
     getchar();  // NOLINT
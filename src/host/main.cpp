@@ -1,32 +1,246 @@
-#include <arquebus/spsc/var_msg/host.hpp>
+#include <arquebus/mapping_options.hpp>
+#include <arquebus/spsc/runtime_msg/host.hpp>
 #include <arquebus/version.hpp>
 
+// POSIX
+#include <pthread.h>
+#include <signal.h>
+
+#include <charconv>
+#include <cstdint>
 #include <exception>
 #include <fmt/core.h>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+// Host daemon, creates every queue listed in a config file and holds them open until SIGINT or SIGTERM.
+//
+// Each non empty line of the config file describes one spsc::runtime_msg queue as space separated key=value
+// pairs, anything after a '#' is a comment:
+//
+//   name=spsc1 size=8388608 prefix=4 pages=2MiB prefault=true lock=false numa_node=0
+//
+// name and size are required. prefix is the size in bytes of the message size prefix (2, 4 or 8, default 4)
+// and must match the producer and consumer. transport is named or memfd, and must also match. pages is
+// default, 2MiB or 1GiB. numa_node binds the queue to that node.
+
+namespace {
+
+  using Host16 = arquebus::spsc::runtime_msg::host<std::uint16_t>;
+  using Host32 = arquebus::spsc::runtime_msg::host<std::uint32_t>;
+  using Host64 = arquebus::spsc::runtime_msg::host<std::uint64_t>;
+  using AnyHost = std::variant<std::unique_ptr<Host16>, std::unique_ptr<Host32>, std::unique_ptr<Host64>>;
+
+  struct queue_config
+  {
+    std::string name;
+    std::uint64_t size{ 0 };
+    unsigned prefix{ sizeof(std::uint32_t) };
+    // owned here, options.huge_page_mount is a view and the line it was parsed from does not outlive parsing
+    std::string huge_page_mount{ arquebus::mapping_options{}.huge_page_mount };
+    arquebus::mapping_options options;
+  };
+
+  auto trim(std::string_view text) -> std::string_view
+  {
+    constexpr std::string_view Whitespace = " \t\r\n";
+    auto const first = text.find_first_not_of(Whitespace);
+    if (first == std::string_view::npos) {
+      return {};
+    }
+    return text.substr(first, text.find_last_not_of(Whitespace) - first + 1);
+  }
+
+  template<typename T>
+  auto parse_number(std::string_view key, std::string_view text) -> T
+  {
+    T value{};
+    auto const [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);  // NOLINT(*-pointer-arithmetic)
+    if (ec != std::errc{} or end != text.data() + text.size()) {                          // NOLINT(*-pointer-arithmetic)
+      throw std::invalid_argument(fmt::format("invalid value for {}: {}", key, text));
+    }
+    return value;
+  }
+
+  auto parse_bool(std::string_view key, std::string_view text) -> bool
+  {
+    if (text == "true" or text == "1") {
+      return true;
+    }
+    if (text == "false" or text == "0") {
+      return false;
+    }
+    throw std::invalid_argument(fmt::format("invalid value for {}: {}", key, text));
+  }
+
+  auto parse_transport(std::string_view text) -> arquebus::segment_transport
+  {
+    if (text == "named") {
+      return arquebus::segment_transport::Named;
+    }
+    if (text == "memfd") {
+      return arquebus::segment_transport::MemFd;
+    }
+    throw std::invalid_argument(fmt::format("invalid value for transport: {}", text));
+  }
+
+  auto parse_pages(std::string_view text) -> arquebus::page_size
+  {
+    if (text == "default") {
+      return arquebus::page_size::Default;
+    }
+    if (text == "2MiB") {
+      return arquebus::page_size::Huge2MiB;
+    }
+    if (text == "1GiB") {
+      return arquebus::page_size::Huge1GiB;
+    }
+    throw std::invalid_argument(fmt::format("invalid value for pages: {}", text));
+  }
+
+  void apply(queue_config &config, std::string_view key, std::string_view value)
+  {
+    if (key == "name") {
+      config.name = value;
+    } else if (key == "size") {
+      config.size = parse_number<std::uint64_t>(key, value);
+    } else if (key == "prefix") {
+      config.prefix = parse_number<unsigned>(key, value);
+    } else if (key == "transport") {
+      config.options.transport = parse_transport(value);
+    } else if (key == "pages") {
+      config.options.pages = parse_pages(value);
+    } else if (key == "huge_page_mount") {
+      config.huge_page_mount = value;
+    } else if (key == "populate") {
+      config.options.populate = parse_bool(key, value);
+    } else if (key == "prefault") {
+      config.options.prefault = parse_bool(key, value);
+    } else if (key == "lock") {
+      config.options.lock = parse_bool(key, value);
+    } else if (key == "numa_node") {
+      config.options.numa = arquebus::numa_placement::Bind;
+      config.options.numa_node = parse_number<unsigned>(key, value);
+    } else {
+      throw std::invalid_argument(fmt::format("unknown key: {}", key));
+    }
+  }
+
+  auto parse_line(std::string_view line) -> queue_config
+  {
+    queue_config config;
+    while (not line.empty()) {
+      auto const end = line.find_first_of(" \t");
+      auto const token = line.substr(0, end);
+      line = end == std::string_view::npos ? std::string_view{} : trim(line.substr(end));
+
+      auto const equals = token.find('=');
+      if (equals == std::string_view::npos) {
+        throw std::invalid_argument(fmt::format("expected key=value: {}", token));
+      }
+      apply(config, token.substr(0, equals), token.substr(equals + 1));
+    }
+
+    if (config.name.empty() or config.size == 0) {
+      throw std::invalid_argument("name and size are required");
+    }
+    return config;
+  }
+
+  auto read_config(char const *path) -> std::vector<queue_config>
+  {
+    std::ifstream file{ path };
+    if (not file) {
+      throw std::runtime_error(fmt::format("unable to open config file {}", path));
+    }
+
+    std::vector<queue_config> configs;
+    std::string text;
+    for (unsigned lineNumber = 1; std::getline(file, text); ++lineNumber) {
+      auto line = std::string_view{ text };
+      line = trim(line.substr(0, line.find('#')));
+      if (line.empty()) {
+        continue;
+      }
+
+      try {
+        configs.push_back(parse_line(line));
+      } catch (std::invalid_argument const &e) {
+        throw std::invalid_argument(fmt::format("{}:{}: {}", path, lineNumber, e.what()));
+      }
+    }
+    return configs;
+  }
+
+  template<typename HostType>
+  auto make_host(queue_config const &config) -> AnyHost
+  {
+    auto options = config.options;
+    options.huge_page_mount = config.huge_page_mount;
+    auto host = std::make_unique<HostType>(config.name, config.size, options);
+    host->create();
+    if (not host->fallback_reason().empty()) {
+      fmt::println("warning: queue {} is not using huge pages: {}", config.name, host->fallback_reason());
+    }
+    return host;
+  }
+
+  auto create_queue(queue_config const &config) -> AnyHost
+  {
+    switch (config.prefix) {
+    case sizeof(std::uint16_t):
+      return make_host<Host16>(config);
+    case sizeof(std::uint32_t):
+      return make_host<Host32>(config);
+    case sizeof(std::uint64_t):
+      return make_host<Host64>(config);
+    default:
+      throw std::invalid_argument(fmt::format("queue {} has an unsupported prefix {}", config.name, config.prefix));
+    }
+  }
 
-static constexpr auto QueueSizeBits = 23u;
+}  // namespace
 
-auto main(int /*argc*/, char const * /*argv*/[]) -> int
+auto main(int argc, char const *argv[]) -> int
 {
   try {
-    static constexpr auto Bits = 23u;
-    static constexpr auto Size = (1u << Bits);
-
-    static_assert(Size == 0x800000u); // NOLINT
+    std::span const args{ argv, static_cast<std::size_t>(argc) };
+    if (args.size() != 2) {
+      fmt::println("usage: host <config file>");
+      return 1;
+    }
 
     fmt::println("starting host...");
     auto ver = arquebus::version();
     fmt::println("arquebus version: {} #{}", ver.version_string, ver.commit_short_hash);
 
-    fmt::println("creating queue...");
-    arquebus::spsc::var_msg::host<QueueSizeBits> queue{ "spsc1" };
-    fmt::println("initialising queue...");
-    queue.create();
+    // block the signals before we create anything, so they are only delivered to sigwait() below
+    sigset_t signals{};
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    auto const configs = read_config(args[1]);
+
+    std::vector<AnyHost> hosts;
+    hosts.reserve(configs.size());
+    for (auto const &config : configs) {
+      fmt::println("creating queue {} of {} bytes...", config.name, config.size);
+      hosts.push_back(create_queue(config));
+    }
 
-    fmt::println("..done");
-    fmt::println("Press Enter to quit");
+    fmt::println("..done, {} queues created", hosts.size());
+    fmt::println("Send SIGINT or SIGTERM to quit");
 
-    getchar();  // NOLINT
+    int signal{ 0 };
+    sigwait(&signals, &signal);
 
     fmt::println("Exiting");
 
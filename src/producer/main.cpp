@@ -1,10 +1,9 @@
-#include <arquebus/spsc/var_msg/producer.hpp>
+#include <arquebus/spsc/runtime_msg/producer.hpp>
 #include <arquebus/version.hpp>
 
 #include <exception>
 #include <fmt/core.h>
 
-static constexpr auto QueueSizeBits = 23u;
 static constexpr auto QueueMessageReservationSize = 100'000u;
 
 auto main(int /*argc*/, char const * /*argv*/[]) -> int
@@ -15,11 +14,14 @@ auto main(int /*argc*/, char const * /*argv*/[]) -> int
     fmt::println("arquebus version: {} #{}", ver.version_string, ver.commit_short_hash);
 
     fmt::println("creating queue...");
-    arquebus::spsc::var_msg::producer<QueueSizeBits, QueueMessageReservationSize> queue{ "spsc1" };
+    arquebus::spsc::runtime_msg::producer<QueueMessageReservationSize> queue{ "spsc1", { .prefault = true } };
     fmt::println("attaching queue...");
     queue.attach();
+    if (queue.is_remote_numa_node()) {
+      fmt::println("warning: queue is bound to NUMA node {}, which is remote from this process", queue.numa_node());
+    }
 
-    fmt::println("..done");
+    fmt::println("..done, queue is {} bytes", queue.queue_size());
     fmt::println("Press Enter to quit");
 
     getchar();  // NOLINT
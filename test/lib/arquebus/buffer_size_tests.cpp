@@ -2,8 +2,10 @@
 #include <catch2/generators/catch_generators.hpp>
 
 #include "arquebus/impl/buffer_size.hpp"
+#include "arquebus/impl/runtime_buffer_size.hpp"
 
 #include <cstdint>
+#include <stdexcept>
 
 
 TEST_CASE("buffer_size computes pow2 size and mask", "[arquebus]")
@@ -57,3 +59,26 @@ TEST_CASE("buffer_size distance_to_buffer_start", "[arquebus]")
 
   CHECK(B::to_offset(static_cast<std::uint64_t>(i) + B::distance_to_buffer_start(static_cast<std::uint64_t>(i))) == 0);
 }
+
+TEST_CASE("runtime_buffer_size to_offset matches modulo", "[arquebus]")
+{
+  using namespace arquebus::impl;
+
+  // NOLINTBEGIN(*-magic-numbers)
+  auto size = GENERATE(std::uint64_t{ 1 }, 3u, 64u, 100u, 4095u, 4096u, 1'000'000u, 8'388'607u, (1ul << 40u) + 3u);
+  auto index = GENERATE(std::uint64_t{ 0 }, 1u, 99u, 100u, 4095u, 4096u, 1'234'567'891u, (1ul << 62u) + 5u);
+  // NOLINTEND(*-magic-numbers)
+
+  runtime_buffer_size const bufferSize{ size };
+
+  CHECK(bufferSize.bytes() == size);
+  CHECK(bufferSize.to_offset(index) == index % size);
+  CHECK(bufferSize.to_offset(index + bufferSize.distance_to_buffer_start(index)) == 0);
+}
+
+TEST_CASE("runtime_buffer_size rejects a zero size", "[arquebus]")
+{
+  using namespace arquebus::impl;
+
+  CHECK_THROWS_AS(runtime_buffer_size{ 0 }, std::invalid_argument);
+}
@@ -0,0 +1,205 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "arquebus/mpsc/var_msg/consumer.hpp"
+#include "arquebus/mpsc/var_msg/host.hpp"
+#include "arquebus/mpsc/var_msg/producer.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// NOLINTBEGIN(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
+
+namespace {
+
+  struct tagged_message
+  {
+    std::uint32_t producer;
+    std::uint32_t sequence;
+  };
+
+  void write_tagged(std::span<std::byte> buffer, std::uint32_t producer, std::uint32_t sequence)
+  {
+    tagged_message const m{ producer, sequence };
+    std::memcpy(buffer.data(), &m, sizeof(m));
+  }
+
+  auto read_tagged(std::span<std::byte const> buffer) -> tagged_message
+  {
+    tagged_message m{};
+    std::memcpy(&m, buffer.data(), sizeof(m));
+    return m;
+  }
+
+}  // namespace
+
+
+TEST_CASE("mpsc::var_msg::consumer receives messages in claim order", "[arquebus][mpsc][consumer]")
+{
+  using namespace arquebus::mpsc::var_msg;
+
+  using HostType = host<8, 2>;
+  using ProducerType = producer<8, 2>;
+  using ConsumerType = consumer<8, 2>;
+
+  std::string_view const name{ "mpsc-var_msg-claim_order" };
+
+  HostType host{ name };
+  ProducerType p1{ name };
+  ProducerType p2{ name };
+  ConsumerType cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  p1.attach();
+  p2.attach();
+  cons.attach();
+
+  CHECK(host.attached_producers() == 2);
+
+  auto w1 = p1.allocate_write(sizeof(tagged_message));
+  auto w2 = p2.allocate_write(sizeof(tagged_message));
+  write_tagged(w1, 1, 0);
+  write_tagged(w2, 2, 0);
+
+  // second claim committed first, it must not be visible before the first claim
+  p2.commit(w2);
+  CHECK(not cons.read().has_value());
+
+  p1.commit(w1);
+  auto r1 = cons.read();
+  auto r2 = cons.read();
+  REQUIRE((r1.has_value() and r2.has_value()));
+  CHECK(read_tagged(*r1).producer == 1);
+  CHECK(read_tagged(*r2).producer == 2);
+  CHECK(not cons.read().has_value());
+}
+
+TEST_CASE("mpsc::var_msg::consumer handles wrap with padding", "[arquebus][mpsc][consumer]")
+{
+  using namespace arquebus::mpsc::var_msg;
+
+  // 2^7 = 128 bytes, so records will regularly straddle the end of the buffer
+  using HostType = host<7, 1>;
+  using ProducerType = producer<7, 1>;
+  using ConsumerType = consumer<7, 1>;
+
+  std::string_view const name{ "mpsc-var_msg-wrap" };
+
+  HostType host{ name };
+  ProducerType prod{ name };
+  ConsumerType cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  for (std::uint32_t i = 0; i < 100; i++) {
+    auto const size = static_cast<std::uint32_t>(sizeof(tagged_message) + (i % 5) * 7);
+    auto w = prod.allocate_write(size);
+    REQUIRE(w.size() == size);
+    write_tagged(w, 0, i);
+    prod.commit(w);
+
+    auto r = cons.read();
+    REQUIRE(r.has_value());
+    CHECK(r->size() == size);
+    CHECK(read_tagged(*r).sequence == i);
+    CHECK(not cons.read().has_value());
+  }
+}
+
+TEST_CASE("mpsc::var_msg::producer rejects unsupported sizes", "[arquebus][mpsc][producer]")
+{
+  using namespace arquebus::mpsc::var_msg;
+
+  using HostType = host<7, 1>;
+  using ProducerType = producer<7, 1>;
+
+  std::string_view const name{ "mpsc-var_msg-bad_size" };
+
+  HostType host{ name };
+  ProducerType prod{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+
+  CHECK(prod.allocate_write(0).empty());
+  CHECK(prod.allocate_write(ProducerType::MaxMessageSize + 1).empty());
+  CHECK(prod.allocate_write(ProducerType::MaxMessageSize).size() == ProducerType::MaxMessageSize);
+}
+
+TEST_CASE("mpsc::var_msg::producer limits attached producers", "[arquebus][mpsc][producer]")
+{
+  using namespace arquebus::mpsc::var_msg;
+
+  using HostType = host<7, 2>;
+  using ProducerType = producer<7, 2>;
+
+  std::string_view const name{ "mpsc-var_msg-max_producers" };
+
+  HostType host{ name };
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+
+  ProducerType p1{ name };
+  ProducerType p2{ name };
+  ProducerType p3{ name };
+  REQUIRE_NOTHROW(p1.attach());
+  REQUIRE_NOTHROW(p2.attach());
+  REQUIRE_THROWS(p3.attach());
+}
+
+TEST_CASE("mpsc::var_msg::consumer receives all messages from concurrent producers", "[arquebus][mpsc][consumer]")
+{
+  using namespace arquebus::mpsc::var_msg;
+
+  static constexpr std::uint32_t ProducerCount = 4;
+  static constexpr std::uint32_t MessagesPerProducer = 5000;
+
+  // deliberately small so the producers are regularly held back by the consumer
+  using HostType = host<12, ProducerCount>;
+  using ProducerType = producer<12, ProducerCount>;
+  using ConsumerType = consumer<12, ProducerCount>;
+
+  std::string_view const name{ "mpsc-var_msg-concurrent" };
+
+  HostType host{ name };
+  ConsumerType cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  cons.attach();
+
+  std::vector<std::jthread> producers;
+  for (std::uint32_t p = 0; p < ProducerCount; ++p) {
+    producers.emplace_back([name, p] {
+      ProducerType prod{ name };
+      prod.attach();
+      for (std::uint32_t i = 0; i < MessagesPerProducer; ++i) {
+        auto w = prod.allocate_write(sizeof(tagged_message) + (i % 3) * 8);
+        write_tagged(w, p, i);
+        prod.commit(w);
+      }
+    });
+  }
+
+  std::array<std::uint32_t, ProducerCount> nextSequence{};
+  std::uint32_t received = 0;
+  bool inOrder = true;
+  while (received < ProducerCount * MessagesPerProducer) {
+    if (auto r = cons.read(); r.has_value()) {
+      auto const m = read_tagged(*r);
+      inOrder = inOrder and m.producer < ProducerCount and m.sequence == nextSequence.at(m.producer);
+      nextSequence.at(m.producer) = m.sequence + 1;
+      ++received;
+    }
+  }
+
+  CHECK(inOrder);
+  CHECK(not cons.read().has_value());
+}
+
+// NOLINTEND(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
@@ -73,3 +73,124 @@ TEST_CASE("can not create shared memory if it exists", "[arquebus]")
   REQUIRE_NOTHROW(owner1.create());
   REQUIRE_THROWS(owner2.create());
 }
+
+TEST_CASE("shared_memory_owner falls back when huge pages are unavailable", "[arquebus]")
+{
+  using namespace arquebus::impl;
+
+  arquebus::mapping_options const options{ .pages = arquebus::page_size::Huge2MiB,
+                                           .huge_page_mount = "/arquebus-no-such-mount" };
+
+  shared_memory_owner<test_memory> owner{ "test5", options };
+  shared_memory_user<test_memory> user{ "test5", options };
+
+  REQUIRE_NOTHROW(owner.create());
+  CHECK(not owner.fallback_reason().empty());
+  CHECK(owner.page_size() == static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)));
+  CHECK(std::filesystem::exists("/dev/shm" + owner.name()));
+
+  REQUIRE_NOTHROW(user.attach());
+  CHECK(user.page_size() == owner.page_size());
+
+  owner.mapping()->data[0] = 1;
+  CHECK(user.mapping()->data[0] == 1);
+}
+
+TEST_CASE("shared_memory_owner reports no fallback for normal pages", "[arquebus]")
+{
+  using namespace arquebus::impl;
+
+  shared_memory_owner<test_memory> owner{ "test6" };
+
+  REQUIRE_NOTHROW(owner.create());
+  CHECK(owner.fallback_reason().empty());
+  CHECK(owner.page_size() == static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)));
+}
+
+TEST_CASE("shared_memory_user can prefault and lock without changing contents", "[arquebus]")
+{
+  using namespace arquebus::impl;
+
+  arquebus::mapping_options const options{ .populate = true, .prefault = true, .lock = true };
+
+  shared_memory_owner<test_memory> owner{ "test7", options };
+  shared_memory_user<test_memory> user{ "test7", options };
+
+  REQUIRE_NOTHROW(owner.create());
+  owner.mapping()->data[0] = 42;
+  owner.mapping()->data[99] = 7;
+
+  REQUIRE_NOTHROW(user.attach());
+  CHECK(user.mapping()->data[0] == 42);
+  CHECK(user.mapping()->data[99] == 7);
+}
+
+TEST_CASE("shared_memory_owner records the bound NUMA node", "[arquebus]")
+{
+  using namespace arquebus::impl;
+
+  // every Linux machine has node 0, even if it is not NUMA
+  arquebus::mapping_options const options{ .populate = true,
+                                           .numa = arquebus::numa_placement::Bind,
+                                           .numa_node = 0 };
+
+  shared_memory_owner<test_memory> owner{ "test8", options };
+  shared_memory_owner<test_memory> unbound{ "test9" };
+
+  REQUIRE_NOTHROW(owner.create());
+  REQUIRE_NOTHROW(unbound.create());
+  CHECK(owner.numa_node() == 0);
+  CHECK(unbound.numa_node() == NoNumaNode);
+}
+
+TEST_CASE("memfd segment is shared without a file system name", "[arquebus]")
+{
+  using namespace arquebus::impl;
+
+  arquebus::mapping_options const options{ .transport = arquebus::segment_transport::MemFd };
+
+  shared_memory_owner<test_memory> owner{ "test10", options };
+  shared_memory_owner<test_memory> duplicate{ "test10", options };
+  shared_memory_user<test_memory> user{ "test10", options };
+
+  REQUIRE_NOTHROW(owner.create());
+  CHECK(not std::filesystem::exists("/dev/shm" + owner.name()));
+  REQUIRE_THROWS(duplicate.create());
+
+  REQUIRE_NOTHROW(user.attach());
+  owner.mapping()->data[0] = 1;
+  CHECK(user.mapping()->data[0] == 1);
+  CHECK(user.page_size() == owner.page_size());
+}
+
+TEST_CASE("memfd segment is gone once the owner closes", "[arquebus]")
+{
+  using namespace arquebus::impl;
+
+  arquebus::mapping_options const options{ .transport = arquebus::segment_transport::MemFd };
+
+  shared_memory_owner<test_memory> owner{ "test11", options };
+  shared_memory_user<test_memory> user{ "test11", options };
+
+  REQUIRE_NOTHROW(owner.create());
+  owner.close();
+
+  REQUIRE_THROWS(user.attach());
+}
+
+TEST_CASE("memfd segment uses huge pages or reports why not", "[arquebus]")
+{
+  using namespace arquebus::impl;
+
+  arquebus::mapping_options const options{ .transport = arquebus::segment_transport::MemFd,
+                                           .pages = arquebus::page_size::Huge2MiB };
+
+  shared_memory_owner<test_memory> owner{ "test12", options };
+  shared_memory_user<test_memory> user{ "test12", options };
+
+  REQUIRE_NOTHROW(owner.create());
+  CHECK((owner.page_size() == (std::size_t{ 2 } << 20U) or not owner.fallback_reason().empty()));
+
+  REQUIRE_NOTHROW(user.attach());
+  CHECK(user.page_size() == owner.page_size());
+}
@@ -0,0 +1,200 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "arquebus/spmc/sequenced_msg/consumer.hpp"
+#include "arquebus/spmc/sequenced_msg/host.hpp"
+#include "arquebus/spmc/sequenced_msg/producer.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+// NOLINTBEGIN(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
+
+namespace {
+
+  struct event
+  {
+    std::uint64_t id;
+    std::uint64_t decoded;
+    std::uint64_t enriched;
+  };
+
+}  // namespace
+
+
+TEST_CASE("spmc::sequenced_msg::consumer stages see earlier changes in place", "[arquebus][spmc][sequenced_msg][consumer]")
+{
+  using namespace arquebus::spmc::sequenced_msg;
+
+  using HostType = host<event, 3, 3>;
+  using ProducerType = producer<event, 3, 3>;
+  using ConsumerType = consumer<event, 3, 3>;
+
+  std::string_view const name{ "spmc-sequenced_msg-pipeline" };
+
+  // decode -> enrich -> persist
+  HostType host{ name, { 0b000, 0b001, 0b010 } };
+  ProducerType prod{ name };
+  ConsumerType decode{ name, 0 };
+  ConsumerType enrich{ name, 1 };
+  ConsumerType persist{ name, 2 };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  decode.attach();
+  enrich.attach();
+  persist.attach();
+
+  CHECK(decode.read() == nullptr);
+
+  // more than one lap of the queue
+  for (std::uint64_t i = 0; i < 20; i++) {
+    prod.emplace(event{ .id = i, .decoded = 0, .enriched = 0 });
+    prod.flush();
+
+    // later stages can not see the message until the earlier stages are done with it
+    CHECK(enrich.read() == nullptr);
+
+    auto *d = decode.read();
+    REQUIRE(d != nullptr);
+    CHECK(d->id == i);
+    d->decoded = i * 2;
+    CHECK(decode.read() == nullptr);
+
+    CHECK(persist.read() == nullptr);
+
+    auto *e = enrich.read();
+    REQUIRE(e != nullptr);
+    CHECK(e->decoded == i * 2);
+    e->enriched = i * 3;
+    CHECK(enrich.read() == nullptr);
+
+    auto *p = persist.read();
+    REQUIRE(p != nullptr);
+    CHECK(p->id == i);
+    CHECK(p->decoded == i * 2);
+    CHECK(p->enriched == i * 3);
+    CHECK(persist.read() == nullptr);
+  }
+}
+
+TEST_CASE("spmc::sequenced_msg::producer is gated by the final stages", "[arquebus][spmc][sequenced_msg][producer]")
+{
+  using namespace arquebus::spmc::sequenced_msg;
+
+  using HostType = host<event, 2, 2>;
+  using ProducerType = producer<event, 2, 2>;
+  using ConsumerType = consumer<event, 2, 2>;
+
+  std::string_view const name{ "spmc-sequenced_msg-gating" };
+
+  HostType host{ name, { 0b00, 0b01 } };
+  ProducerType prod{ name };
+  ConsumerType first{ name, 0 };
+  ConsumerType last{ name, 1 };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  first.attach();
+  last.attach();
+
+  // fill the queue
+  for (std::uint64_t i = 0; i < 4; i++) {
+    auto *m = prod.try_allocate_write();
+    REQUIRE(m != nullptr);
+    m->id = i;
+  }
+  prod.flush();
+  CHECK(prod.try_allocate_write() == nullptr);
+
+  // the first stage finishing does not free any slots
+  for (std::uint64_t i = 0; i < 4; i++) {
+    REQUIRE(first.read() != nullptr);
+  }
+  CHECK(first.read() == nullptr);
+  CHECK(prod.try_allocate_write() == nullptr);
+
+  // the last stage only publishes once it has worked through the batch, or releases explicitly
+  auto *m = last.read();
+  REQUIRE(m != nullptr);
+  CHECK(m->id == 0);
+  CHECK(prod.try_allocate_write() == nullptr);
+  last.release();
+
+  auto *next = prod.try_allocate_write();
+  REQUIRE(next != nullptr);
+  next->id = 4;
+  prod.flush();
+  CHECK(prod.try_allocate_write() == nullptr);
+}
+
+TEST_CASE("spmc::sequenced_msg::consumer waits for all dependencies", "[arquebus][spmc][sequenced_msg][consumer]")
+{
+  using namespace arquebus::spmc::sequenced_msg;
+
+  using HostType = host<event, 3, 3>;
+  using ProducerType = producer<event, 3, 3>;
+  using ConsumerType = consumer<event, 3, 3>;
+
+  std::string_view const name{ "spmc-sequenced_msg-diamond" };
+
+  // two independent stages and a stage that joins them
+  HostType host{ name, { 0b000, 0b000, 0b011 } };
+  ProducerType prod{ name };
+  ConsumerType left{ name, 0 };
+  ConsumerType right{ name, 1 };
+  ConsumerType join{ name, 2 };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  left.attach();
+  right.attach();
+  join.attach();
+
+  prod.emplace(event{ .id = 1, .decoded = 0, .enriched = 0 });
+  prod.flush();
+
+  auto *l = left.read();
+  REQUIRE(l != nullptr);
+  l->decoded = 10;
+  left.release();
+  CHECK(join.read() == nullptr);
+
+  auto *r = right.read();
+  REQUIRE(r != nullptr);
+  r->enriched = 20;
+  right.release();
+
+  auto *j = join.read();
+  REQUIRE(j != nullptr);
+  CHECK(j->decoded == 10);
+  CHECK(j->enriched == 20);
+}
+
+TEST_CASE("spmc::sequenced_msg::host rejects invalid dependencies", "[arquebus][spmc][sequenced_msg][host]")
+{
+  using namespace arquebus::spmc::sequenced_msg;
+
+  std::string_view const name{ "spmc-sequenced_msg-invalid" };
+
+  // stage 0 can not depend on stage 1
+  host<event, 2, 2> host{ name, { 0b10, 0b00 } };
+  REQUIRE_THROWS_AS(host.create(danger_delete_existing_shared_memory_segment_tag{}), std::invalid_argument);
+}
+
+TEST_CASE("spmc::sequenced_msg::consumer only one consumer per stage", "[arquebus][spmc][sequenced_msg][consumer]")
+{
+  using namespace arquebus::spmc::sequenced_msg;
+
+  std::string_view const name{ "spmc-sequenced_msg-one_per_stage" };
+
+  host<event, 2, 1> host{ name, { 0 } };
+  consumer<event, 2, 1> c1{ name, 0 };
+  consumer<event, 2, 1> c2{ name, 0 };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  c1.attach();
+  REQUIRE_THROWS_AS(c2.attach(), std::runtime_error);
+}
+
+// NOLINTEND(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
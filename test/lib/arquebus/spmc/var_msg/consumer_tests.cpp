@@ -0,0 +1,249 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+
+#include "arquebus/spmc/var_msg/consumer.hpp"
+#include "arquebus/spmc/var_msg/host.hpp"
+#include "arquebus/spmc/var_msg/producer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+// NOLINTBEGIN(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
+
+namespace {
+
+  void fill_incrementing(std::span<std::byte> buffer, int startAt)
+  {
+    for (auto &b : buffer) {
+      b = static_cast<std::byte>(startAt++);
+    }
+  }
+
+}  // namespace
+
+
+TEST_CASE("spmc::var_msg::consumer all consumers receive every message", "[arquebus][spmc][consumer]")
+{
+  using namespace arquebus::spmc::var_msg;
+  using Catch::Matchers::RangeEquals;
+
+  // 2^6 = 64 bytes of queue
+  using HostType = host<6, 3>;
+  using ProducerType = producer<6, 3, 20>;
+  using ConsumerType = consumer<6, 3>;
+
+  std::string_view const name{ "spmc-var_msg-broadcast" };
+
+  HostType host{ name };
+  ProducerType prod{ name };
+  ConsumerType c1{ name };
+  ConsumerType c2{ name };
+  ConsumerType c3{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  c1.attach();
+  c2.attach();
+  c3.attach();
+
+  CHECK(host.attached_consumers() == 3);
+
+  // this will wrap eventually
+  for (int i = 0; i < 10; i++) {
+    auto w1 = prod.allocate_write(10);
+    fill_incrementing(w1, i);
+
+    CHECK(not c1.read().has_value());
+    prod.flush();
+
+    for (auto *cons : { &c1, &c2, &c3 }) {
+      auto r1 = cons->read();
+      REQUIRE(r1.has_value());
+      if (r1.has_value()) {  // avoid unchecked optional warning
+        CHECK(r1.value().size() == w1.size());
+        CHECK_THAT(r1.value(), RangeEquals(w1));
+      }
+      CHECK(not cons->read().has_value());
+    }
+  }
+}
+
+TEST_CASE("spmc::var_msg::consumer limits attached consumers", "[arquebus][spmc][consumer]")
+{
+  using namespace arquebus::spmc::var_msg;
+
+  using HostType = host<6, 2>;
+  using ConsumerType = consumer<6, 2>;
+
+  std::string_view const name{ "spmc-var_msg-max_consumers" };
+
+  HostType host{ name };
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+
+  ConsumerType c1{ name };
+  REQUIRE_NOTHROW(c1.attach());
+
+  {
+    ConsumerType c2{ name };
+    ConsumerType c3{ name };
+    REQUIRE_NOTHROW(c2.attach());
+    REQUIRE_THROWS(c3.attach());
+    CHECK(host.attached_consumers() == 2);
+  }
+
+  // c2 has detached, so there is space again
+  CHECK(host.attached_consumers() == 1);
+  ConsumerType c4{ name };
+  REQUIRE_NOTHROW(c4.attach());
+}
+
+TEST_CASE("spmc::var_msg::consumer late consumer starts at latest message", "[arquebus][spmc][consumer]")
+{
+  using namespace arquebus::spmc::var_msg;
+
+  using HostType = host<8, 2>;
+  using ProducerType = producer<8, 2, 40>;
+  using ConsumerType = consumer<8, 2>;
+
+  std::string_view const name{ "spmc-var_msg-late_join" };
+
+  HostType host{ name };
+  ProducerType prod{ name };
+  ConsumerType early{ name };
+  ConsumerType late{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  early.attach();
+
+  [[maybe_unused]] auto w1 = prod.allocate_write(8);
+  prod.flush();
+
+  late.attach();
+
+  auto w2 = prod.allocate_write(12);
+  fill_incrementing(w2, 5);
+  prod.flush();
+
+  auto e1 = early.read();
+  auto e2 = early.read();
+  REQUIRE((e1.has_value() and e2.has_value()));
+  CHECK(e1->size() == 8);
+  CHECK(e2->size() == 12);
+
+  auto l1 = late.read();
+  REQUIRE(l1.has_value());
+  CHECK_THAT(l1.value(), Catch::Matchers::RangeEquals(w2));
+  CHECK(not late.read().has_value());
+}
+
+TEST_CASE("spmc::var_msg::consumer slow consumer overrun independently", "[arquebus][spmc][consumer]")
+{
+  using namespace arquebus::spmc::var_msg;
+
+  using HostType = host<6, 2>;
+  using ProducerType = producer<6, 2, 20>;
+  using ConsumerType = consumer<6, 2>;
+
+  std::string_view const name{ "spmc-var_msg-overrun" };
+
+  HostType host{ name };
+  ProducerType prod{ name };
+  ConsumerType fast{ name };
+  ConsumerType slow{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  fast.attach();
+  slow.attach();
+
+  for (int i = 0; i < 30; i++) {
+    [[maybe_unused]] auto w1 = prod.allocate_write(10);
+    prod.flush();
+    REQUIRE_NOTHROW(fast.read());
+  }
+
+  REQUIRE_THROWS(slow.read());
+}
+
+TEST_CASE("spmc::var_msg::consumer receives messages that end at the end of the queue", "[arquebus][spmc][consumer]")
+{
+  using namespace arquebus::spmc::var_msg;
+  using Catch::Matchers::RangeEquals;
+
+  std::string_view const name{ "spmc-var_msg-reserve_end" };
+
+  // 2^6 = 64 bytes of queue, a reservation of 20 bytes runs past the end of it on most laps
+  host<6, 1> host{ name };
+  producer<6, 1, 20> prod{ name };
+  consumer<6, 1> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // the first message follows the first size, at the start of the queue
+  auto const first = prod.allocate_write(1);
+  prod.flush();
+  CHECK(cons.read().has_value());
+  auto const *const queueStart = first.data() - sizeof(std::uint32_t);
+  auto const *const queueEnd = queueStart + 64;
+
+  for (std::uint32_t i = 0; i < 200; ++i) {
+    auto const message = prod.allocate_write((i % 12) + 1);
+    CHECK(message.data() >= queueStart + sizeof(std::uint32_t));
+    CHECK(message.data() + message.size() <= queueEnd);
+    fill_incrementing(message, static_cast<int>(i));
+    prod.flush();
+
+    auto const received = cons.read();
+    REQUIRE(received.has_value());
+    if (received.has_value()) {  // avoid unchecked optional warning
+      CHECK_THAT(received.value(), RangeEquals(message));
+    }
+  }
+}
+
+TEST_CASE("spmc::var_msg::consumer receives messages larger than the batch reserve", "[arquebus][spmc][consumer]")
+{
+  using namespace arquebus::spmc::var_msg;
+  using Producer = producer<10, 1, 40>;
+
+  std::string_view const name{ "spmc-var_msg-large" };
+
+  host<10, 1> host{ name };
+  Producer prod{ name };
+  consumer<10, 1> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // half the 1024 byte queue after the first size, less the size before it
+  static_assert(Producer::MaxMessageSize == (1024 - 2 * sizeof(std::uint32_t)) / 2 - sizeof(std::uint32_t));
+  CHECK_THROWS_AS(prod.allocate_write(static_cast<std::uint32_t>(Producer::MaxMessageSize + 1)), std::length_error);
+
+  // a mix of small messages and large ones up to the largest, many times round the queue
+  for (std::uint32_t i = 0; i < 200; i++) {
+    auto const size = (i % 3 == 0) ? static_cast<std::uint32_t>(Producer::MaxMessageSize - (i % 50)) : 20;
+
+    auto w1 = prod.allocate_write(size);
+    fill_incrementing(w1, static_cast<int>(i));
+    prod.flush();
+
+    auto r1 = cons.read();
+    REQUIRE(r1.has_value());
+    if (r1.has_value()) {  // avoid unchecked optional warning
+      REQUIRE(r1.value().size() == size);
+      CHECK(r1.value().front() == static_cast<std::byte>(i));
+      CHECK(r1.value().back() == static_cast<std::byte>(i + size - 1));
+    }
+  }
+  CHECK(not cons.read().has_value());
+}
+
+// NOLINTEND(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
@@ -0,0 +1,166 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "arquebus/spmc/work_msg/consumer.hpp"
+#include "arquebus/spmc/work_msg/host.hpp"
+#include "arquebus/spmc/work_msg/producer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// NOLINTBEGIN(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
+
+namespace {
+
+  struct job
+  {
+    std::uint64_t id;
+    std::uint32_t payload;
+  };
+
+}  // namespace
+
+
+TEST_CASE("spmc::work_msg::consumer each message is read once", "[arquebus][spmc][work_msg][consumer]")
+{
+  using namespace arquebus::spmc::work_msg;
+
+  using HostType = host<job, 3, 2>;
+  using ProducerType = producer<job, 3, 2>;
+  using ConsumerType = consumer<job, 3, 2>;
+
+  std::string_view const name{ "spmc-work_msg-read_once" };
+
+  HostType host{ name };
+  ProducerType prod{ name };
+  ConsumerType c1{ name };
+  ConsumerType c2{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  c1.attach();
+  c2.attach();
+
+  CHECK(not c1.read().has_value());
+
+  // more than one lap of the queue
+  for (std::uint64_t i = 0; i < 20; i++) {
+    REQUIRE(prod.try_emplace(i, 7u));
+    REQUIRE(prod.try_write({ .id = i + 100, .payload = 8u }));
+
+    auto r1 = c1.read();
+    auto r2 = c2.read();
+    REQUIRE((r1.has_value() and r2.has_value()));
+    CHECK(r1->id == i);
+    CHECK(r2->id == i + 100);
+    CHECK(not c1.read().has_value());
+    CHECK(not c2.read().has_value());
+  }
+}
+
+TEST_CASE("spmc::work_msg::producer fails when queue is full", "[arquebus][spmc][work_msg][producer]")
+{
+  using namespace arquebus::spmc::work_msg;
+
+  using HostType = host<job, 2, 1>;
+  using ProducerType = producer<job, 2, 1>;
+  using ConsumerType = consumer<job, 2, 1>;
+
+  std::string_view const name{ "spmc-work_msg-full" };
+
+  HostType host{ name };
+  ProducerType prod{ name };
+  ConsumerType cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  for (std::uint64_t i = 0; i < 4; i++) {
+    REQUIRE(prod.try_emplace(i, 0u));
+  }
+  CHECK(not prod.try_emplace(4u, 0u));
+
+  // freeing one slot lets exactly one more message in, nothing was overwritten
+  auto r = cons.read();
+  REQUIRE(r.has_value());
+  CHECK(r->id == 0);
+  CHECK(prod.try_emplace(4u, 0u));
+  CHECK(not prod.try_emplace(5u, 0u));
+
+  for (std::uint64_t i = 1; i < 5; i++) {
+    auto next = cons.read();
+    REQUIRE(next.has_value());
+    CHECK(next->id == i);
+  }
+}
+
+TEST_CASE("spmc::work_msg::consumer limits attached consumers", "[arquebus][spmc][work_msg][consumer]")
+{
+  using namespace arquebus::spmc::work_msg;
+
+  std::string_view const name{ "spmc-work_msg-max_consumers" };
+
+  host<job, 2, 1> host{ name };
+  consumer<job, 2, 1> c1{ name };
+  consumer<job, 2, 1> c2{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  REQUIRE_NOTHROW(c1.attach());
+  REQUIRE_THROWS(c2.attach());
+}
+
+TEST_CASE("spmc::work_msg::consumer concurrent consumers share the work", "[arquebus][spmc][work_msg][consumer]")
+{
+  using namespace arquebus::spmc::work_msg;
+
+  static constexpr std::size_t ConsumerCount = 6;
+  static constexpr std::uint64_t MessageCount = 50'000;
+
+  using HostType = host<job, 8, ConsumerCount>;
+  using ProducerType = producer<job, 8, ConsumerCount>;
+  using ConsumerType = consumer<job, 8, ConsumerCount>;
+
+  std::string_view const name{ "spmc-work_msg-concurrent" };
+
+  HostType host{ name };
+  ProducerType prod{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+
+  std::vector<std::atomic_uint8_t> seen(MessageCount);
+  std::atomic_uint64_t received{ 0 };
+
+  {
+    std::vector<std::jthread> consumers;
+    for (std::size_t c = 0; c < ConsumerCount; ++c) {
+      consumers.emplace_back([&] {
+        ConsumerType cons{ name };
+        cons.attach();
+        while (received.load(std::memory_order_relaxed) < MessageCount) {
+          if (auto r = cons.read(); r.has_value()) {
+            seen.at(r->id).fetch_add(1, std::memory_order_relaxed);
+            received.fetch_add(1, std::memory_order_relaxed);
+          } else {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+
+    for (std::uint64_t i = 0; i < MessageCount; ++i) {
+      while (not prod.try_emplace(i, 0u)) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  CHECK(received.load() == MessageCount);
+  CHECK(std::ranges::all_of(seen, [](auto const &count) { return count.load() == 1; }));
+}
+
+// NOLINTEND(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
@@ -0,0 +1,183 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/spsc/fixed_msg/consumer.hpp"
+#include "arquebus/spsc/fixed_msg/host.hpp"
+#include "arquebus/spsc/fixed_msg/producer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// NOLINTBEGIN(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
+
+namespace {
+
+  struct quote
+  {
+    std::uint64_t instrument;
+    double price;
+    std::uint32_t quantity;
+    std::uint8_t side;
+  };
+
+  struct alignas(32) wide_message
+  {
+    std::uint8_t tag;
+  };
+
+}  // namespace
+
+
+TEST_CASE("spsc::fixed_msg::consumer can receive messages", "[arquebus][spsc][fixed_msg][consumer]")
+{
+  using namespace arquebus::spsc::fixed_msg;
+
+  // 2^3 = 8 messages of queue
+  using HostType = host<quote, 3>;
+  using ProducerType = producer<quote, 3, 2>;
+  using ConsumerType = consumer<quote, 3>;
+
+  std::string_view const name{ "spsc-fixed_msg-can_receive" };
+
+  HostType host{ name };
+  ProducerType prod{ name };
+  ConsumerType cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // this will wrap several times
+  for (std::uint64_t i = 0; i < 30; i++) {
+    auto &w = prod.emplace(i, 1.5 * static_cast<double>(i), static_cast<std::uint32_t>(i * 10), std::uint8_t{ 1 });
+    CHECK(w.instrument == i);
+
+    // should not yet be visible
+    CHECK(cons.read() == nullptr);
+    prod.flush();
+
+    auto const *r = cons.read();
+    REQUIRE(r != nullptr);
+    CHECK(reinterpret_cast<std::uintptr_t>(r) % alignof(quote) == 0);
+    CHECK(r->instrument == i);
+    CHECK(r->quantity == i * 10);
+    CHECK(cons.read() == nullptr);
+  }
+}
+
+TEST_CASE("spsc::fixed_msg::producer stores messages in aligned slots", "[arquebus][spsc][fixed_msg][producer]")
+{
+  using namespace arquebus::spsc::fixed_msg;
+  using namespace arquebus::impl;
+
+  using HostType = host<wide_message, 4>;
+  using ProducerType = producer<wide_message, 4, 4>;
+  using ObserverType = shared_memory_user<typename ProducerType::QueueLayout>;
+
+  static_assert(sizeof(wide_message) == 32);
+
+  std::string_view const name{ "spsc-fixed_msg-aligned_slots" };
+
+  HostType host{ name };
+  ProducerType prod{ name };
+  ObserverType obs{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  obs.attach();
+
+  auto *pQueue = obs.mapping();
+
+  for (std::uint8_t i = 0; i < 5; i++) {
+    auto &w = prod.allocate_write();
+    w.tag = i;
+  }
+  prod.flush();
+
+  CHECK(pQueue->read_index.load() == 5);
+  CHECK(pQueue->write_index.load() == 8);
+
+  // no framing, message i is at exactly i * sizeof(T)
+  for (std::uint8_t i = 0; i < 5; i++) {
+    auto const *slot = &pQueue->data[i * sizeof(wide_message)];
+    CHECK(reinterpret_cast<std::uintptr_t>(slot) % alignof(wide_message) == 0);
+    CHECK(static_cast<std::uint8_t>(slot[0]) == i);
+  }
+}
+
+TEST_CASE("spsc::fixed_msg::consumer can read all available messages in a batch", "[arquebus][spsc][fixed_msg][consumer]")
+{
+  using namespace arquebus::spsc::fixed_msg;
+
+  std::string_view const name{ "spsc-fixed_msg-for_each_available" };
+
+  host<quote, 3> host{ name };
+  producer<quote, 3, 2> prod{ name };
+  consumer<quote, 3> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  std::uint64_t expected = 0;
+  auto const check_next = [&](quote const &q) { CHECK(q.instrument == expected++); };
+
+  // this will wrap several times
+  for (std::uint64_t lap = 0; lap < 5; ++lap) {
+    for (std::uint64_t i = 0; i < 5; ++i) {
+      prod.emplace(lap * 5 + i, 1.0, 1u, std::uint8_t{ 0 });
+    }
+    CHECK(cons.for_each_available(check_next) == 0);
+    prod.flush();
+
+    CHECK(cons.for_each_available(check_next, 3) == 3);
+    CHECK(cons.for_each_available(check_next) == 2);
+    CHECK(cons.for_each_available(check_next) == 0);
+  }
+  CHECK(expected == 25);
+}
+
+TEST_CASE("spsc::fixed_msg::consumer throws on overrun", "[arquebus][spsc][fixed_msg][consumer]")
+{
+  using namespace arquebus::spsc::fixed_msg;
+
+  using HostType = host<quote, 3>;
+  using ProducerType = producer<quote, 3, 2>;
+  using ConsumerType = consumer<quote, 3>;
+
+  std::string_view const name{ "spsc-fixed_msg-throw_on_overrun" };
+
+  HostType host{ name };
+  ProducerType prod{ name };
+  ConsumerType cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  REQUIRE_THROWS([&] {
+    for (std::uint64_t i = 0; i < 30; i++) {
+      prod.emplace(i, 0.0, 1u, std::uint8_t{ 0 });
+      prod.emplace(i, 0.0, 1u, std::uint8_t{ 0 });
+      prod.flush();
+      auto const *r = cons.read();
+      CHECK(r != nullptr);
+    }
+  }());
+}
+
+TEST_CASE("spsc::fixed_msg::consumer rejects mismatched message type", "[arquebus][spsc][fixed_msg][consumer]")
+{
+  using namespace arquebus::spsc::fixed_msg;
+
+  std::string_view const name{ "spsc-fixed_msg-mismatched_type" };
+
+  host<quote, 3> host{ name };
+  consumer<wide_message, 3> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  REQUIRE_THROWS(cons.attach());
+}
+
+// NOLINTEND(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
@@ -0,0 +1,160 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "arquebus/spsc/mirrored_msg/consumer.hpp"
+#include "arquebus/spsc/mirrored_msg/host.hpp"
+#include "arquebus/spsc/mirrored_msg/producer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+
+// NOLINTBEGIN(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
+
+namespace {
+
+  void fill_incrementing(std::span<std::byte> buffer, int startAt)
+  {
+    for (auto &b : buffer) {
+      b = static_cast<std::byte>(startAt++);
+    }
+  }
+
+  auto is_incrementing(std::span<std::byte const> buffer, int startAt) -> bool
+  {
+    for (auto b : buffer) {
+      if (b != static_cast<std::byte>(startAt++)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+}  // namespace
+
+
+TEST_CASE("spsc::mirrored_msg::consumer reads messages across the end of the queue", "[arquebus][spsc][mirrored_msg][consumer]")
+{
+  using namespace arquebus::spsc::mirrored_msg;
+
+  // 2^12 = 4096 bytes of queue, one page
+  using HostType = host<12>;
+  using ProducerType = producer<12, 512>;
+  using ConsumerType = consumer<12>;
+
+  std::string_view const name{ "spsc-mirrored_msg-across_end" };
+
+  HostType host{ name };
+  ProducerType prod{ name };
+  ConsumerType cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  CHECK(not cons.read().has_value());
+
+  // 300 bytes per message does not divide the queue, so messages straddle the end on most laps
+  for (int i = 0; i < 100; i++) {
+    auto w = prod.allocate_write(296);
+    REQUIRE(w.size() == 296);
+    fill_incrementing(w, i);
+    prod.flush();
+
+    auto r = cons.read();
+    REQUIRE(r.has_value());
+    REQUIRE(r->size() == 296);
+    CHECK(is_incrementing(*r, i));
+    CHECK(not cons.read().has_value());
+  }
+}
+
+TEST_CASE("spsc::mirrored_msg::producer supports messages close to the queue size", "[arquebus][spsc][mirrored_msg][producer]")
+{
+  using namespace arquebus::spsc::mirrored_msg;
+
+  using HostType = host<12>;
+  using ProducerType = producer<12, 64>;
+  using ConsumerType = consumer<12>;
+
+  std::string_view const name{ "spsc-mirrored_msg-large" };
+
+  HostType host{ name };
+  ProducerType prod{ name };
+  ConsumerType cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // a small message first so the large ones start part way through the queue
+  auto small = prod.allocate_write(10);
+  fill_incrementing(small, 0);
+  prod.flush();
+  REQUIRE(cons.read().has_value());
+
+  for (int i = 0; i < 5; i++) {
+    auto w = prod.allocate_write(static_cast<std::uint32_t>(ProducerType::MaxMessageSize));
+    REQUIRE(w.size() == ProducerType::MaxMessageSize);
+    fill_incrementing(w, i);
+    prod.flush();
+
+    auto r = cons.read();
+    REQUIRE(r.has_value());
+    REQUIRE(r->size() == ProducerType::MaxMessageSize);
+    CHECK(is_incrementing(*r, i));
+  }
+
+  // zero length messages are valid, there is no skip marker to confuse them with
+  std::ignore = prod.allocate_write(0);
+  prod.flush();
+  auto r = cons.read();
+  REQUIRE(r.has_value());
+  CHECK(r->empty());
+}
+
+TEST_CASE("spsc::mirrored_msg::consumer throws on overrun", "[arquebus][spsc][mirrored_msg][consumer]")
+{
+  using namespace arquebus::spsc::mirrored_msg;
+
+  using HostType = host<12>;
+  using ProducerType = producer<12, 64>;
+  using ConsumerType = consumer<12>;
+
+  std::string_view const name{ "spsc-mirrored_msg-overrun" };
+
+  HostType host{ name };
+  ProducerType prod{ name };
+  ConsumerType cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // more than a full queue of messages before the consumer looks
+  for (int i = 0; i < 20; i++) {
+    std::ignore = prod.allocate_write(252);
+  }
+  prod.flush();
+
+  REQUIRE_THROWS_AS(cons.read(), std::runtime_error);
+}
+
+TEST_CASE("spsc::mirrored_msg::host does not use huge pages", "[arquebus][spsc][mirrored_msg][host]")
+{
+  using namespace arquebus::spsc::mirrored_msg;
+
+  std::string_view const name{ "spsc-mirrored_msg-huge_pages" };
+
+  host<12> host{ name, { .pages = arquebus::page_size::Huge2MiB } };
+  consumer<12> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  CHECK(not host.fallback_reason().empty());
+
+  REQUIRE_NOTHROW(cons.attach());
+}
+
+// NOLINTEND(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
@@ -0,0 +1,161 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+
+#include "arquebus/spsc/runtime_msg/consumer.hpp"
+#include "arquebus/spsc/runtime_msg/host.hpp"
+#include "arquebus/spsc/runtime_msg/producer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+// NOLINTBEGIN(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
+
+namespace {
+
+  void fill_incrementing(std::span<std::byte> buffer, int startAt)
+  {
+    for (auto &b : buffer) {
+      b = static_cast<std::byte>(startAt++);
+    }
+  }
+
+  void test_can_receive_messages(std::string_view name, std::uint64_t queueSize)
+  {
+    using namespace arquebus::spsc::runtime_msg;
+    using Catch::Matchers::RangeEquals;
+
+    host<> host{ name, queueSize };
+    producer<20> prod{ name };
+    consumer<> cons{ name };
+
+    host.create(danger_delete_existing_shared_memory_segment_tag{});
+    prod.attach();
+    cons.attach();
+
+    CHECK(prod.queue_size() == queueSize);
+    CHECK(cons.queue_size() == queueSize);
+
+    // this will wrap many times
+    for (int i = 0; i < 50; i++) {
+      auto w1 = prod.allocate_write(10);
+      fill_incrementing(w1, i);
+
+      // should not yet be visible
+      auto r1 = cons.read();
+      CHECK(not r1.has_value());
+      prod.flush();
+
+      // now the message should exist
+      r1 = cons.read();
+      REQUIRE(r1.has_value());
+      if (r1.has_value()) {  // avoid unchecked optional warning
+        CHECK(r1.value().size() == w1.size());
+        CHECK_THAT(r1.value(), RangeEquals(w1));
+      }
+    }
+  }
+
+}  // namespace
+
+
+TEST_CASE("spsc::runtime_msg::consumer can receive messages power of two size", "[arquebus][spsc][consumer]")
+{
+  test_can_receive_messages("spsc-runtime_msg-can_receive_test-64", 64);
+}
+
+TEST_CASE("spsc::runtime_msg::consumer can receive messages non power of two size", "[arquebus][spsc][consumer]")
+{
+  test_can_receive_messages("spsc-runtime_msg-can_receive_test-100", 100);
+}
+
+TEST_CASE("spsc::runtime_msg::consumer throws on overrun", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::runtime_msg;
+
+  std::string_view const name{ "spsc-runtime_msg-throw_on_overrun" };
+
+  host<> host{ name, 100 };
+  producer<20> prod{ name };
+  consumer<> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // this will eventually overrun as we are writing much more messages as we are reading
+  REQUIRE_THROWS([&] {
+    for (int i = 0; i < 30; i++) {
+      auto w1 = prod.allocate_write(10);
+      auto w2 = prod.allocate_write(10);
+      CHECK(w1.size() == 10);
+      CHECK(w2.size() == 10);
+      prod.flush();
+      auto r1 = cons.read();
+      CHECK((r1.has_value() and r1.value().size() == 10));
+    }
+  }());
+}
+
+TEST_CASE("spsc::runtime_msg::consumer receives messages larger than the batch reserve", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::runtime_msg;
+
+  std::string_view const name{ "spsc-runtime_msg-large" };
+
+  host<> host{ name, 1000 };
+  producer<40> prod{ name };
+  consumer<> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // half the 1000 byte queue after the first size, less the size before it
+  auto const largest = static_cast<std::uint32_t>(prod.max_message_size());
+  CHECK(largest == (1000 - 2 * sizeof(std::uint32_t)) / 2 - sizeof(std::uint32_t));
+  CHECK_THROWS_AS(prod.allocate_write(largest + 1), std::length_error);
+
+  // a mix of small messages and large ones up to the largest, many times round the queue
+  for (std::uint32_t i = 0; i < 200; i++) {
+    auto const size = (i % 3 == 0) ? largest - (i % 50) : 20;
+
+    auto w1 = prod.allocate_write(size);
+    fill_incrementing(w1, static_cast<int>(i));
+    prod.flush();
+
+    auto r1 = cons.read();
+    REQUIRE(r1.has_value());
+    if (r1.has_value()) {  // avoid unchecked optional warning
+      REQUIRE(r1.value().size() == size);
+      CHECK(r1.value().front() == static_cast<std::byte>(i));
+      CHECK(r1.value().back() == static_cast<std::byte>(i + size - 1));
+    }
+  }
+  CHECK(not cons.read().has_value());
+}
+
+TEST_CASE("spsc::runtime_msg::producer rejects a batch larger than the queue", "[arquebus][spsc][producer]")
+{
+  using namespace arquebus::spsc::runtime_msg;
+
+  std::string_view const name{ "spsc-runtime_msg-batch_too_large" };
+
+  host<> host{ name, 100 };
+  producer<200> prod{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  CHECK_THROWS_AS(prod.attach(), std::logic_error);
+}
+
+TEST_CASE("spsc::runtime_msg::host rejects a queue too small for a message", "[arquebus][spsc][host]")
+{
+  using namespace arquebus::spsc::runtime_msg;
+
+  CHECK_THROWS_AS((host<>{ "spsc-runtime_msg-too_small", 4 }), std::invalid_argument);
+}
+
+// NOLINTEND(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
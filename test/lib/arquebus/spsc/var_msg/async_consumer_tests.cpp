@@ -0,0 +1,148 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "arquebus/spsc/var_msg/async_consumer.hpp"
+#include "arquebus/spsc/var_msg/host.hpp"
+#include "arquebus/spsc/var_msg/producer.hpp"
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// NOLINTBEGIN(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
+
+namespace {
+
+  // a single threaded executor, coroutines are resumed by whichever thread calls run_until()
+  class test_executor
+  {
+  public:
+    void post(std::coroutine_handle<> handle)
+    {
+      std::scoped_lock const lock{ m_mutex };
+      m_ready.push_back(handle);
+    }
+
+    template<typename Done>
+    void run_until(Done &&done)
+    {
+      while (not done()) {
+        std::coroutine_handle<> handle{};
+        {
+          std::scoped_lock const lock{ m_mutex };
+          if (not m_ready.empty()) {
+            handle = m_ready.front();
+            m_ready.pop_front();
+          }
+        }
+        if (handle) {
+          handle.resume();
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::deque<std::coroutine_handle<>> m_ready;
+  };
+
+  // a coroutine that starts straight away and cleans up after itself
+  struct detached_task
+  {
+    struct promise_type
+    {
+      auto get_return_object() noexcept -> detached_task { return {}; }
+      auto initial_suspend() noexcept -> std::suspend_never { return {}; }
+      auto final_suspend() noexcept -> std::suspend_never { return {}; }
+      void return_void() noexcept {}
+      void unhandled_exception() noexcept { std::terminate(); }
+    };
+  };
+
+  template<typename AsyncConsumer>
+  auto read_messages(AsyncConsumer &cons, int count, std::vector<int> &received, bool &done) -> detached_task
+  {
+    for (int i = 0; i < count; i++) {
+      auto message = co_await cons.next();
+      if (not message.has_value()) {
+        break;
+      }
+      received.push_back(static_cast<int>(message.value()[0]));
+    }
+    done = true;
+  }
+
+}  // namespace
+
+
+TEST_CASE("spsc::var_msg::async_consumer resumes a coroutine on the executor", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  std::string_view const name{ "spsc-var_msg-async" };
+
+  test_executor executor;
+  host<10> host{ name };
+  producer<10, 100> prod{ name };
+  async_consumer<test_executor, 10> cons{ name, executor };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  std::vector<int> received;
+  bool done = false;
+  read_messages(cons, 20, received, done);
+
+  // pause before some messages, so the coroutine has to suspend for them
+  std::jthread writer{ [&prod] {
+    for (int i = 0; i < 20; i++) {
+      if (i % 5 == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 5 });
+      }
+      auto w1 = prod.allocate_write(4);
+      w1[0] = static_cast<std::byte>(i);
+      prod.flush();
+    }
+  } };
+
+  executor.run_until([&done] { return done; });
+
+  REQUIRE(received.size() == 20);
+  for (int i = 0; i < 20; i++) {
+    CHECK(received[static_cast<std::size_t>(i)] == i);
+  }
+}
+
+TEST_CASE("spsc::var_msg::async_consumer resumes a waiting coroutine when stopped", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  std::string_view const name{ "spsc-var_msg-async-stop" };
+
+  test_executor executor;
+  host<10> host{ name };
+  async_consumer<test_executor, 10> cons{ name, executor };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  cons.attach();
+
+  std::vector<int> received;
+  bool done = false;
+  read_messages(cons, 1, received, done);
+  CHECK(not done);
+
+  cons.stop();
+  executor.run_until([&done] { return done; });
+  CHECK(received.empty());
+}
+
+// NOLINTEND(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
@@ -2,15 +2,26 @@
 #include <catch2/matchers/catch_matchers.hpp>
 #include <catch2/matchers/catch_matchers_range_equals.hpp>
 
+#include "arquebus/impl/shared_memory_helper.hpp"
 #include "arquebus/spsc/var_msg/consumer.hpp"
 #include "arquebus/spsc/var_msg/host.hpp"
 #include "arquebus/spsc/var_msg/producer.hpp"
+#include "arquebus/wait_strategy.hpp"
 
+// POSIX
+#include <poll.h>
+
+#include <chrono>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
+#include <new>
+#include <optional>
 #include <span>
+#include <stdexcept>
+#include <stop_token>
 #include <string_view>
+#include <thread>
 
 // NOLINTBEGIN(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
 
@@ -23,6 +34,45 @@ namespace {
     }
   }
 
+  // is fd readable, without waiting
+  auto is_readable(int fd) -> bool
+  {
+    pollfd poll{ .fd = fd, .events = POLLIN, .revents = 0 };
+    return ::poll(&poll, 1, 0) == 1 and (poll.revents & POLLIN) != 0;
+  }
+
+  template<std::unsigned_integral TMessageSize, std::size_t PayloadAlignment>
+  void test_aligned_framing(std::string_view name)
+  {
+    using namespace arquebus::spsc::var_msg;
+    using Catch::Matchers::RangeEquals;
+
+    // 2^9 = 512 bytes of queue
+    host<9, TMessageSize, std::hardware_destructive_interference_size, PayloadAlignment> host{ name };
+    producer<9, 100, TMessageSize, std::hardware_destructive_interference_size, PayloadAlignment> prod{ name };
+    consumer<9, TMessageSize, std::hardware_destructive_interference_size, PayloadAlignment> cons{ name };
+
+    host.create(danger_delete_existing_shared_memory_segment_tag{});
+    prod.attach();
+    cons.attach();
+
+    // odd sizes so every message needs padding, and this will wrap many times
+    for (int i = 0; i < 100; i++) {
+      auto const size = static_cast<TMessageSize>(1 + (i * 7) % 60);
+      auto w1 = prod.allocate_write(size);
+      fill_incrementing(w1, i);
+      CHECK(reinterpret_cast<std::uintptr_t>(w1.data()) % PayloadAlignment == 0);  // NOLINT(*-reinterpret-cast)
+      prod.flush();
+
+      auto r1 = cons.read();
+      REQUIRE(r1.has_value());
+      if (r1.has_value()) {  // avoid unchecked optional warning
+        CHECK(reinterpret_cast<std::uintptr_t>(r1.value().data()) % PayloadAlignment == 0);  // NOLINT(*-reinterpret-cast)
+        CHECK_THAT(r1.value(), RangeEquals(w1));
+      }
+    }
+  }
+
   template<std::unsigned_integral TMessageSize>
   void test_can_receive_messages(std::string_view name)
   {
@@ -66,6 +116,41 @@ namespace {
     }
   }
 
+  template<arquebus::wait::strategy Strategy>
+  void test_read_wait(std::string_view name, Strategy strategy)
+  {
+    using namespace arquebus::spsc::var_msg;
+
+    host<10> host{ name };
+    producer<10, 100> prod{ name };
+    consumer<10> cons{ name };
+
+    host.create(danger_delete_existing_shared_memory_segment_tag{});
+    prod.attach();
+    cons.attach();
+
+    // pause before some messages, so the consumer has to wait (and park) for them
+    std::jthread writer{ [&prod] {
+      for (int i = 0; i < 50; i++) {
+        if (i % 10 == 0) {
+          std::this_thread::sleep_for(std::chrono::milliseconds{ 5 });
+        }
+        auto w1 = prod.allocate_write(10);
+        fill_incrementing(w1, i);
+        prod.flush();
+      }
+    } };
+
+    for (int i = 0; i < 50; i++) {
+      auto r1 = cons.read_wait(strategy);
+      REQUIRE(r1.has_value());
+      if (r1.has_value()) {  // avoid unchecked optional warning
+        CHECK(r1.value().size() == 10);
+        CHECK(r1.value()[0] == static_cast<std::byte>(i));
+      }
+    }
+  }
+
 }  // namespace
 
 
@@ -90,6 +175,71 @@ TEST_CASE("spsc::var_msg::consumer can receive messages uint64_t size", "[arqueb
 }
 
 
+TEST_CASE("spsc::var_msg::consumer receives aligned payloads", "[arquebus][spsc][consumer]")
+{
+  test_aligned_framing<std::uint8_t, 8>("spsc-var_msg-aligned-8-8");
+  test_aligned_framing<std::uint16_t, 16>("spsc-var_msg-aligned-16-16");
+  test_aligned_framing<std::uint32_t, 64>("spsc-var_msg-aligned-32-64");
+  test_aligned_framing<std::uint64_t, 8>("spsc-var_msg-aligned-64-8");
+  test_aligned_framing<std::uint64_t, 2>("spsc-var_msg-aligned-64-2");
+}
+
+TEST_CASE("spsc::var_msg::consumer can read typed messages in place", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  struct alignas(16) quote
+  {
+    std::uint64_t instrument;
+    double price;
+    std::uint16_t quantity;
+  };
+
+  std::string_view const name{ "spsc-var_msg-typed" };
+
+  host<10, std::uint16_t, std::hardware_destructive_interference_size, 16> host{ name };
+  producer<10, 200, std::uint16_t, std::hardware_destructive_interference_size, 16> prod{ name };
+  consumer<10, std::uint16_t, std::hardware_destructive_interference_size, 16> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  CHECK(cons.read_as<quote>() == nullptr);
+
+  // this will wrap
+  for (std::uint64_t i = 0; i < 100; i++) {
+    auto &q = prod.allocate_write<quote>();
+    q.instrument = i;
+    q.price = 1.5;
+    q.quantity = 3;
+    prod.flush();
+
+    auto const *r = cons.read_as<quote>();
+    REQUIRE(r != nullptr);
+    CHECK(r->instrument == i);
+    CHECK(r->quantity == 3);
+  }
+
+  // a message of a different size is rejected
+  static_cast<void>(prod.allocate_write(3));
+  prod.flush();
+  CHECK_THROWS_AS(cons.read_as<quote>(), std::runtime_error);
+}
+
+TEST_CASE("spsc::var_msg::consumer rejects mismatched payload alignment", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  std::string_view const name{ "spsc-var_msg-alignment_mismatch" };
+
+  host<10, std::uint32_t, std::hardware_destructive_interference_size, 8> host{ name };
+  consumer<10, std::uint32_t, std::hardware_destructive_interference_size, 16> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  CHECK_THROWS_AS(cons.attach(), std::logic_error);
+}
+
 TEST_CASE("spsc::var_msg::consumer throws on overrun", "[arquebus][spsc][consumer]")
 {
   using namespace arquebus::spsc::var_msg;
@@ -126,4 +276,412 @@ TEST_CASE("spsc::var_msg::consumer throws on overrun", "[arquebus][spsc][consume
   }());
 }
 
+TEST_CASE("spsc::var_msg::consumer can resync after an overrun", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+  using arquebus::overrun_policy;
+
+  std::string_view const name{ "spsc-var_msg-resync_on_overrun" };
+
+  // 2^7 = 128 bytes of queue
+  host<7> host{ name };
+  producer<7, 40> prod{ name };
+  consumer<7> cons{ name, {}, overrun_policy::Resync };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // every message starts with its number, so we can tell what was skipped
+  int written = 0;
+  auto write = [&](int count) {
+    for (int i = 0; i < count; i++) {
+      auto w1 = prod.allocate_write(10);
+      fill_incrementing(w1, written++);
+      prod.flush();
+    }
+  };
+
+  write(2);
+  for (int i = 0; i < 2; i++) {
+    auto const r0 = cons.read();
+    REQUIRE(r0.has_value());
+    if (r0.has_value()) {  // avoid unchecked optional warning
+      CHECK(r0.value()[0] == static_cast<std::byte>(i));
+    }
+  }
+  CHECK(cons.losses().overruns == 0);
+
+  // lap the consumer a few times
+  write(40);
+
+  std::uint64_t expected = 0;
+  std::optional<std::span<std::byte const>> r1;
+  while ((r1 = cons.read()).has_value()) {
+    // the messages we do get are in order, and add up with the ones we lost
+    CHECK(r1.value()[0] == static_cast<std::byte>(2 + cons.losses().messages + expected++));
+  }
+  CHECK(cons.losses().overruns == 1);
+  CHECK(cons.losses().messages > 0);
+  CHECK(cons.losses().bytes >= cons.losses().messages * 14);
+  CHECK(2 + cons.losses().messages + expected == 42);
+
+  // and it keeps going afterwards
+  write(1);
+  r1 = cons.read();
+  REQUIRE(r1.has_value());
+  if (r1.has_value()) {  // avoid unchecked optional warning
+    CHECK(r1.value()[0] == static_cast<std::byte>(42));
+  }
+  CHECK(cons.losses().overruns == 1);
+}
+
+TEST_CASE("spsc::var_msg::consumer receives messages larger than the batch reserve", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+  using Producer = producer<12, 64>;
+
+  std::string_view const name{ "spsc-var_msg-large" };
+
+  host<12> host{ name };
+  Producer prod{ name };
+  consumer<12> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // the largest message takes almost half the queue
+  static_assert(Producer::MaxMessageSize == (4096 - 2 * sizeof(std::uint32_t)) / 2 - sizeof(std::uint32_t));
+  auto w0 = prod.allocate_write(static_cast<std::uint32_t>(Producer::MaxMessageSize));
+  fill_incrementing(w0, 0);
+  prod.flush();
+  auto r0 = cons.read();
+  REQUIRE(r0.has_value());
+  if (r0.has_value()) {  // avoid unchecked optional warning
+    CHECK(r0.value().size() == Producer::MaxMessageSize);
+    CHECK(r0.value().back() == static_cast<std::byte>((Producer::MaxMessageSize - 1) & 0xFFU));
+  }
+
+  // a mix of small messages and large ones up to the largest, many times round the queue
+  for (std::uint32_t i = 0; i < 200; i++) {
+    auto const size = (i % 3 == 0) ? 1 + ((i * 997) % 2000) : 20;
+
+    auto w1 = prod.allocate_write(size);
+    fill_incrementing(w1, static_cast<int>(i));
+    prod.flush();
+
+    auto r1 = cons.read();
+    REQUIRE(r1.has_value());
+    if (r1.has_value()) {  // avoid unchecked optional warning
+      REQUIRE(r1.value().size() == size);
+      CHECK(r1.value().front() == static_cast<std::byte>(i));
+      CHECK(r1.value().back() == static_cast<std::byte>(i + size - 1));
+    }
+  }
+  CHECK(not cons.read().has_value());
+}
+
+TEST_CASE("spsc::var_msg::consumer receives large messages with backpressure", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+  using arquebus::flow_control;
+
+  std::string_view const name{ "spsc-var_msg-large-backpressure" };
+
+  host<10> host{ name, {}, flow_control::Backpressure };
+  producer<10, 40> prod{ name };
+  consumer<10> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // every size lands the next skip somewhere different, none of them may leave the producer waiting for ever
+  auto const largest = static_cast<std::uint32_t>(prod.max_message_size());
+  auto const size_of = [largest](int i) -> std::uint32_t {
+    return (i % 2 == 0) ? largest - static_cast<std::uint32_t>(i % 7) : 1 + static_cast<std::uint32_t>(i % 50);
+  };
+
+  std::jthread writer{ [&prod, &size_of] {
+    for (int i = 0; i < 1000; i++) {
+      auto w1 = prod.allocate_write(size_of(i));
+      fill_incrementing(w1, i);
+      prod.flush();
+    }
+  } };
+
+  arquebus::wait::yield strategy;
+  for (int i = 0; i < 1000; i++) {
+    auto r1 = cons.read_wait(strategy);
+    REQUIRE(r1.has_value());
+    if (r1.has_value()) {  // avoid unchecked optional warning
+      REQUIRE(r1.value().size() == size_of(i));
+      CHECK(r1.value().front() == static_cast<std::byte>(i));
+      CHECK(r1.value().back() == static_cast<std::byte>(i + static_cast<int>(size_of(i)) - 1));
+    }
+  }
+}
+
+TEST_CASE("spsc::var_msg::consumer can read all available messages in a batch", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  std::string_view const name{ "spsc-var_msg-for_each_available" };
+
+  // 2^7 = 128 bytes of queue
+  host<7> host{ name };
+  producer<7, 40> prod{ name };
+  consumer<7> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  int expected = 0;
+  auto const check_next = [&](std::span<std::byte const> message) {
+    CHECK(message.size() == 6);
+    CHECK(message[0] == static_cast<std::byte>(expected++));
+  };
+
+  // this will wrap several times
+  for (int lap = 0; lap < 10; ++lap) {
+    for (int i = 0; i < 4; ++i) {
+      fill_incrementing(prod.allocate_write(6), lap * 4 + i);
+    }
+    CHECK(cons.for_each_available(check_next) == 0);
+    prod.flush();
+
+    CHECK(cons.for_each_available(check_next, 1) == 1);
+    CHECK(cons.for_each_available(check_next) == 3);
+    CHECK(cons.for_each_available(check_next) == 0);
+  }
+  CHECK(expected == 40);
+}
+
+TEST_CASE("spsc::var_msg::consumer batch read throws on overrun", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  std::string_view const name{ "spsc-var_msg-for_each_available_overrun" };
+
+  host<6> host{ name };
+  producer<6, 20> prod{ name };
+  consumer<6> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // this will eventually overrun as we are writing twice as many messages as we are reading
+  REQUIRE_THROWS([&] {
+    for (int i = 0; i < 30; i++) {
+      static_cast<void>(prod.allocate_write(10));
+      static_cast<void>(prod.allocate_write(10));
+      prod.flush();
+      auto const count = cons.for_each_available([](std::span<std::byte const> message) { CHECK(message.size() == 10); }, 1);
+      CHECK(count == 1);
+    }
+  }());
+}
+
+TEST_CASE("spsc::var_msg::consumer sees the NUMA node chosen by the host", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  std::string_view const name{ "spsc-var_msg-numa_node" };
+
+  host<10> host{ name, { .numa = arquebus::numa_placement::Bind, .numa_node = 0 } };
+  consumer<10> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  cons.attach();
+
+  CHECK(cons.numa_node() == 0);
+}
+
+TEST_CASE("spsc::var_msg::consumer can receive messages over a memfd segment", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  std::string_view const name{ "spsc-var_msg-memfd" };
+  arquebus::mapping_options const options{ .transport = arquebus::segment_transport::MemFd };
+
+  // there is no named segment left over from a previous run, so no need to delete it
+  host<10> host{ name, options };
+  producer<10, 100> prod{ name, options };
+  consumer<10> cons{ name, options };
+
+  host.create();
+  prod.attach();
+  cons.attach();
+
+  auto w1 = prod.allocate_write(10);
+  fill_incrementing(w1, 0);
+  prod.flush();
+
+  auto r1 = cons.read();
+  REQUIRE(r1.has_value());
+  if (r1.has_value()) {  // avoid unchecked optional warning
+    CHECK(r1.value().size() == 10);
+    CHECK(r1.value()[9] == std::byte{ 9 });
+  }
+}
+
+TEST_CASE("spsc::var_msg::consumer has no eventfd by default", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  std::string_view const name{ "spsc-var_msg-no-eventfd" };
+
+  host<10> host{ name };
+  consumer<10> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  cons.attach();
+
+  CHECK(cons.native_handle() == -1);
+}
+
+TEST_CASE("spsc::var_msg::consumer does not arm without an eventfd", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+  using namespace arquebus::impl;
+
+  std::string_view const name{ "spsc-var_msg-no-eventfd-arm" };
+
+  host<10> host{ name };
+  consumer<10> cons{ name };
+  shared_memory_user<producer<10, 100>::QueueLayout> obs{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  cons.attach();
+  obs.attach();
+
+  // there is nothing for the caller to wait on, even with no messages to read
+  REQUIRE(cons.native_handle() == -1);
+  CHECK(not cons.read().has_value());
+  CHECK(not cons.arm_notification());
+  CHECK(obs.mapping()->wakeup.armed.load() == 0);
+}
+
+TEST_CASE("spsc::var_msg::consumer eventfd is signalled by a flush once armed", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+  using arquebus::flow_control;
+  using arquebus::notification;
+
+  std::string_view const name{ "spsc-var_msg-eventfd" };
+
+  host<10> host{ name, {}, flow_control::Overwrite, notification::EventFd };
+  producer<10, 100> prod{ name };
+  consumer<10> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  REQUIRE(cons.native_handle() >= 0);
+  CHECK(not is_readable(cons.native_handle()));
+
+  // not armed, so the producer does not signal it
+  auto w1 = prod.allocate_write(10);
+  fill_incrementing(w1, 0);
+  prod.flush();
+  CHECK(not is_readable(cons.native_handle()));
+
+  // there is a message to read, so it will not arm
+  CHECK(not cons.arm_notification());
+  REQUIRE(cons.read().has_value());
+  CHECK(not cons.read().has_value());
+
+  // once armed the next flush signals it, and only that one
+  CHECK(cons.arm_notification());
+  CHECK(not is_readable(cons.native_handle()));
+  auto w2 = prod.allocate_write(10);
+  fill_incrementing(w2, 1);
+  prod.flush();
+  CHECK(is_readable(cons.native_handle()));
+
+  auto r2 = cons.read();
+  REQUIRE(r2.has_value());
+  if (r2.has_value()) {  // avoid unchecked optional warning
+    CHECK(r2.value()[0] == std::byte{ 1 });
+  }
+
+  // arming again clears it
+  CHECK(cons.arm_notification());
+  CHECK(not is_readable(cons.native_handle()));
+}
+
+TEST_CASE("spsc::var_msg::consumer eventfd wakes a poll over a memfd segment", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+  using arquebus::flow_control;
+  using arquebus::notification;
+
+  std::string_view const name{ "spsc-var_msg-eventfd-memfd" };
+  arquebus::mapping_options const options{ .transport = arquebus::segment_transport::MemFd };
+
+  host<10> host{ name, options, flow_control::Overwrite, notification::EventFd };
+  producer<10, 100> prod{ name, options };
+  consumer<10> cons{ name, options };
+
+  host.create();
+  prod.attach();
+  cons.attach();
+
+  REQUIRE(cons.arm_notification());
+
+  std::jthread writer{ [&prod] {
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+    auto w1 = prod.allocate_write(10);
+    fill_incrementing(w1, 0);
+    prod.flush();
+  } };
+
+  pollfd poll{ .fd = cons.native_handle(), .events = POLLIN, .revents = 0 };
+  REQUIRE(::poll(&poll, 1, 5'000) == 1);
+
+  auto r1 = cons.read();
+  REQUIRE(r1.has_value());
+  if (r1.has_value()) {  // avoid unchecked optional warning
+    CHECK(r1.value()[9] == std::byte{ 9 });
+  }
+}
+
+TEST_CASE("spsc::var_msg::consumer can wait for messages", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::wait;
+
+  test_read_wait("spsc-var_msg-wait-busy_spin", busy_spin{});
+  test_read_wait("spsc-var_msg-wait-backoff_spin", backoff_spin{});
+  test_read_wait("spsc-var_msg-wait-yield", yield{});
+  test_read_wait("spsc-var_msg-wait-spin_then_park", spin_then_park{ 100 });
+  // long enough that a lost wake up would show as a very slow test
+  test_read_wait("spsc-var_msg-wait-park", spin_then_park{ 0, std::chrono::seconds{ 1 } });
+}
+
+TEST_CASE("spsc::var_msg::consumer stops waiting when asked", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  std::string_view const name{ "spsc-var_msg-wait-stop" };
+
+  host<10> host{ name };
+  consumer<10> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  cons.attach();
+
+  std::stop_source stop;
+  std::jthread stopper{ [&stop] {
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 5 });
+    stop.request_stop();
+  } };
+
+  arquebus::wait::spin_then_park strategy{ 0, std::chrono::milliseconds{ 1 } };
+  CHECK(not cons.read_wait(strategy, stop.get_token()).has_value());
+}
+
 // NOLINTEND(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
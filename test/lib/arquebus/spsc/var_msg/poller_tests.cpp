@@ -0,0 +1,188 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "arquebus/ready_set.hpp"
+#include "arquebus/spsc/var_msg/host.hpp"
+#include "arquebus/spsc/var_msg/poller.hpp"
+#include "arquebus/spsc/var_msg/producer.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// NOLINTBEGIN(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
+
+namespace {
+
+  using namespace arquebus::spsc::var_msg;
+
+  // a queue, and its producer, for the poller to drain
+  struct test_queue
+  {
+    explicit test_queue(std::string_view name)
+      : queueHost{ name }
+      , prod{ name }
+    {
+      queueHost.create(danger_delete_existing_shared_memory_segment_tag{});
+      prod.attach();
+    }
+
+    void write(int value)
+    {
+      auto w1 = prod.allocate_write(4);
+      w1[0] = static_cast<std::byte>(value);
+      prod.flush();
+    }
+
+    host<10> queueHost;
+    producer<10, 100> prod;
+  };
+
+  auto make_queues(std::string_view prefix, std::size_t count) -> std::vector<std::unique_ptr<test_queue>>
+  {
+    std::vector<std::unique_ptr<test_queue>> queues;
+    for (std::size_t i = 0; i < count; i++) {
+      queues.push_back(std::make_unique<test_queue>(std::string{ prefix } + std::to_string(i)));
+    }
+    return queues;
+  }
+
+  // the slot and first byte of each message read
+  using polled = std::vector<std::pair<std::size_t, int>>;
+
+  template<typename Poller>
+  auto poll_once(Poller &poller, std::size_t maxMessages = 1'000) -> polled
+  {
+    polled messages;
+    poller.poll(
+      [&messages](std::size_t slot, std::span<std::byte const> message) {
+        messages.emplace_back(slot, static_cast<int>(message[0]));
+      },
+      maxMessages
+    );
+    return messages;
+  }
+
+}  // namespace
+
+TEST_CASE("spsc::var_msg::poller reads one message from each queue in turn", "[arquebus][spsc][poller]")
+{
+  auto queues = make_queues("spsc-var_msg-poller-rr-", 3);
+  poller<10> poller{ arquebus::fairness::RoundRobin };
+  for (std::size_t i = 0; i < queues.size(); i++) {
+    CHECK(poller.add("spsc-var_msg-poller-rr-" + std::to_string(i)) == i);
+  }
+
+  queues[0]->write(1);
+  queues[0]->write(2);
+  queues[2]->write(3);
+
+  CHECK(poll_once(poller) == polled{ { 0, 1 }, { 2, 3 } });
+  CHECK(poll_once(poller) == polled{ { 0, 2 } });
+  CHECK(poll_once(poller).empty());
+}
+
+TEST_CASE("spsc::var_msg::poller carries on from where the last sweep stopped", "[arquebus][spsc][poller]")
+{
+  auto queues = make_queues("spsc-var_msg-poller-resume-", 3);
+  poller<10> poller{ arquebus::fairness::RoundRobin };
+  for (std::size_t i = 0; i < queues.size(); i++) {
+    poller.add("spsc-var_msg-poller-resume-" + std::to_string(i));
+  }
+
+  for (int i = 0; i < 3; i++) {
+    queues[0]->write(i);
+    queues[1]->write(10 + i);
+    queues[2]->write(20 + i);
+  }
+
+  CHECK(poll_once(poller, 2) == polled{ { 0, 0 }, { 1, 10 } });
+  CHECK(poll_once(poller, 2) == polled{ { 2, 20 }, { 0, 1 } });
+  CHECK(poll_once(poller) == polled{ { 1, 11 }, { 2, 21 }, { 0, 2 } });
+}
+
+TEST_CASE("spsc::var_msg::poller reads up to each queue's weight", "[arquebus][spsc][poller]")
+{
+  auto queues = make_queues("spsc-var_msg-poller-weighted-", 2);
+  poller<10> poller{ arquebus::fairness::Weighted };
+  poller.add("spsc-var_msg-poller-weighted-0", {}, arquebus::overrun_policy::Throw, 3);
+  poller.add("spsc-var_msg-poller-weighted-1");
+
+  for (int i = 0; i < 4; i++) {
+    queues[0]->write(i);
+    queues[1]->write(10 + i);
+  }
+
+  CHECK(poll_once(poller) == polled{ { 0, 0 }, { 0, 1 }, { 0, 2 }, { 1, 10 } });
+  CHECK(poll_once(poller) == polled{ { 0, 3 }, { 1, 11 } });
+}
+
+TEST_CASE("spsc::var_msg::poller reads the first queue added first", "[arquebus][spsc][poller]")
+{
+  auto queues = make_queues("spsc-var_msg-poller-priority-", 2);
+  poller<10> poller{ arquebus::fairness::Priority };
+  poller.add("spsc-var_msg-poller-priority-0");
+  poller.add("spsc-var_msg-poller-priority-1");
+
+  queues[1]->write(10);
+  queues[0]->write(0);
+  queues[1]->write(11);
+  queues[0]->write(1);
+
+  CHECK(poll_once(poller, 3) == polled{ { 0, 0 }, { 0, 1 }, { 1, 10 } });
+
+  // a sweep always starts from the first queue
+  queues[0]->write(2);
+  CHECK(poll_once(poller) == polled{ { 0, 2 }, { 1, 11 } });
+}
+
+TEST_CASE("spsc::var_msg::poller only reads queues marked in the ready set", "[arquebus][spsc][poller]")
+{
+  std::string_view const readySetName{ "spsc-var_msg-poller-ready-set" };
+  arquebus::ready_set_host<> readySetHost{ readySetName };
+  readySetHost.create(danger_delete_existing_shared_memory_segment_tag{});
+  arquebus::ready_set<> readySet{ readySetName };
+  readySet.attach();
+
+  auto queues = make_queues("spsc-var_msg-poller-ready-", 2);
+  poller<10> poller{ readySet };
+  auto const slot0 = poller.add("spsc-var_msg-poller-ready-0");
+  auto const slot1 = poller.add("spsc-var_msg-poller-ready-1");
+
+  // only the first producer marks the ready set
+  queues[0]->prod.signal_ready(readySet, slot0);
+
+  // every queue is read once, they may have had messages before they were added
+  queues[1]->write(10);
+  CHECK(poll_once(poller) == polled{ { slot1, 10 } });
+  CHECK(poll_once(poller).empty());
+
+  // and then only when it is marked
+  queues[1]->write(11);
+  CHECK(poll_once(poller).empty());
+
+  queues[0]->write(0);
+  queues[0]->write(1);
+  CHECK(poll_once(poller) == polled{ { slot0, 0 } });
+  // still active, it was not drained
+  CHECK(poll_once(poller) == polled{ { slot0, 1 } });
+  CHECK(poll_once(poller).empty());
+}
+
+TEST_CASE("spsc::var_msg::producer rejects a ready set slot out of range", "[arquebus][spsc][poller]")
+{
+  std::string_view const readySetName{ "spsc-var_msg-poller-ready-set-range" };
+  arquebus::ready_set_host<> readySetHost{ readySetName };
+  readySetHost.create(danger_delete_existing_shared_memory_segment_tag{});
+  arquebus::ready_set<> readySet{ readySetName };
+  readySet.attach();
+
+  test_queue queue{ "spsc-var_msg-poller-ready-set-range-queue" };
+  CHECK_THROWS_AS(queue.prod.signal_ready(readySet, arquebus::ready_set<>::MaxQueues), std::logic_error);
+}
+
+// NOLINTEND(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
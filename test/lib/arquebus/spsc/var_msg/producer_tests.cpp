@@ -2,17 +2,23 @@
 #include <catch2/matchers/catch_matchers.hpp>
 #include <catch2/matchers/catch_matchers_range_equals.hpp>
 
+#include "arquebus/flush_policy.hpp"
 #include "arquebus/impl/shared_memory_helper.hpp"
+#include "arquebus/spsc/var_msg/consumer.hpp"
 #include "arquebus/spsc/var_msg/host.hpp"
 #include "arquebus/spsc/var_msg/producer.hpp"
+#include "arquebus/wait_strategy.hpp"
 
 #include <algorithm>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <optional>
 #include <span>
+#include <stdexcept>
 #include <string_view>
+#include <thread>
 
 // NOLINTBEGIN(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
 
@@ -114,7 +120,10 @@ namespace {
 
     CHECK(pQueue->write_index.load() >= pQueue->read_index.load());
 
-    auto w1 = prod.allocate_write(20);
+    // two of these leave less than the largest message in the queue
+    constexpr auto Small = static_cast<SizeType>(std::min<std::uint64_t>(20, ProducerType::MaxMessageSize));
+
+    auto w1 = prod.allocate_write(Small);
     prod.flush();
     CHECK(pQueue->write_index.load() >= pQueue->read_index.load());
 
@@ -122,14 +131,15 @@ namespace {
     std::memcpy(&s, &data[0], sizeof(SizeType));
     REQUIRE(s == w1.size());
 
-    [[maybe_unused]] auto w2 = prod.allocate_write(20);
+    [[maybe_unused]] auto w2 = prod.allocate_write(Small);
     prod.flush();
     CHECK(pQueue->write_index.load() >= pQueue->read_index.load());
 
     std::memcpy(&s, &data[sizeof(SizeType) + w1.size()], sizeof(SizeType));
-    REQUIRE(s == 20);
+    REQUIRE(s == Small);
 
-    [[maybe_unused]] auto w3 = prod.allocate_write(35);
+    // the largest message does not fit in what is left, whatever the size type
+    [[maybe_unused]] auto w3 = prod.allocate_write(static_cast<SizeType>(ProducerType::MaxMessageSize));
     prod.flush();
     CHECK(pQueue->write_index.load() >= pQueue->read_index.load());
 
@@ -139,11 +149,18 @@ namespace {
     std::memcpy(&s, &data[sizeof(SizeType) + w1.size() + sizeof(SizeType) + w2.size()], sizeof(SizeType));
     REQUIRE(s == 0);
 
-    // and now offset 0 should have a size of 20 as the second message should have wrapped
+    // and now offset 0 should have the size of the third message as it should have wrapped
     std::memcpy(&s, &data[0], sizeof(SizeType));
     REQUIRE(s == w3.size());
   }
 
+  // read every available message, returning how many there were
+  template<typename Consumer>
+  auto count_available(Consumer &cons) -> std::size_t
+  {
+    return cons.for_each_available([](std::span<std::byte const> /*message*/) {});
+  }
+
 }  // namespace
 
 TEST_CASE("spsc::var_msg::producer can record messages uint8_t size", "[arquebus][spsc][producer]")
@@ -183,8 +200,286 @@ TEST_CASE("spsc::var_msg::producer wraps queue uint32_t size", "[arquebus][spsc]
 
 TEST_CASE("spsc::var_msg::producer wraps queue uint64_t size", "[arquebus][spsc][producer]")
 {
-  // note that this case hits the wrap exactly at the boundary case
+  // note that the largest message is smaller than the others here, so the first two are capped to it
   test_wrap_queue<std::uint64_t>("spsc-var_msg-wrap_test-64");
 }
 
+TEST_CASE("spsc::var_msg::producer never allocates across the end of the queue", "[arquebus][spsc][producer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  std::string_view const name{ "spsc-var_msg-reserve_end" };
+
+  // 2^6 = 64 bytes of queue, a reservation of 20 bytes runs past the end of it on most laps
+  host<6> host{ name };
+  producer<6, 20> prod{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+
+  // the first message follows the first size, at the start of the queue
+  auto const first = prod.allocate_write(1);
+  prod.flush();
+  auto const *const queueStart = first.data() - sizeof(std::uint32_t);
+  auto const *const queueEnd = queueStart + 64;
+
+  for (std::uint32_t i = 0; i < 200; ++i) {
+    auto const message = prod.allocate_write((i % 12) + 1);
+    CHECK(message.data() >= queueStart + sizeof(std::uint32_t));
+    CHECK(message.data() + message.size() <= queueEnd);
+    prod.flush();
+  }
+}
+
+TEST_CASE("spsc::var_msg::producer rejects a message larger than half the queue", "[arquebus][spsc][producer]")
+{
+  using namespace arquebus::spsc::var_msg;
+  using namespace arquebus::impl;
+  using Producer = producer<10, 100>;
+
+  std::string_view const name{ "spsc-var_msg-oversize" };
+
+  host<10> host{ name };
+  Producer prod{ name };
+  shared_memory_user<Producer::QueueLayout> obs{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  obs.attach();
+
+  // half the 1024 byte queue after the first size, less the size before it
+  static_assert(Producer::MaxMessageSize == (1024 - 2 * sizeof(std::uint32_t)) / 2 - sizeof(std::uint32_t));
+  static_assert(Producer::max_message_size() == Producer::MaxMessageSize);
+
+  auto w1 = prod.allocate_write(10);
+  fill_incrementing(w1, 1);
+  CHECK_THROWS_AS(prod.allocate_write(static_cast<std::uint32_t>(Producer::MaxMessageSize + 1)), std::length_error);
+  CHECK_THROWS_AS(prod.try_allocate_write(100'000), std::length_error);
+
+  // nothing was changed by the attempts, and the largest message follows the pending one rather than wrapping
+  // over it
+  auto w2 = prod.allocate_write(static_cast<std::uint32_t>(Producer::MaxMessageSize));
+  CHECK(w2.size() == Producer::MaxMessageSize);
+  CHECK(w2.data() == w1.data() + w1.size() + sizeof(std::uint32_t));
+  std::ranges::fill(w2, std::byte{ 0xFF });
+  for (std::size_t i = 0; i < w1.size(); ++i) {
+    CHECK(w1[i] == static_cast<std::byte>(i + 1));
+  }
+  prod.flush();
+
+  // the next largest has to skip to the start of the queue, but ends before the skip marker it leaves
+  auto const markerOffset = 2 * sizeof(std::uint32_t) + w1.size() + w2.size();
+  auto w3 = prod.allocate_write(static_cast<std::uint32_t>(Producer::MaxMessageSize));
+  CHECK(w3.data() == w1.data());
+  std::ranges::fill(w3, std::byte{ 0xFF });
+  prod.flush();
+
+  std::uint32_t marker{ 1 };
+  std::memcpy(&marker, &obs.mapping()->data[markerOffset], sizeof(marker));
+  CHECK(marker == 0);
+  CHECK(w3.data() + w3.size() + sizeof(std::uint32_t) <= w2.data() + w2.size());
+}
+
+TEST_CASE("spsc::var_msg::producer has the same message limit with backpressure", "[arquebus][spsc][producer]")
+{
+  using namespace arquebus::spsc::var_msg;
+  using arquebus::flow_control;
+  using Producer = producer<10, 100>;
+
+  std::string_view const name{ "spsc-var_msg-oversize-backpressure" };
+
+  host<10> host{ name, {}, flow_control::Backpressure };
+  Producer prod{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+
+  auto const largest = static_cast<std::uint32_t>(Producer::MaxMessageSize);
+  CHECK_THROWS_AS(prod.allocate_write(largest + 1), std::length_error);
+  CHECK(prod.allocate_write(largest).size() == largest);
+}
+
+TEST_CASE("spsc::var_msg::producer publishes every N messages", "[arquebus][spsc][producer]")
+{
+  using namespace arquebus::spsc::var_msg;
+  using arquebus::flush_policy;
+
+  std::string_view const name{ "spsc-var_msg-flush-messages" };
+  host<10> host{ name };
+  producer<10, 100> prod{ name, {}, flush_policy::every_messages(3) };
+  consumer<10> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  for (int i = 0; i < 2; i++) {
+    static_cast<void>(prod.allocate_write(10));
+    prod.flush();
+  }
+  CHECK(count_available(cons) == 0);
+  static_cast<void>(prod.allocate_write(10));
+  prod.flush();
+  CHECK(count_available(cons) == 3);
+}
+
+TEST_CASE("spsc::var_msg::producer publishes every N bytes", "[arquebus][spsc][producer]")
+{
+  using namespace arquebus::spsc::var_msg;
+  using arquebus::flush_policy;
+
+  std::string_view const name{ "spsc-var_msg-flush-bytes" };
+  host<10> host{ name };
+  producer<10, 100> prod{ name, {}, flush_policy::every_bytes(50) };
+  consumer<10> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // 14 bytes of queue each
+  for (int i = 0; i < 3; i++) {
+    static_cast<void>(prod.allocate_write(10));
+    prod.flush();
+  }
+  CHECK(count_available(cons) == 0);
+  static_cast<void>(prod.allocate_write(10));
+  prod.flush();
+  CHECK(count_available(cons) == 4);
+}
+
+TEST_CASE("spsc::var_msg::producer holds messages for a cycle budget", "[arquebus][spsc][producer]")
+{
+  using namespace arquebus::spsc::var_msg;
+  using arquebus::flush_policy;
+
+  std::string_view const name{ "spsc-var_msg-flush-cycles" };
+  host<10> host{ name };
+  producer<10, 100> prod{ name, {}, flush_policy::cycle_budget(std::uint64_t{ 1 } << 62U) };
+  consumer<10> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  static_cast<void>(prod.allocate_write(10));
+  prod.flush();
+  CHECK(count_available(cons) == 0);
+  prod.flush_now();
+  CHECK(count_available(cons) == 1);
+}
+
+TEST_CASE("spsc::var_msg::producer publishes adaptively", "[arquebus][spsc][producer]")
+{
+  using namespace arquebus::spsc::var_msg;
+  using arquebus::flush_policy;
+
+  std::string_view const name{ "spsc-var_msg-flush-adaptive" };
+  host<10> host{ name };
+  producer<10, 100> prod{ name, {}, flush_policy::adaptive(4) };
+  consumer<10> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // the consumer is waiting, so the first is published at once
+  static_cast<void>(prod.allocate_write(10));
+  prod.flush();
+
+  // until it reads that, the producer holds back up to 4
+  for (int i = 0; i < 3; i++) {
+    static_cast<void>(prod.allocate_write(10));
+    prod.flush();
+  }
+  CHECK(count_available(cons) == 1);
+  static_cast<void>(prod.allocate_write(10));
+  prod.flush();
+  CHECK(count_available(cons) == 4);
+
+  // it has caught up, so is waiting again
+  CHECK(count_available(cons) == 0);
+  static_cast<void>(prod.allocate_write(10));
+  prod.flush();
+  CHECK(count_available(cons) == 1);
+}
+
+TEST_CASE("spsc::var_msg::producer does not overwrite unread messages with backpressure", "[arquebus][spsc][producer]")
+{
+  using namespace arquebus::spsc::var_msg;
+  using arquebus::flow_control;
+
+  std::string_view const name{ "spsc-var_msg-backpressure" };
+
+  // 2^7 = 128 bytes of queue
+  host<7> host{ name, {}, flow_control::Backpressure };
+  producer<7, 40> prod{ name };
+  consumer<7> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // fill the queue, without the consumer reading anything
+  int written = 0;
+  while (true) {
+    auto w1 = prod.try_allocate_write(10);
+    if (w1.empty()) {
+      break;
+    }
+    fill_incrementing(w1, written++);
+    prod.flush();
+  }
+  REQUIRE(written > 0);
+  CHECK(written < 128 / 14);
+
+  // nothing was overwritten, the consumer gets every message
+  for (int i = 0; i < written; i++) {
+    auto r1 = cons.read();
+    REQUIRE(r1.has_value());
+    if (r1.has_value()) {  // avoid unchecked optional warning
+      CHECK(r1.value()[0] == static_cast<std::byte>(i));
+    }
+  }
+  CHECK(not cons.read().has_value());
+
+  // and once it has caught up the producer has space again
+  CHECK(not prod.try_allocate_write(10).empty());
+}
+
+TEST_CASE("spsc::var_msg::producer waits for the consumer with backpressure", "[arquebus][spsc][producer]")
+{
+  using namespace arquebus::spsc::var_msg;
+  using arquebus::flow_control;
+
+  std::string_view const name{ "spsc-var_msg-backpressure-wait" };
+
+  host<7> host{ name, {}, flow_control::Backpressure };
+  producer<7, 40> prod{ name };
+  consumer<7> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  // many laps of the queue, faster than the consumer reads them
+  std::jthread writer{ [&prod] {
+    for (int i = 0; i < 1000; i++) {
+      auto w1 = prod.allocate_write(10);
+      fill_incrementing(w1, i);
+      prod.flush();
+    }
+  } };
+
+  arquebus::wait::yield strategy;
+  for (int i = 0; i < 1000; i++) {
+    auto r1 = cons.read_wait(strategy);
+    REQUIRE(r1.has_value());
+    if (r1.has_value()) {  // avoid unchecked optional warning
+      CHECK(r1.value()[0] == static_cast<std::byte>(i));
+      CHECK(r1.value()[9] == static_cast<std::byte>(i + 9));
+    }
+  }
+}
+
 // NOLINTEND(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
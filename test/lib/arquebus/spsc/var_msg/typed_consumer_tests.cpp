@@ -0,0 +1,177 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "arquebus/spsc/var_msg/host.hpp"
+#include "arquebus/spsc/var_msg/typed_consumer.hpp"
+#include "arquebus/spsc/var_msg/typed_host.hpp"
+#include "arquebus/spsc/var_msg/typed_producer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+// NOLINTBEGIN(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)
+
+namespace {
+
+  struct quote
+  {
+    std::uint32_t instrument;
+    double bid;
+    double ask;
+  };
+
+  struct trade
+  {
+    std::uint32_t instrument;
+    std::int64_t quantity;
+  };
+
+  struct heartbeat
+  {
+    std::uint8_t sequence;
+  };
+
+  using catalog = arquebus::impl::message_catalog<quote, trade, heartbeat>;
+
+  static_assert(catalog::IdOf<quote> == 0);
+  static_assert(catalog::IdOf<heartbeat> == 2);
+  static_assert(std::is_same_v<catalog::TypeId, std::uint8_t>);
+  static_assert(catalog::Alignment == alignof(double));
+  static_assert(catalog::MessageOffset == alignof(double));
+  static_assert(catalog::Hash != 0);
+  static_assert(catalog::Hash != arquebus::impl::message_catalog<trade, quote, heartbeat>::Hash);
+  static_assert(catalog::Hash != arquebus::impl::message_catalog<quote, trade>::Hash);
+
+  // a declared catalog_name replaces the compiler's spelling of the type, so a renamed type hashes the same
+  struct order_v1
+  {
+    static constexpr std::string_view catalog_name{ "order/1" };
+    std::uint32_t instrument;
+    std::int64_t quantity;
+  };
+
+  struct renamed_order_v1
+  {
+    static constexpr std::string_view catalog_name{ "order/1" };
+    std::uint32_t instrument;
+    std::int64_t quantity;
+  };
+
+  struct order_v2
+  {
+    static constexpr std::string_view catalog_name{ "order/2" };
+    std::int64_t quantity;
+    std::uint32_t instrument;
+  };
+
+  static_assert(arquebus::impl::catalog_name<order_v1>() == "order/1");
+  static_assert(
+    arquebus::impl::message_catalog<order_v1>::Hash == arquebus::impl::message_catalog<renamed_order_v1>::Hash
+  );
+  static_assert(arquebus::impl::message_catalog<order_v1>::Hash != arquebus::impl::message_catalog<order_v2>::Hash);
+
+}  // namespace
+
+TEST_CASE("spsc::var_msg::typed_consumer visits each message as its type", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  std::string_view const name{ "spsc-var_msg-typed" };
+
+  typed_host<10, quote, trade, heartbeat> host{ name };
+  typed_producer<10, 100, quote, trade, heartbeat> prod{ name };
+  typed_consumer<10, quote, trade, heartbeat> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  prod.write(quote{ .instrument = 1, .bid = 99.5, .ask = 100.5 });
+  auto &t = prod.allocate_write<trade>();
+  t.instrument = 2;
+  t.quantity = -300;
+  prod.write(heartbeat{ .sequence = 7 });
+  prod.flush();
+
+  std::vector<int> seen;
+  auto visitor = arquebus::overloaded{
+    [&seen](quote const &q) {
+      CHECK(q.instrument == 1);
+      CHECK(q.ask == 100.5);
+      seen.push_back(0);
+    },
+    [&seen](trade const &tr) {
+      CHECK(tr.instrument == 2);
+      CHECK(tr.quantity == -300);
+      seen.push_back(1);
+    },
+    [&seen](heartbeat const &h) {
+      CHECK(h.sequence == 7);
+      seen.push_back(2);
+    },
+  };
+
+  CHECK(cons.read(visitor));
+  CHECK(cons.for_each_available(visitor) == 2);
+  CHECK(not cons.read(visitor));
+  CHECK(seen == std::vector{ 0, 1, 2 });
+}
+
+TEST_CASE("spsc::var_msg::typed_consumer accepts a generic visitor", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  std::string_view const name{ "spsc-var_msg-typed-generic" };
+
+  typed_host<10, trade, heartbeat> host{ name };
+  typed_producer<10, 100, trade, heartbeat> prod{ name };
+  typed_consumer<10, trade, heartbeat> cons{ name };
+
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+  prod.attach();
+  cons.attach();
+
+  for (std::uint8_t i = 0; i < 10; i++) {
+    prod.write(heartbeat{ .sequence = i });
+  }
+  prod.flush();
+
+  std::size_t bytes = 0;
+  CHECK(cons.for_each_available([&bytes](auto const &message) { bytes += sizeof(message); }) == 10);
+  CHECK(bytes == 10 * sizeof(heartbeat));
+}
+
+TEST_CASE("spsc::var_msg::typed_consumer rejects a queue with other message types", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  std::string_view const name{ "spsc-var_msg-typed-mismatch" };
+
+  typed_host<10, quote, trade> host{ name };
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+
+  // the same types in another order
+  typed_consumer<10, trade, quote> cons{ name };
+  CHECK_THROWS_AS(cons.attach(), std::logic_error);
+  typed_producer<10, 100, trade, quote> prod{ name };
+  CHECK_THROWS_AS(prod.attach(), std::logic_error);
+}
+
+TEST_CASE("spsc::var_msg::typed_consumer rejects an untyped queue", "[arquebus][spsc][consumer]")
+{
+  using namespace arquebus::spsc::var_msg;
+
+  std::string_view const name{ "spsc-var_msg-typed-untyped" };
+
+  // the payload alignment matches, so only the catalog differs
+  host<10, std::uint32_t, std::hardware_destructive_interference_size, alignof(double)> host{ name };
+  host.create(danger_delete_existing_shared_memory_segment_tag{});
+
+  typed_consumer<10, quote, trade> cons{ name };
+  CHECK_THROWS_AS(cons.attach(), std::logic_error);
+}
+
+// NOLINTEND(*-magic-numbers, *-identifier-length, *-pointer-arithmetic, *-unused-variable)